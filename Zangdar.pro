@@ -26,6 +26,9 @@ DEFINES += SYZYGY=\\\"/mnt/Datas/Echecs/Syzygy\\\"
 # DEFINES += DEBUG_LOG
 # DEFINES += DEBUG_TIME
 
+#------------------------------------------------------
+# DEFINES += USE_TT_KEY16
+
 #------------------------------------------------------
 # https://gcc.gnu.org/onlinedocs/gcc/x86-Options.html
 
@@ -221,10 +224,12 @@ HEADERS += \
     src/Cuckoo.h \
     src/DataGen.h \
     src/History.h \
+    src/Layers.h \
     src/Move.h \
     src/MoveList.h \
     src/MovePicker.h \
     src/NNUE.h \
+    src/Numa.h \
     src/Search.h \
     src/SearchInfo.h \
     src/ThreadPool.h \
@@ -232,6 +237,7 @@ HEADERS += \
     src/TranspositionTable.h \
     src/Tunable.h \
     src/Uci.h \
+    src/Watchdog.h \
     src/bench.h \
     src/bitmask.h \
     src/defines.h \
@@ -251,14 +257,17 @@ SOURCES += \
     src/Cuckoo.cpp \
     src/DataGen.cpp \
     src/History.cpp \
+    src/Layers.cpp \
     src/MovePicker.cpp \
     src/NNUE.cpp \
+    src/Numa.cpp \
     src/Search.cpp \
     src/ThreadPool.cpp \
     src/Timer.cpp \
     src/TranspositionTable.cpp \
     src/Tunable.cpp \
     src/Uci.cpp \
+    src/Watchdog.cpp \
     src/attackers.cpp \
     src/fen.cpp \
     src/legal_moves.cpp \
@@ -1,10 +1,14 @@
 #include "Attacks.h"
 #include "Bitboard.h"
+#include "Cpu.h"
 
 namespace Attacks {
 
-Bitboard ROOK_ATTACKS  [N_SQUARES][4096]{};
-Bitboard BISHOP_ATTACKS[N_SQUARES][ 512]{};
+alignas(64) Bitboard SLIDER_ATTACKS[BISHOP_TABLE_SIZE + ROOK_TABLE_SIZE]{};
+
+#if defined USE_DISPATCH
+bool use_pext = false;
+#endif
 
 
 //======================================================
@@ -82,20 +86,14 @@ void init_bishop_attacks()
 {
     for (SQUARE sq = A1; sq < N_SQUARES; ++sq)
     {
-        Bitboard mask = bishop_masks[sq];
-        int bits      = bishop_relevant_bits[sq];
-        int indicies  = (1 << bits);
+        const Magic& m = BISHOP_MAGICS[sq];
+        int bits       = bishop_relevant_bits[sq];
+        int indicies   = (1 << bits);
 
         for (int index = 0; index < indicies; index++)
         {
-            Bitboard occupancy = set_occupancy(index, bits, mask);
-
-#ifndef USE_PEXT
-            int idx                 = (occupancy * bishop_magics[sq]) >> (64 - bits);
-            BISHOP_ATTACKS[sq][idx] = bishop_attacks_on_the_fly(sq, occupancy);
-#else
-            BISHOP_ATTACKS[sq][_pext_u64(occupancy, mask)] = bishop_attacks_on_the_fly(sq, occupancy);
-#endif
+            Bitboard occupancy = set_occupancy(index, bits, m.mask);
+            SLIDER_ATTACKS[magic_index(m, occupancy)] = bishop_attacks_on_the_fly(sq, occupancy);
         }
     }
 }
@@ -150,20 +148,14 @@ void init_rook_attacks()
 {
     for (SQUARE sq = A1; sq < N_SQUARES; ++sq)
     {
-        Bitboard mask = rook_masks[sq];
-        int bits      = rook_relevant_bits[sq];
-        int indicies  = (1 << bits);
+        const Magic& m = ROOK_MAGICS[sq];
+        int bits       = rook_relevant_bits[sq];
+        int indicies   = (1 << bits);
 
         for (int index = 0; index < indicies; index++)
         {
-            Bitboard occupancy = set_occupancy(index, bits, mask);
-
-#ifndef USE_PEXT
-            int idx               = (occupancy * rook_magics[sq]) >> (64 - bits);
-            ROOK_ATTACKS[sq][idx] = rook_attacks_on_the_fly(sq, occupancy);
-#else
-            ROOK_ATTACKS[sq][_pext_u64(occupancy, mask)]   = rook_attacks_on_the_fly(sq, occupancy);
-#endif
+            Bitboard occupancy = set_occupancy(index, bits, m.mask);
+            SLIDER_ATTACKS[magic_index(m, occupancy)] = rook_attacks_on_the_fly(sq, occupancy);
         }
     }
 }
@@ -173,6 +165,9 @@ void init_rook_attacks()
 //------------------------------------------------
 void init_masks()
 {
+#if defined USE_DISPATCH
+    use_pext = Cpu::use_pext();
+#endif
     init_bishop_attacks();
     init_rook_attacks();
 }
@@ -2,6 +2,7 @@
 #define ATTACKS_H
 
 #include "bitmask.h"
+#include <array>
 #include <cassert>
 #if defined USE_PEXT
 #include "immintrin.h"
@@ -221,11 +222,100 @@ constexpr U64 rook_magics[64] {
 };
 
 
-// table d'attaques du fou [case][occupancies]
-extern Bitboard BISHOP_ATTACKS[64][512];
+//  Tables d'attaques des pièces glissantes : "fancy magics"
+//
+//  Les attaques des fous et des tours sont rangées dans une seule
+//  table compacte. Chaque case n'y occupe que 2^relevant_bits entrées,
+//  à partir de son offset : 5248 entrées pour les fous, 102400 pour
+//  les tours, soit 841 Ko au lieu de 2.3 Mo avec des tables de taille
+//  fixe [64][512] et [64][4096]. Les index PEXT et magic sont tous
+//  deux inférieurs à 2^relevant_bits : les 2 méthodes partagent la
+//  même table (seul le remplissage diffère).
+
+//  Description d'une case pour une pièce glissante ; tout ce qu'il
+//  faut pour le calcul de l'index tient dans une ligne de cache
+struct Magic {
+    Bitboard mask;      // cases pertinentes (hors bord)
+    U64      magic;     // nombre magique
+    U32      offset;    // début des attaques de la case dans SLIDER_ATTACKS
+    U32      shift;     // 64 - relevant_bits
+};
+
+//! \brief  Nombre d'entrées de la table pour l'ensemble des cases
+constexpr U32 table_size(const int (&relevant_bits)[64])
+{
+    U32 size = 0;
+    for (int sq = 0; sq < 64; sq++)
+        size += 1U << relevant_bits[sq];
+    return size;
+}
+
+constexpr U32 BISHOP_TABLE_SIZE = table_size(bishop_relevant_bits);
+constexpr U32 ROOK_TABLE_SIZE   = table_size(rook_relevant_bits);
+static_assert(BISHOP_TABLE_SIZE == 5248 && ROOK_TABLE_SIZE == 102400);
+
+//! \brief  Construit les descriptions des 64 cases ; les entrées
+//!         de la pièce commencent à "base" dans SLIDER_ATTACKS
+constexpr std::array<Magic, 64> make_magics(const Bitboard (&masks)[64], const U64 (&magics)[64],
+                                            const int (&shifts)[64], U32 base)
+{
+    std::array<Magic, 64> result{};
+    for (int sq = 0; sq < 64; sq++)
+    {
+        result[sq] = Magic{masks[sq], magics[sq], base, static_cast<U32>(shifts[sq])};
+        base += 1U << (64 - shifts[sq]);
+    }
+    return result;
+}
+
+constexpr std::array<Magic, 64> BISHOP_MAGICS = make_magics(bishop_masks, bishop_magics, bishop_shifts, 0);
+constexpr std::array<Magic, 64> ROOK_MAGICS   = make_magics(rook_masks,   rook_magics,   rook_shifts,   BISHOP_TABLE_SIZE);
+
+// table d'attaques des fous, puis des tours [offset + index]
+extern Bitboard SLIDER_ATTACKS[BISHOP_TABLE_SIZE + ROOK_TABLE_SIZE];
+
+#if defined USE_DISPATCH
+//  ARCH=multi : PEXT ou magics, choisi au démarrage (Cpu::use_pext)
+//  et fixé par init_masks, qui remplit les tables en conséquence.
+extern bool use_pext;
+
+//======================================================
+//! \brief  Instruction pext, sans compiler tout le fichier avec -mbmi2
+//!         (l'assembleur la connaît ; l'intrinsèque exigerait l'option)
+//!
+//! \param[in]  src     bits à extraire
+//! \param[in]  mask    positions des bits extraits
+//!
+//! \return Bits de "src" sélectionnés par "mask", rangés en bits de poids faible
+//------------------------------------------------------
+[[nodiscard]] inline U64 pext(const U64 src, const U64 mask) noexcept {
+    U64 result;
+    __asm__("pextq %2, %1, %0" : "=r"(result) : "r"(src), "rm"(mask));
+    return result;
+}
+#elif defined USE_PEXT
+[[nodiscard]] inline U64 pext(const U64 src, const U64 mask) noexcept {
+    return _pext_u64(src, mask);
+}
+#endif
 
-// table d'attaques de la tour [case][occupancies]
-extern Bitboard ROOK_ATTACKS[64][4096];
+//======================================================
+//! \brief  Index des attaques dans SLIDER_ATTACKS (PEXT ou magic)
+//!
+//! \param[in]  m         description de la case
+//! \param[in]  occupied  bitboard de toutes les cases occupées
+//------------------------------------------------------
+[[nodiscard]] inline U32 magic_index(const Magic& m, const U64 occupied) noexcept {
+#if defined USE_DISPATCH
+    if (use_pext)
+        return m.offset + static_cast<U32>(pext(occupied, m.mask));
+    return m.offset + static_cast<U32>(((occupied & m.mask) * m.magic) >> m.shift);
+#elif defined USE_PEXT
+    return m.offset + static_cast<U32>(pext(occupied, m.mask));
+#else
+    return m.offset + static_cast<U32>(((occupied & m.mask) * m.magic) >> m.shift);
+#endif
+}
 
 //======================================================
 //! \brief  Donne l'attaque du pion (pas le déplacement) pour la couleur C
@@ -290,12 +380,7 @@ template <Color C>
 //------------------------------------------------------
 [[nodiscard]] inline U64 bishop_moves(const SQUARE sq, const U64 occupied) noexcept {
     assert(SQ::is_ok(sq));
-#if defined USE_PEXT
-    return BISHOP_ATTACKS[sq][static_cast<int>(_pext_u64(occupied, bishop_masks[sq]))];
-#else
-    return BISHOP_ATTACKS[sq][static_cast<int>((occupied & bishop_masks[sq]) * bishop_magics[sq]
-                                               >> (bishop_shifts[sq]))];
-#endif
+    return SLIDER_ATTACKS[magic_index(BISHOP_MAGICS[sq], occupied)];
 }
 
 //======================================================
@@ -309,12 +394,7 @@ template <Color C>
 //------------------------------------------------------
 [[nodiscard]] inline U64 rook_moves(const SQUARE sq, const U64 occupied) noexcept {
     assert(SQ::is_ok(sq));
-#if defined USE_PEXT
-    return ROOK_ATTACKS[sq][static_cast<int>(_pext_u64(occupied, rook_masks[sq]))];
-#else
-    return ROOK_ATTACKS[sq][static_cast<int>((occupied & rook_masks[sq]) * rook_magics[sq]
-                                             >> (rook_shifts[sq]))];
-#endif
+    return SLIDER_ATTACKS[magic_index(ROOK_MAGICS[sq], occupied)];
 }
 
 
@@ -296,3 +296,48 @@ bool Board::upcoming_repetition(int ply) const
 
     return false;
 }
+
+//==================================================================
+//! \brief  Reconstruit un coup complet à partir de sa forme compressée
+//!
+//! La pièce jouée et la pièce prise sont lues sur l'échiquier,
+//! la double poussée se déduit de la distance parcourue par le pion.
+//! Le coup n'est pas testé : il peut provenir d'une collision
+//! dans la table de transposition, c'est au MovePicker de le valider.
+//!
+//! \param[in]  packed  coup compressé sur 16 bits (voir Move::pack)
+//!
+//! \return Le coup au format interne, ou MOVE_NONE si la case de départ
+//!         ne contient pas une pièce du camp au trait
+//------------------------------------------------------------------
+MOVE Board::unpack_move(U16 packed) const noexcept
+{
+    if (packed == 0)
+        return Move::MOVE_NONE;
+
+    const SQUARE from    = packed & Move::MOVE_FROM_MASK;
+    const SQUARE dest    = (packed & Move::MOVE_DEST_MASK) >> Move::SHIFT_DEST;
+    const U16    special = packed >> Move::SHIFT_PACKED_SPECIAL;
+    const Piece  piece   = piece_at(from);
+
+    if (piece == Piece::PIECE_NONE || Move::color(piece) != turn())
+        return Move::MOVE_NONE;
+
+    switch (special)
+    {
+    case Move::PACKED_PROMOTION:
+    {
+        const auto promo = static_cast<PieceType>(((packed >> Move::SHIFT_PACKED_PROMO) & 3) + PieceType::KNIGHT);
+        return Move::CODE(from, dest, piece, piece_at(dest), Move::make_piece(turn(), promo), Move::FLAG_NONE);
+    }
+    case Move::PACKED_ENPASSANT:
+        return Move::CODE(from, dest, piece, Move::make_piece(~turn(), PieceType::PAWN), Piece::PIECE_NONE, Move::FLAG_ENPASSANT_MASK);
+    case Move::PACKED_CASTLE:
+        return Move::CODE(from, dest, piece, Piece::PIECE_NONE, Piece::PIECE_NONE, Move::FLAG_CASTLE_MASK);
+    default:
+        break;
+    }
+
+    const U32 flags = (Move::type(piece) == PieceType::PAWN && (dest > from ? dest - from : from - dest) == 16) ? Move::FLAG_DOUBLE_MASK : Move::FLAG_NONE;
+    return Move::CODE(from, dest, piece, piece_at(dest), Piece::PIECE_NONE, flags);
+}
@@ -256,9 +256,31 @@ public:
         else
             legal_moves<BLACK, MGType>(ml);
     }
-    template<Color C, MoveGenType MGType> void legal_moves(MoveList &ml) const ;
+    template<Color C, MoveGenType MGType> void legal_moves(MoveList &ml) const
+    {
+        ml.clear();
+        add_legal_moves<C, MGType>(ml);
+    }
+    //! \brief  Ajoute les coups légaux à la fin de la liste, sans la vider
+    template<Color C, MoveGenType MGType> void add_legal_moves(MoveList &ml) const ;
     template<Color C> void apply_token(const std::string &token) ;
 
+    //! \brief  Détermine si un coup (table de transposition, killer, counter)
+    //! peut être produit par le générateur dans la position actuelle,
+    //! sans tenir compte de l'échec au roi
+    [[nodiscard]] bool is_pseudo_legal(const MOVE move) const noexcept
+    {
+        return (turn() == WHITE) ? is_pseudo_legal<WHITE>(move) : is_pseudo_legal<BLACK>(move);
+    }
+    //! \brief  Détermine si un coup pseudo-légal laisse le roi hors d'échec
+    //! \note   Le coup doit avoir été validé par is_pseudo_legal
+    [[nodiscard]] bool is_legal(const MOVE move) const noexcept
+    {
+        return (turn() == WHITE) ? is_legal<WHITE>(move) : is_legal<BLACK>(move);
+    }
+    template<Color C> [[nodiscard]] bool is_pseudo_legal(const MOVE move) const noexcept;
+    template<Color C> [[nodiscard]] bool is_legal(const MOVE move) const noexcept;
+
     //==============================================
     //  Génération des coups
 
@@ -710,6 +732,7 @@ public:
     }
 
     [[nodiscard]] bool fast_see(const MOVE move, const int threshold) const;
+    [[nodiscard]] MOVE unpack_move(U16 packed) const noexcept;
 
     //====================================================================
     //! \brief  Détermine s'il y a eu 50 coups sans prise ni coup de pion
@@ -793,7 +816,7 @@ public:
     void TBScore(const unsigned wdl, const unsigned dtz, int &score, int &bound) const;
     bool probe_wdl(int &score, int &bound, int ply) const;
     MOVE convertPyrrhicMove(unsigned result) const;
-    bool probe_root(MOVE& move) const;
+    bool probe_root(MOVE& move, const MoveList& search_moves) const;
     void probe_root_test() const;
     void syzygy_info();
 
@@ -0,0 +1,226 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "Cpu.h"
+#include "Kernels.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+  #include <cpuid.h>
+  #define CPU_X86
+#endif
+
+//  Tables de noyaux définies par kernels.cpp (une par compilation)
+#if defined USE_DISPATCH
+extern const NnueKernels kernels_generic;
+extern const NnueKernels kernels_sse2;
+extern const NnueKernels kernels_avx2;
+extern const NnueKernels kernels_avx512;
+extern const NnueKernels kernels_vnni512;
+extern const NnueKernels kernels_avxvnni;
+#else
+extern const NnueKernels kernels_native;
+#endif
+
+namespace Cpu {
+
+namespace {
+
+#if defined CPU_X86
+
+struct Registers {
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+};
+
+//! \brief  Instruction cpuid pour la feuille "leaf" et la sous-feuille "subleaf"
+Registers cpuid(unsigned leaf, unsigned subleaf)
+{
+    Registers r;
+    __cpuid_count(leaf, subleaf, r.eax, r.ebx, r.ecx, r.edx);
+    return r;
+}
+
+//! \brief  Registre XCR0 : états des registres sauvés par le système
+uint64_t xgetbv0()
+{
+    unsigned low, high;
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return (static_cast<uint64_t>(high) << 32) | low;
+}
+
+#endif
+
+//======================================================
+//! \brief  Interroge le CPU
+//!
+//! Un jeu d'instructions vectoriel n'est retenu que si le système
+//! sauve les registres correspondants (XCR0) : un CPU AVX-512 peut
+//! tourner sous un système, ou une VM, qui ne les gère pas.
+//------------------------------------------------------
+Features detect()
+{
+    Features f;
+
+#if defined CPU_X86
+    const unsigned max_leaf = __get_cpuid_max(0, nullptr);
+
+    Registers r = cpuid(0, 0);
+    char vendor[13] = {};
+    std::memcpy(vendor,     &r.ebx, 4);
+    std::memcpy(vendor + 4, &r.edx, 4);
+    std::memcpy(vendor + 8, &r.ecx, 4);
+    f.vendor = vendor;
+
+    if (max_leaf >= 1)
+    {
+        r = cpuid(1, 0);
+
+        const int base_family = (r.eax >> 8) & 0xF;
+        const int base_model  = (r.eax >> 4) & 0xF;
+        f.family = base_family + (base_family == 0xF ? static_cast<int>((r.eax >> 20) & 0xFF) : 0);
+        f.model  = base_model  + (base_family == 0x6 || base_family == 0xF ? static_cast<int>((r.eax >> 16) & 0xF) << 4 : 0);
+
+        f.sse2   = r.edx & (1u << 26);
+        f.popcnt = r.ecx & (1u << 23);
+
+        const bool fma     = r.ecx & (1u << 12);
+        const bool osxsave = r.ecx & (1u << 27);
+        const bool avx     = r.ecx & (1u << 28);
+
+        const uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+        const bool ymm_state = (xcr0 & 0x06) == 0x06;     // SSE + AVX
+        const bool zmm_state = (xcr0 & 0xE6) == 0xE6;     // + opmask, ZMM0-15 (haut), ZMM16-31
+
+        if (max_leaf >= 7)
+        {
+            const Registers r7 = cpuid(7, 0);
+
+            f.bmi2   = r7.ebx & (1u << 8);
+            f.avx2   = avx && fma && ymm_state && (r7.ebx & (1u << 5));
+            f.avx512 = f.avx2 && zmm_state
+                    && (r7.ebx & (1u << 16))        // F
+                    && (r7.ebx & (1u << 17))        // DQ
+                    && (r7.ebx & (1u << 30))        // BW
+                    && (r7.ebx & (1u << 31));       // VL
+            f.avx512vnni = f.avx512 && (r7.ecx & (1u << 11));
+
+            if (r7.eax >= 1)
+                f.avxvnni = f.avx2 && (cpuid(7, 1).eax & (1u << 4));
+        }
+    }
+
+    if (__get_cpuid_max(0x80000000, nullptr) >= 0x80000004)
+    {
+        char brand[49] = {};
+        for (unsigned leaf = 0; leaf < 3; leaf++)
+        {
+            const Registers b = cpuid(0x80000002 + leaf, 0);
+            std::memcpy(brand + 16 * leaf,      &b.eax, 4);
+            std::memcpy(brand + 16 * leaf + 4,  &b.ebx, 4);
+            std::memcpy(brand + 16 * leaf + 8,  &b.ecx, 4);
+            std::memcpy(brand + 16 * leaf + 12, &b.edx, 4);
+        }
+        f.brand = brand;
+        f.brand.erase(0, f.brand.find_first_not_of(' '));
+    }
+
+    // Zen 1, Zen+, Zen 2 : famille 0x17 ; Hygon Dhyana (Zen 1) : famille 0x18
+    f.slow_pext = f.bmi2
+               && (   (f.vendor == "AuthenticAMD" && f.family == 0x17)
+                   || (f.vendor == "HygonGenuine" && f.family == 0x18));
+
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+    f.vendor = "ARM";
+    f.neon   = true;
+#endif
+
+    return f;
+}
+
+//======================================================
+//! \brief  Noyaux que ce CPU peut exécuter, du plus rapide au plus lent
+//------------------------------------------------------
+std::vector<const NnueKernels*> list_kernels()
+{
+    std::vector<const NnueKernels*> list;
+
+#if defined USE_DISPATCH
+    const Features& f = features();
+
+    if (f.avx512 && f.bmi2 && f.avx512vnni)
+        list.push_back(&kernels_vnni512);
+    if (f.avx512 && f.bmi2)
+        list.push_back(&kernels_avx512);
+    if (f.avx2 && f.avxvnni)
+        list.push_back(&kernels_avxvnni);
+    if (f.avx2)
+        list.push_back(&kernels_avx2);
+    list.push_back(&kernels_sse2);
+    list.push_back(&kernels_generic);
+#else
+    list.push_back(&kernels_native);
+#endif
+
+    return list;
+}
+
+const std::vector<const NnueKernels*>& kernel_list()
+{
+    static const std::vector<const NnueKernels*> list = list_kernels();
+    return list;
+}
+
+}   // namespace
+
+//======================================================
+//! \brief  Caractéristiques du CPU, détectées au premier appel
+//------------------------------------------------------
+const Features& features()
+{
+    static const Features f = detect();
+    return f;
+}
+
+//======================================================
+//! \brief  Noyaux NNUE choisis pour ce CPU : les plus rapides disponibles
+//------------------------------------------------------
+const NnueKernels& kernels()
+{
+    return *kernel_list().front();
+}
+
+//======================================================
+//! \brief  Tous les noyaux NNUE que ce CPU peut exécuter,
+//!         du plus rapide au plus lent (commande "kernels")
+//------------------------------------------------------
+std::span<const NnueKernels* const> available_kernels()
+{
+    return kernel_list();
+}
+
+//======================================================
+//! \brief  Les attaques des glisseurs utilisent-elles PEXT ?
+//------------------------------------------------------
+bool use_pext()
+{
+#if defined USE_DISPATCH
+    return features().bmi2 && !features().slow_pext;
+#elif defined USE_PEXT
+    return true;
+#else
+    return false;
+#endif
+}
+
+//======================================================
+//! \brief  Exécutable multi-architectures (ARCH=multi) ?
+//------------------------------------------------------
+bool is_dispatch()
+{
+#if defined USE_DISPATCH
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace Cpu
@@ -0,0 +1,50 @@
+#ifndef CPU_H
+#define CPU_H
+
+#include <span>
+#include <string>
+
+struct NnueKernels;
+
+//------------------------------------------------------------------------------
+//  Détection du CPU à l'exécution (cpuid), et choix des noyaux de calcul
+//
+//  Avec ARCH=multi, un seul exécutable contient les noyaux NNUE compilés
+//  pour plusieurs jeux d'instructions (kernels.cpp) : on prend le plus
+//  rapide que le CPU et le système savent exécuter. Les attaques des
+//  glisseurs utilisent PEXT si le CPU l'a, sauf sur AMD Zen 1 / Zen 2
+//  (famille 0x17) et Hygon (famille 0x18), où pext est microcodé
+//  (~100+ cycles au lieu de 3) : les magics y sont plus rapides.
+//
+//  Avec une ARCH fixée (sse2, avx2, native…), il n'y a qu'un jeu de noyaux,
+//  celui de la compilation ; la détection sert seulement à l'information.
+
+namespace Cpu {
+
+struct Features
+{
+    std::string vendor;             // "GenuineIntel", "AuthenticAMD"…
+    std::string brand;              // nom commercial du processeur
+    int  family      = 0;           // famille (avec la famille étendue)
+    int  model       = 0;           // modèle (avec le modèle étendu)
+
+    bool sse2        = false;
+    bool popcnt      = false;
+    bool avx2        = false;       // AVX2 + FMA, registres YMM sauvés par le système
+    bool bmi2        = false;
+    bool avx512      = false;       // AVX-512 F/BW/DQ/VL, registres ZMM sauvés par le système
+    bool avx512vnni  = false;
+    bool avxvnni     = false;
+    bool neon        = false;
+    bool slow_pext   = false;       // pext microcodé (AMD Zen 1 / Zen 2, Hygon)
+};
+
+const Features&    features();
+const NnueKernels& kernels();
+std::span<const NnueKernels* const> available_kernels();
+bool               use_pext();
+bool               is_dispatch();
+
+} // namespace Cpu
+
+#endif // CPU_H
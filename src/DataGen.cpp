@@ -316,7 +316,7 @@ void DataGen::genfens(int thread_id, const std::string& str_file,
         while (true)
         {
             // printf("----------------------------nouveau coup \n");
-            search->nodes   = 0;
+            search->reset_nodes();
             search->stopped = false;
             search->table->update_age();
 
@@ -498,7 +498,7 @@ void DataGen::data_search(Board& board, Timer& timer, Search& search,
     score = -INFINITE;
 
     search.stopped    = false;
-    search.nodes      = 0;
+    search.reset_nodes();
     search.best_depth = 0;
 
     for (int d = 0; d <= MAX_PLY; d++)
@@ -0,0 +1,49 @@
+#include <cstring>
+#include <new>
+#include "EvalCache.h"
+
+namespace {
+
+constexpr size_t CACHE_LINE = 64;
+
+}
+
+//========================================================
+//! \brief  Destructeur
+//--------------------------------------------------------
+EvalCache::~EvalCache()
+{
+    ::operator delete(table, std::align_val_t(CACHE_LINE));
+}
+
+//========================================================
+//! \brief  Fixe la taille du cache ; le contenu est effacé
+//! \param[in]  kb  taille en Ko, arrondie à la puissance de 2
+//!                 inférieure ; 0 désactive le cache
+//--------------------------------------------------------
+void EvalCache::resize(size_t kb)
+{
+    ::operator delete(table, std::align_val_t(CACHE_LINE));
+    table = nullptr;
+    mask  = 0;
+
+    size_t entries = kb * 1024 / sizeof(U64);
+    if (entries == 0)
+        return;
+    while (entries & (entries - 1))
+        entries &= entries - 1;
+
+    table = static_cast<U64*>(::operator new(entries * sizeof(U64), std::align_val_t(CACHE_LINE)));
+    mask  = entries - 1;
+    clear();
+}
+
+//========================================================
+//! \brief  Efface le contenu du cache
+//--------------------------------------------------------
+void EvalCache::clear()
+{
+    if (table != nullptr)
+        std::memset(table, 0, (mask + 1) * sizeof(U64));
+    stats = EvalCacheStats{};
+}
@@ -0,0 +1,78 @@
+#ifndef EVALCACHE_H
+#define EVALCACHE_H
+
+#include <cstddef>
+#include "types.h"
+#include "defines.h"
+
+//  Cache des évaluations statiques, un par thread (Search::evaluate)
+//
+//  Une position déjà évaluée par la thread (transposition, quiescence
+//  revenant sur la même position) retrouve son évaluation sans rattraper
+//  l'accumulateur (lazy updates) ni calculer la couche de sortie.
+//  Chaque entrée tient sur 8 octets : les 48 bits de poids fort de la clé,
+//  et l'évaluation sur 16 bits (|eval| < TBWIN_IN_X). Accès direct par
+//  masque, remplacement systématique. La table est alignée sur une ligne
+//  de cache ; étant propre à la thread, elle n'a besoin d'aucune
+//  synchronisation.
+
+//  Statistiques du cache, depuis le début de la recherche
+struct EvalCacheStats {
+    U64 probes = 0;
+    U64 hits   = 0;
+};
+
+class EvalCache
+{
+public:
+    EvalCache() { resize(EVAL_CACHE_SIZE); }
+    ~EvalCache();
+
+    EvalCache(const EvalCache&)            = delete;
+    EvalCache& operator=(const EvalCache&) = delete;
+
+    void resize(size_t kb);
+    void clear();
+
+    //! \brief  Cherche l'évaluation de la position "key"
+    //! \param[in]  key     clé de la position
+    //! \param[out] value   évaluation trouvée
+    //! \return "true" si la position est dans le cache
+    inline bool probe(KEY key, int& value)
+    {
+        if (table == nullptr)
+            return false;
+
+        stats.probes++;
+        const U64 entry = table[key & mask];
+        if (((entry ^ key) & KEY_MASK) != 0)
+            return false;
+
+        stats.hits++;
+        value = static_cast<I16>(entry & ~KEY_MASK);
+        return true;
+    }
+
+    //! \brief  Range l'évaluation de la position "key"
+    inline void store(KEY key, int value)
+    {
+        if (table != nullptr)
+            table[key & mask] = (key & KEY_MASK) | static_cast<U16>(value);
+    }
+
+    //! \brief  Remet à zéro les statistiques (début de recherche)
+    inline void reset_stats() { stats = EvalCacheStats{}; }
+    //! \brief  Retourne les statistiques depuis reset_stats
+    inline const EvalCacheStats& get_stats() const { return stats; }
+    //! \brief  Taille de la table, en Ko
+    inline size_t get_size() const { return table == nullptr ? 0 : (mask + 1) * sizeof(U64) / 1024; }
+
+private:
+    static constexpr U64 KEY_MASK = ~0xFFFFULL;
+
+    U64*           table = nullptr;
+    U64            mask  = 0;
+    EvalCacheStats stats;
+};
+
+#endif // EVALCACHE_H
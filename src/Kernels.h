@@ -0,0 +1,65 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <cstddef>
+#include "types.h"
+
+//------------------------------------------------------------------------------
+//  Noyaux de calcul NNUE (kernels.cpp)
+//
+//  kernels.cpp est le seul fichier qui utilise simd.h. Il est compilé :
+//      - une fois, avec les options de l'ARCH choisie (sse2, avx2, native…) ;
+//      - avec ARCH=multi, une fois par jeu d'instructions (generic, sse2,
+//        avx2, avx512, vnni512, avxvnni), chaque compilation produisant
+//        sa propre table "kernels_<isa>". Le reste du programme est compilé
+//        pour SSE2 ; la table utilisée est choisie au démarrage selon le
+//        CPU (voir Cpu::kernels).
+//
+//  Toutes les fonctions travaillent sur une perspective de HIDDEN_LAYER_SIZE
+//  neurones, alignée sur ALIGN octets.
+
+struct NnueKernels
+{
+    const char* name;               // jeu d'instructions ("avx2", "neon"…)
+    size_t      vector_bytes;       // taille d'un vecteur (0 : scalaire)
+
+    //! \brief  dst = src + add - sub   (coup normal)
+    void (*sub_add)(const I16* src, I16* dst,
+                    const I16* add, const I16* sub);
+
+    //! \brief  dst = src + add - sub_1 - sub_2   (prise, prise en passant)
+    void (*sub_sub_add)(const I16* src, I16* dst,
+                        const I16* add, const I16* sub_1, const I16* sub_2);
+
+    //! \brief  dst = src + add_1 + add_2 - sub_1 - sub_2   (roque)
+    void (*sub_sub_add_add)(const I16* src, I16* dst,
+                            const I16* add_1, const I16* add_2,
+                            const I16* sub_1, const I16* sub_2);
+
+    //! \brief  dst (et copy si non nul) = src + Σ lignes adds - Σ lignes subs,
+    //!         par tuiles de registres (NNUE::apply_features)
+    void (*apply_features)(const I16* weights, const I16* src, I16* dst, I16* copy,
+                           const U32* adds, size_t nbr_adds,
+                           const U32* subs, size_t nbr_subs);
+
+    //! \brief  Σ clamp(x, 0, QA)² × w sur les 2 perspectives (NNUE::activation)
+    //! \param[in] weights  poids de sortie du bucket : us, puis them
+    I32 (*activation)(const I16* us, const I16* them, const I16* weights);
+
+    //! \brief  Même somme, poids int8 (VNNI) ; nullptr sans VNNI
+    //! \param[in] weights  poids int8 du bucket, dans l'ordre de quantized_output
+    I32 (*activation_i8)(const I16* us, const I16* them, const I08* weights);
+
+    //  L1 creux des couches denses (LayerStack::propagate) ;
+    //  nullptr sans AVX2 : L1 est alors calculée en scalaire.
+    size_t l1_lanes;                // I32 par vecteur : L1 doit en être un multiple
+
+    //! \brief  Liste des blocs de 4 entrées non nuls ; retourne leur nombre
+    size_t (*find_nonzero_blocks)(const U08* input, size_t nbr_blocks, U16* indices);
+
+    //! \brief  Ajoute à z1 les colonnes de poids des blocs donnés
+    void (*add_blocks)(const U08* input, const U16* indices, size_t count,
+                       const I08* weights, size_t l1_size, I32* z1);
+};
+
+#endif // KERNELS_H
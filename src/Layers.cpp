@@ -0,0 +1,225 @@
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <random>
+#include "Kernels.h"
+#include "Layers.h"
+
+//======================================================
+//! \brief  Construit des couches denses de poids nuls
+//!
+//! \param[in] l1       taille de la couche L1
+//! \param[in] l2       taille de la couche L2
+//! \param[in] shift1   décalage de quantification en sortie de L1
+//! \param[in] shift2   décalage de quantification en sortie de L2
+//! \param[in] divisor  diviseur de la sortie (eval = sortie × SCALE / divisor)
+//------------------------------------------------------
+LayerStack::LayerStack(U32 l1, U32 l2, U32 shift1, U32 shift2, I32 divisor) :
+    l1_size(l1),
+    l2_size(l2),
+    l1_shift(shift1),
+    l2_shift(shift2),
+    eval_divisor(divisor),
+    l1_weights(OUTPUT_BUCKETS * INPUT_SIZE * l1),
+    l1_biases(OUTPUT_BUCKETS * l1),
+    l2_weights(OUTPUT_BUCKETS * l1 * l2),
+    l2_biases(OUTPUT_BUCKETS * l2),
+    l3_weights(OUTPUT_BUCKETS * l2),
+    l3_biases(OUTPUT_BUCKETS)
+{
+}
+
+//======================================================
+//! \brief  Construit des couches denses aux poids aléatoires
+//! Sert aux mesures de performance (commande "nnbench") :
+//! le coût d'une évaluation ne dépend pas de la valeur des poids.
+//!
+//! \param[in] l1       taille de la couche L1
+//! \param[in] l2       taille de la couche L2
+//! \param[in] seed     graine du générateur
+//------------------------------------------------------
+std::unique_ptr<LayerStack> LayerStack::random(U32 l1, U32 l2, U32 seed)
+{
+    auto stack = std::make_unique<LayerStack>(l1, l2, 6, 6, 64 * 64);
+
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> weight(-64, 64);
+    std::uniform_int_distribution<int> bias(-4096, 4096);
+
+    for (auto& w : stack->l1_weights) w = static_cast<I08>(weight(gen));
+    for (auto& w : stack->l2_weights) w = static_cast<I08>(weight(gen));
+    for (auto& w : stack->l3_weights) w = static_cast<I08>(weight(gen));
+    for (auto& b : stack->l1_biases)  b = bias(gen);
+    for (auto& b : stack->l2_biases)  b = bias(gen);
+    for (auto& b : stack->l3_biases)  b = bias(gen);
+
+    return stack;
+}
+
+//======================================================
+//! \brief  Lecture des poids, à la suite de l'en-tête du fichier
+//!
+//! Dans le fichier, par output bucket :
+//!     L1 : poids I8 [l1][2×HIDDEN_LAYER_SIZE], biais I32 [l1]
+//!     L2 : poids I8 [l2][l1],                 biais I32 [l2]
+//!     sortie : poids I8 [l2],                 biais I32
+//! Les poids L1 sont rangés en mémoire par bloc de 4 entrées.
+//!
+//! \param[in] is   flux positionné après les poids de l'accumulateur
+//! \return "true" si la lecture est complète
+//------------------------------------------------------
+bool LayerStack::read(std::istream& is)
+{
+    std::vector<I08> row(INPUT_SIZE);
+
+    for (size_t b = 0; b < OUTPUT_BUCKETS; b++)
+    {
+        for (size_t n = 0; n < l1_size; n++)
+        {
+            is.read(reinterpret_cast<char*>(row.data()), static_cast<std::streamsize>(row.size()));
+            for (size_t i = 0; i < INPUT_SIZE; i++)
+                l1_weights[l1_index(b, i, n)] = row[i];
+        }
+        is.read(reinterpret_cast<char*>(&l1_biases[b * l1_size]), l1_size * sizeof(I32));
+        is.read(reinterpret_cast<char*>(&l2_weights[b * l2_size * l1_size]), l2_size * l1_size);
+        is.read(reinterpret_cast<char*>(&l2_biases[b * l2_size]), l2_size * sizeof(I32));
+        is.read(reinterpret_cast<char*>(&l3_weights[b * l2_size]), l2_size);
+        is.read(reinterpret_cast<char*>(&l3_biases[b]), sizeof(I32));
+    }
+
+    return static_cast<bool>(is);
+}
+
+//======================================================
+//! \brief  Ecriture des poids, dans le format lu par read()
+//! \param[in] os   flux positionné après les poids de l'accumulateur
+//------------------------------------------------------
+void LayerStack::write(std::ostream& os) const
+{
+    std::vector<I08> row(INPUT_SIZE);
+
+    for (size_t b = 0; b < OUTPUT_BUCKETS; b++)
+    {
+        for (size_t n = 0; n < l1_size; n++)
+        {
+            for (size_t i = 0; i < INPUT_SIZE; i++)
+                row[i] = l1_weights[l1_index(b, i, n)];
+            os.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+        }
+        os.write(reinterpret_cast<const char*>(&l1_biases[b * l1_size]), l1_size * sizeof(I32));
+        os.write(reinterpret_cast<const char*>(&l2_weights[b * l2_size * l1_size]), l2_size * l1_size);
+        os.write(reinterpret_cast<const char*>(&l2_biases[b * l2_size]), l2_size * sizeof(I32));
+        os.write(reinterpret_cast<const char*>(&l3_weights[b * l2_size]), l2_size);
+        os.write(reinterpret_cast<const char*>(&l3_biases[b]), sizeof(I32));
+    }
+}
+
+//======================================================
+//! \brief  Renseigne la description des couches dans l'en-tête
+//! \param[out] header  en-tête du fichier réseau
+//------------------------------------------------------
+void LayerStack::fill_header(NetFileHeader& header) const
+{
+    header.l1_size      = l1_size;
+    header.l2_size      = l2_size;
+    header.l1_shift     = l1_shift;
+    header.l2_shift     = l2_shift;
+    header.eval_divisor = eval_divisor;
+}
+
+//=========================================
+//! \brief  Calcul des couches denses → score en centipions
+//!
+//! \tparam sparse  "true" : L1 ne parcourt que les blocs d'entrées non nuls
+//!                 "false" : L1 parcourt toutes les entrées (référence)
+//!                 Les 2 versions donnent le même résultat.
+//!                 En SIMD si les noyaux en ont une version (AVX2, AVX-512)
+//!                 et si la taille de L1 est un multiple du nombre d'I32 par
+//!                 vecteur ; sinon en scalaire.
+//! \param[in] us       accumulateur (HIDDEN_LAYER_SIZE) de la perspective du joueur actif
+//! \param[in] them     accumulateur (HIDDEN_LAYER_SIZE) de la perspective de l'adversaire
+//! \param[in] bucket   output bucket sélectionné (selon le nb de pièces restantes)
+//! \param[in] kern     noyaux de calcul (ceux de l'instance de NNUE)
+//!
+//! \return Score en centipions
+//-----------------------------------------
+template <bool sparse>
+I32 LayerStack::propagate(const std::array<I16, HIDDEN_LAYER_SIZE>& us,
+                          const std::array<I16, HIDDEN_LAYER_SIZE>& them,
+                          const int bucket,
+                          const NnueKernels& kern) const
+{
+    alignas(ALIGN) std::array<U08, INPUT_SIZE> input;
+
+    // SCReLU : clamp(acc, 0, QA)² ≤ 65025, ramené dans [0, 127]
+    for (size_t i = 0; i < HIDDEN_LAYER_SIZE; i++)
+    {
+        const I32 u = std::clamp(static_cast<I32>(us[i]),   0, QA);
+        const I32 t = std::clamp(static_cast<I32>(them[i]), 0, QA);
+        input[i]                     = static_cast<U08>((u * u) >> 9);
+        input[HIDDEN_LAYER_SIZE + i] = static_cast<U08>((t * t) >> 9);
+    }
+
+    // L1 : les poids d'un bloc de 4 entrées sont contigus pour tous les neurones
+    alignas(ALIGN) std::array<I32, MAX_LAYER_SIZE> z1;
+    std::copy_n(&l1_biases[bucket * l1_size], l1_size, z1.begin());
+
+    const I08* w1 = &l1_weights[l1_index(bucket, 0, 0)];
+
+    if (kern.add_blocks != nullptr && l1_size % kern.l1_lanes == 0)
+    {
+        std::array<U16, INPUT_BLOCKS + 8> indices;
+        size_t count = INPUT_BLOCKS;
+
+        if constexpr (sparse)
+            count = kern.find_nonzero_blocks(input.data(), INPUT_BLOCKS, indices.data());
+        else
+            for (size_t block = 0; block < INPUT_BLOCKS; block++)
+                indices[block] = static_cast<U16>(block);
+
+        kern.add_blocks(input.data(), indices.data(), count, w1, l1_size, z1.data());
+    }
+    else
+    for (size_t block = 0; block < INPUT_BLOCKS; block++)
+    {
+        const U08* in = &input[block * 4];
+
+        if constexpr (sparse)
+        {
+            U32 packed;
+            std::memcpy(&packed, in, sizeof(packed));
+            if (packed == 0)
+                continue;
+        }
+
+        const I08* w = w1 + block * l1_size * 4;
+        for (size_t n = 0; n < l1_size; n++)
+            z1[n] += in[0] * w[n*4] + in[1] * w[n*4+1] + in[2] * w[n*4+2] + in[3] * w[n*4+3];
+    }
+
+    std::array<U08, MAX_LAYER_SIZE> h1;
+    for (size_t n = 0; n < l1_size; n++)
+        h1[n] = static_cast<U08>(std::clamp(z1[n] >> l1_shift, 0, 127));
+
+    // L2
+    std::array<U08, MAX_LAYER_SIZE> h2;
+    const I08* w2 = &l2_weights[bucket * l2_size * l1_size];
+    for (size_t n = 0; n < l2_size; n++)
+    {
+        I32 z2 = l2_biases[bucket * l2_size + n];
+        for (size_t i = 0; i < l1_size; i++)
+            z2 += h1[i] * w2[n * l1_size + i];
+        h2[n] = static_cast<U08>(std::clamp(z2 >> l2_shift, 0, 127));
+    }
+
+    // Sortie
+    I32 z3 = l3_biases[bucket];
+    const I08* w3 = &l3_weights[bucket * l2_size];
+    for (size_t i = 0; i < l2_size; i++)
+        z3 += h2[i] * w3[i];
+
+    return static_cast<I32>(static_cast<I64>(z3) * SCALE / eval_divisor);
+}
+
+template I32 LayerStack::propagate<true>(const std::array<I16, HIDDEN_LAYER_SIZE>& us, const std::array<I16, HIDDEN_LAYER_SIZE>& them, const int bucket, const NnueKernels& kern) const;
+template I32 LayerStack::propagate<false>(const std::array<I16, HIDDEN_LAYER_SIZE>& us, const std::array<I16, HIDDEN_LAYER_SIZE>& them, const int bucket, const NnueKernels& kern) const;
@@ -0,0 +1,128 @@
+#ifndef LAYERS_H
+#define LAYERS_H
+
+#include <array>
+#include <iosfwd>
+#include <memory>
+#include <new>
+#include <vector>
+#include "NNUE.h"
+
+//------------------------------------------------------------------------------
+//  Couches denses après l'accumulateur (réseau multi-couches)
+//
+//      (768×16kb → 1024)×2 → L1 → L2 → 1   ×8 output buckets
+//
+//  L'accumulateur (feature transformer) reste celui de NNUE : taille fixée
+//  à la compilation. Les tailles L1 et L2 sont lues dans l'en-tête du
+//  fichier réseau (NetFileHeader) : elles ne sont pas des constantes.
+//
+//  Quantification (entiers uniquement) :
+//      entrée L1   : SCReLU = clamp(acc, 0, QA)² >> 9          → [0, 127]  (U8)
+//      L1          : z1 = b1 + Σ entrée × w1  (w1 en I8, b1 en I32)
+//                    h1 = clamp(z1 >> l1_shift, 0, 127)          (CReLU)
+//      L2          : z2 = b2 + Σ h1 × w2      (w2 en I8, b2 en I32)
+//                    h2 = clamp(z2 >> l2_shift, 0, 127)          (CReLU)
+//      sortie      : z3 = b3 + Σ h2 × w3      (w3 en I8, b3 en I32)
+//                    eval = z3 × SCALE / eval_divisor
+//
+//  Après SCReLU, une grande partie des entrées de L1 est nulle :
+//  la multiplication L1 ne parcourt que les blocs de 4 entrées non nuls
+//  (propagate<true>), les poids étant rangés par bloc d'entrées.
+//  Avec AVX2/AVX-512, la liste des blocs non nuls est construite par
+//  comparaison SIMD + masque + table, puis chaque bloc ajoute sa colonne
+//  de poids à tous les neurones de L1 (vpdpbusd, ou vpmaddubsw + vpmaddwd) :
+//  noyaux find_nonzero_blocks et add_blocks (kernels.cpp).
+
+constexpr U32 MAX_LAYER_SIZE = 256;     // taille maximale de L1 et L2
+
+//  Allocateur aligné sur ALIGN : les poids L1 sont lus par vecteurs entiers
+template <typename T>
+struct AlignedAllocator {
+    using value_type = T;
+
+    AlignedAllocator() = default;
+    template <typename U> AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T*   allocate(size_t n)          { return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(ALIGN))); }
+    void deallocate(T* p, size_t)    { ::operator delete(p, std::align_val_t(ALIGN)); }
+
+    template <typename U> bool operator==(const AlignedAllocator<U>&) const { return true; }
+};
+
+//-----------------------------------------------------------------------
+//  En-tête des fichiers réseau (commandes nnsave / nnload, option EvalFile)
+//  Suivent : feature_weights, feature_biases (I16),
+//            puis output_weights, output_bias (I16) si l1_size = 0,
+//            sinon les couches denses (LayerStack::read).
+//  Avec l1_size = 0, les données suivent exactement la structure Network :
+//  l'option EvalFile les utilise alors sur place (NNUE::set_eval_file).
+struct NetFileHeader {
+    char magic[8];          // "ZANGNET"
+    U32  version;           // version du format de fichier
+    U32  input_size;        // INPUT_LAYER_SIZE
+    U32  king_buckets;      // KING_BUCKETS_COUNT
+    U32  hidden_size;       // HIDDEN_LAYER_SIZE (par perspective)
+    U32  output_buckets;    // OUTPUT_BUCKETS
+    U32  l1_size;           // 0 : pas de couches denses (1024×2 → 1)
+    U32  l2_size;
+    U32  l1_shift;
+    U32  l2_shift;
+    I32  eval_divisor;
+    U32  checksum[2];       // empreinte des données qui suivent (poids faibles, forts) ; 0 : absente
+    U32  reserved[2];
+};
+
+static_assert(sizeof(NetFileHeader) == 64);
+
+constexpr char NET_FILE_MAGIC[8] = "ZANGNET";
+constexpr U32  NET_FILE_VERSION  = 1;
+
+//-----------------------------------------------------------------------
+
+class LayerStack
+{
+public:
+    LayerStack(U32 l1, U32 l2, U32 shift1, U32 shift2, I32 divisor);
+
+    static std::unique_ptr<LayerStack> random(U32 l1, U32 l2, U32 seed);
+
+    bool read(std::istream& is);
+    void write(std::ostream& os) const;
+    void fill_header(NetFileHeader& header) const;
+
+    template <bool sparse>
+    I32 propagate(const std::array<I16, HIDDEN_LAYER_SIZE>& us,
+                  const std::array<I16, HIDDEN_LAYER_SIZE>& them,
+                  const int bucket,
+                  const NnueKernels& kern) const;
+
+    //! \brief  Retourne la taille de la couche L1
+    U32 get_l1_size() const { return l1_size; }
+    //! \brief  Retourne la taille de la couche L2
+    U32 get_l2_size() const { return l2_size; }
+
+private:
+    static constexpr size_t INPUT_SIZE   = N_COLORS * HIDDEN_LAYER_SIZE;   // entrées de L1
+    static constexpr size_t INPUT_BLOCKS = INPUT_SIZE / 4;                 // blocs de 4 entrées
+
+    U32 l1_size;
+    U32 l2_size;
+    U32 l1_shift;
+    U32 l2_shift;
+    I32 eval_divisor;
+
+    std::vector<I08, AlignedAllocator<I08>> l1_weights;    // [bucket][bloc d'entrées][l1][4]
+    std::vector<I32> l1_biases;     // [bucket][l1]
+    std::vector<I08> l2_weights;    // [bucket][l2][l1]
+    std::vector<I32> l2_biases;     // [bucket][l2]
+    std::vector<I08> l3_weights;    // [bucket][l2]
+    std::vector<I32> l3_biases;     // [bucket]
+
+    //! \brief  Indice du poids L1 reliant l'entrée "input" au neurone "neuron"
+    size_t l1_index(int bucket, size_t input, size_t neuron) const {
+        return ((bucket * INPUT_BLOCKS + input / 4) * l1_size + neuron) * 4 + input % 4;
+    }
+};
+
+#endif // LAYERS_H
@@ -0,0 +1,258 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+#else
+  #include <cerrno>
+  #include <dirent.h>
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+//========================================================
+//! \brief  Projette le fichier en mémoire, en lecture seule
+//! Un fichier déjà ouvert est d'abord fermé.
+//!
+//! \param[in]  filename    nom du fichier
+//! \return "true" si la projection a réussi (fichier non vide)
+//--------------------------------------------------------
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    // la projection garde sa propre référence sur le fichier
+    HANDLE map = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (map == nullptr)
+        return false;
+
+    void* view = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr)
+    {
+        CloseHandle(map);
+        return false;
+    }
+
+    mapping = map;
+    ptr     = static_cast<const unsigned char*>(view);
+    length  = static_cast<size_t>(file_size.QuadPart);
+#else
+    const int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // la projection garde sa propre référence sur le fichier
+    void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+        return false;
+
+    ptr    = static_cast<const unsigned char*>(addr);
+    length = static_cast<size_t>(st.st_size);
+
+  #if defined(MADV_HUGEPAGE)
+    huge = madvise(addr, length, MADV_HUGEPAGE) == 0;
+  #endif
+  #if defined(MADV_WILLNEED)
+    // lecture anticipée : le premier refresh ne paiera pas les défauts de page
+    madvise(addr, length, MADV_WILLNEED);
+  #endif
+#endif
+
+    return true;
+}
+
+//========================================================
+//! \brief  Libère la projection
+//! Aucun pointeur vers les données ne doit plus être utilisé.
+//--------------------------------------------------------
+void MappedFile::close()
+{
+    if (ptr == nullptr)
+        return;
+
+#if defined(_WIN32)
+    UnmapViewOfFile(ptr);
+    CloseHandle(static_cast<HANDLE>(mapping));
+    mapping = nullptr;
+#else
+    munmap(const_cast<unsigned char*>(ptr), length);
+#endif
+
+    ptr    = nullptr;
+    length = 0;
+    huge   = false;
+}
+
+//========================================================
+//! \brief  Crée le segment "name", ou s'attache au segment existant
+//!
+//! Un segment existant doit avoir exactement la taille demandée.
+//! Il peut être en cours de remplissage par le processus qui l'a
+//! créé : c'est à l'appelant de le vérifier (voir NNUE::set_shared).
+//!
+//! \param[in]  name    nom du segment ("/xxx")
+//! \param[in]  size    taille du segment, en octets
+//! \return CREATED, ATTACHED ou FAILED
+//--------------------------------------------------------
+SharedSegment::Status SharedSegment::open(const std::string& name, size_t size)
+{
+    close();
+
+#if defined(_WIN32)
+    (void)name;
+    (void)size;
+    return Status::FAILED;
+#else
+    // création exclusive : un seul processus remplit le segment
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd >= 0)
+    {
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            ::close(fd);
+            shm_unlink(name.c_str());
+            return Status::FAILED;
+        }
+
+        void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED)
+        {
+            shm_unlink(name.c_str());
+            return Status::FAILED;
+        }
+
+        ptr    = static_cast<unsigned char*>(addr);
+        length = size;
+  #if defined(MADV_HUGEPAGE)
+        // huge pages si /sys/kernel/mm/transparent_hugepage/shmem_enabled le permet
+        madvise(addr, length, MADV_HUGEPAGE);
+  #endif
+        return Status::CREATED;
+    }
+
+    if (errno != EEXIST)
+        return Status::FAILED;
+
+    fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return Status::FAILED;
+
+    // le créateur n'a peut-être pas encore fixé la taille : elle est vérifiée
+    // par l'appelant, qui réessaie plus tard
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != size)
+    {
+        ::close(fd);
+        return Status::FAILED;
+    }
+
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+        return Status::FAILED;
+
+    ptr    = static_cast<unsigned char*>(addr);
+    length = size;
+    return Status::ATTACHED;
+#endif
+}
+
+//========================================================
+//! \brief  Fin du remplissage par le créateur : le segment passe en lecture seule
+//--------------------------------------------------------
+void SharedSegment::seal()
+{
+#if !defined(_WIN32)
+    if (ptr != nullptr)
+        mprotect(ptr, length, PROT_READ);
+#endif
+}
+
+//========================================================
+//! \brief  Détache le segment (il reste disponible pour les autres processus)
+//--------------------------------------------------------
+void SharedSegment::close()
+{
+    if (ptr == nullptr)
+        return;
+
+#if !defined(_WIN32)
+    munmap(ptr, length);
+#endif
+
+    ptr    = nullptr;
+    length = 0;
+}
+
+//========================================================
+//! \brief  Supprime le segment "name" du système
+//! Les processus qui y sont attachés le gardent jusqu'à leur détachement.
+//--------------------------------------------------------
+bool SharedSegment::remove(const std::string& name)
+{
+#if defined(_WIN32)
+    (void)name;
+    return false;
+#else
+    return shm_unlink(name.c_str()) == 0;
+#endif
+}
+
+//========================================================
+//! \brief  Noms des segments existants commençant par "prefix"
+//! Les segments POSIX sont les fichiers de /dev/shm sous Linux ;
+//! ailleurs (macOS, Windows), ils ne peuvent pas être énumérés.
+//!
+//! \param[in]  prefix  début du nom, avec le "/" initial (ex : "/zangdar-")
+//! \return noms utilisables par open et remove
+//--------------------------------------------------------
+std::vector<std::string> SharedSegment::list(const std::string& prefix)
+{
+    std::vector<std::string> names;
+
+#if defined(__linux__)
+    DIR* dir = opendir("/dev/shm");
+    if (dir == nullptr)
+        return names;
+
+    while (const dirent* entry = readdir(dir))
+    {
+        const std::string name = std::string("/") + entry->d_name;
+        if (name.compare(0, prefix.size(), prefix) == 0)
+            names.push_back(name);
+    }
+    closedir(dir);
+#else
+    (void)prefix;
+#endif
+
+    return names;
+}
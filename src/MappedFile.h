@@ -0,0 +1,83 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//  Fichier projeté en mémoire, en lecture seule (mmap, MapViewOfFile)
+//
+//  Les pages sont celles du cache du système : rien n'est copié, et
+//  plusieurs processus qui projettent le même fichier partagent la même
+//  mémoire physique. Sous Linux, on demande en plus des "huge pages"
+//  (madvise) ; le noyau ne les accorde aux fichiers que s'il a été
+//  compilé pour (CONFIG_READ_ONLY_THP_FOR_FS), sinon on garde des
+//  pages normales.
+
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& filename);
+    void close();
+
+    //! \brief  Premier octet du fichier, aligné sur une page (nullptr si fermé)
+    inline const unsigned char* data() const { return ptr; }
+    //! \brief  Taille du fichier, en octets
+    inline size_t size() const { return length; }
+    //! \brief  Huge pages demandées avec succès (madvise)
+    inline bool huge_pages() const { return huge; }
+
+private:
+    const unsigned char* ptr    = nullptr;
+    size_t               length = 0;
+    bool                 huge   = false;
+#if defined(_WIN32)
+    void*                mapping = nullptr;     // HANDLE de CreateFileMapping
+#endif
+};
+
+//  Segment de mémoire partagée nommé (POSIX : shm_open)
+//
+//  Le premier processus crée le segment et y écrit ; les suivants s'y
+//  attachent en lecture seule. Le segment survit aux processus (il est
+//  visible dans /dev/shm sous Linux) : les moteurs lancés plus tard le
+//  retrouvent par son nom. Sans POSIX (Windows), open échoue toujours.
+
+class SharedSegment
+{
+public:
+    enum class Status {
+        CREATED,        // segment créé, à remplir (data() modifiable), puis seal()
+        ATTACHED,       // segment existant, en lecture seule
+        FAILED
+    };
+
+    SharedSegment() = default;
+    ~SharedSegment() { close(); }
+
+    SharedSegment(const SharedSegment&)            = delete;
+    SharedSegment& operator=(const SharedSegment&) = delete;
+
+    Status open(const std::string& name, size_t size);
+    void   seal();
+    void   close();
+    static bool remove(const std::string& name);
+    static std::vector<std::string> list(const std::string& prefix);
+
+    //! \brief  Premier octet du segment, aligné sur une page (nullptr si fermé)
+    inline unsigned char* data() const { return ptr; }
+    //! \brief  Taille du segment, en octets
+    inline size_t size() const { return length; }
+
+private:
+    unsigned char* ptr    = nullptr;
+    size_t         length = 0;
+};
+
+#endif // MAPPEDFILE_H
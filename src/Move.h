@@ -238,6 +238,51 @@ constexpr U32 MOVE_NONE           = 0;
   return m != Move::MOVE_NONE && m != Move::MOVE_NULL;
 }
 
+/* Codage compact sur 16 bits (table de transposition "key16")
+
+0000 0000 0011 1111 -> From                         <<  0
+0000 1111 1100 0000 -> Dest                         <<  6
+0011 0000 0000 0000 -> Promotion (type - KNIGHT)    << 12
+1100 0000 0000 0000 -> Spécial                      << 14
+
+    Spécial : 0 = aucun ; 1 = promotion ; 2 = en-passant ; 3 = roque
+
+La pièce jouée, la pièce prise et la double poussée se déduisent
+de la position : voir Board::unpack_move.
+*/
+
+constexpr int SHIFT_PACKED_PROMO   = 12;
+constexpr int SHIFT_PACKED_SPECIAL = 14;
+
+constexpr U16 PACKED_PROMOTION     = 1;
+constexpr U16 PACKED_ENPASSANT     = 2;
+constexpr U16 PACKED_CASTLE        = 3;
+
+//=================================================
+//! \brief  Compresse un coup sur 16 bits
+//! \param[in]  move    coup au format interne 32 bits
+//! \return Le coup compressé (0 pour MOVE_NONE)
+//-------------------------------------------------
+[[nodiscard]] constexpr inline U16 pack(const MOVE move) noexcept
+{
+    if (move == MOVE_NONE)
+        return 0;
+
+    U16 special = 0;
+    U16 promo   = 0;
+    if (is_promoting(move))
+    {
+        special = PACKED_PROMOTION;
+        promo   = static_cast<U16>(promoted_type(move) - PieceType::KNIGHT);
+    }
+    else if (is_enpassant(move))
+        special = PACKED_ENPASSANT;
+    else if (is_castling(move))
+        special = PACKED_CASTLE;
+
+    return static_cast<U16>(fromdest(move) | (promo << SHIFT_PACKED_PROMO) | (special << SHIFT_PACKED_SPECIAL));
+}
+
 //=================================================
 //! \brief Affichage du coup
 //-------------------------------------------------
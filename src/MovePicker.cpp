@@ -1,4 +1,3 @@
-#include <cstring>
 #include "MovePicker.h"
 #include "types.h"
 #include "Move.h"
@@ -6,119 +5,21 @@
 //=====================================================
 //! \brief  Constructeur
 //-----------------------------------------------------
-MovePicker::MovePicker(Board& _board, const History& _history, const SearchInfo *_info,
+MovePicker::MovePicker(Board& _board, const History& _history, const SearchInfo *_info, MoveList& _ml,
                        MOVE _ttMove, MOVE _killer1, MOVE _killer2, MOVE _counter, int _threshold) :
     board(_board),
     history(_history),
     info(_info),
     stage(STAGE_TABLE),
     gen_quiet(false),
-    gen_legal(false),
     threshold(_threshold),
     tt_move(_ttMove),
     killer1(_killer1),
     killer2(_killer2),
-    counter(_counter)
+    counter(_counter),
+    ml(_ml)
 {
-#if 0
-    int nbr_noisy = 0;
-    int nbr_quiet = 0;
-    int nbr_capt = 0;
-    int nbr_promo = 0;
-    int nbr_capt_promo = 0;
-    int nbr_pep = 0;
-    int nbr_cas = 0;
-
-    if (board.turn() == WHITE)
-    {
-        board.legal_moves<WHITE, MoveGenType::ALL>(mll);
-        board.legal_noisy<WHITE>(mln);
-        board.legal_quiet<WHITE>(mlq);
-    }
-    else
-    {
-        board.legal_moves<BLACK, MoveGenType::ALL>(mll);
-        board.legal_noisy<BLACK>(mln);
-        board.legal_quiet<BLACK>(mlq);
-    }
-
-    for (int i=0; i<mll.count; i++)
-    {
-        if (Move::is_capturing(mll.mlmoves[i].move))
-        {
-            if (Move::is_promoting(mll.mlmoves[i].move))
-            {
-                nbr_capt_promo++;
-                // mln.mlmoves[mln.count++].move = mll.mlmoves[i].move;
-                nbr_noisy++;
-            }
-            else if (!Move::is_promoting(mll.mlmoves[i].move))
-            {
-                nbr_capt++;
-                // mln.mlmoves[mln.count++].move = mll.mlmoves[i].move;
-                nbr_noisy++;
-            }
-        }
-        else if (Move::is_promoting(mll.mlmoves[i].move))
-        {
-            nbr_promo++;
-            // mln.mlmoves[mln.count++].move = mll.mlmoves[i].move;
-            nbr_noisy++;
-        }
-        else if(Move::is_enpassant(mll.mlmoves[i].move))
-        {
-            nbr_pep++;
-            // mln.mlmoves[mln.count++].move = mll.mlmoves[i].move;
-            nbr_noisy++;
-        }
-        else if(Move::is_castling(mll.mlmoves[i].move))
-        {
-            nbr_cas++;
-            // mln.mlmoves[mln.count++].move = mll.mlmoves[i].move;
-        }
-
-        else
-        {
-            // mlq.mlmoves[mlq.count++].move = mll.mlmoves[i].move;
-            nbr_quiet++;
-        }
-    }
-    nbr_noisy = mln.size();
-    nbr_quiet = mlq.size();
-
-    if (mll.count != (nbr_noisy + nbr_quiet))
-    {
-        std::cout << ">>>>>>>>>>> erreur 1 " << std::endl;
-        std::cout << "nbr_noisy =  " << nbr_noisy << std::endl;
-        std::cout << "nbr_capt =  " << nbr_capt << std::endl;
-        std::cout << "nbr_promo =  " << nbr_promo << std::endl;
-        std::cout << "nbr_pep =  " << nbr_pep << std::endl;
-        std::cout << "nbr_noisy =  " << mln.count << std::endl;
-    }
-
-    if (nbr_noisy != (nbr_capt + nbr_capt_promo + nbr_promo + nbr_pep))
-    {
-        std::cout << ">>>>>>>>>>> erreur 2 " << std::endl;
-        std::cout << "nbr_noisy =  " << nbr_noisy << std::endl;
-        std::cout << "nbr_capt =  " << nbr_capt << std::endl;
-        std::cout << "nbr_capt_promo =  " << nbr_capt_promo << std::endl;
-        std::cout << "nbr_promo =  " << nbr_promo << std::endl;
-        std::cout << "nbr_pep =  " << nbr_pep << std::endl;
-        std::cout << "nbr_castling =  " << nbr_cas << std::endl;
-        std::cout << "nbr_noisy =  " << mln.count << std::endl;
-    }
-
-
-    if (nbr_noisy != mln.count)
-        std::cout << ">>>>>>>>>>> erreur 3 " << std::endl;
-
-    if (nbr_quiet != mlq.count)
-        std::cout << ">>>>>>>>>>> erreur 4 " << std::endl;
-
-    // std::cout << "vérification terminée" << std::endl;
-    // score_noisy(board);
-    // score_quiet(board);
-#endif
+    ml.clear();
 }
 
 
@@ -152,9 +53,10 @@ MLMove MovePicker::next_move(bool skipQuiets)
         // Cette étape n'est qu'un helper : on passe directement à la suivante.
 
         if (board.turn() == WHITE)
-            board.legal_moves<WHITE, MoveGenType::NOISY>(mln);
+            board.legal_moves<WHITE, MoveGenType::NOISY>(ml);
         else
-            board.legal_moves<BLACK, MoveGenType::NOISY>(mln);
+            board.legal_moves<BLACK, MoveGenType::NOISY>(ml);
+        noisy_end = bad_begin = quiet_begin = ml.count;
         score_noisy();
         stage = STAGE_GOOD_NOISY ;
 
@@ -163,24 +65,24 @@ MLMove MovePicker::next_move(bool skipQuiets)
     case STAGE_GOOD_NOISY:
 
         // Vérifie s'il reste des coups noisy
-        if (mln.count != 0)
+        if (noisy_end != 0)
         {
-            size_t  best     = get_best(mln);
+            size_t  best     = get_best(0, noisy_end);
 
             // Ne pas jouer deux fois le coup de la table
-            if (mln.mlmoves[best].move == tt_move)
+            if (ml.mlmoves[best].move == tt_move)
             {
-                shift_move(mln, best);
+                shift_move(best, noisy_end);
                 return next_move(skipQuiets);
             }
 
-            if (!board.fast_see(mln.mlmoves[best].move, threshold))
+            if (!board.fast_see(ml.mlmoves[best].move, threshold))
             {
                 shift_bad(best);
                 return next_move(skipQuiets);
             }
 
-            return pop_move(mln, best);
+            return pop_move(best, noisy_end);
         }
 
         if (skipQuiets)
@@ -248,10 +150,11 @@ MLMove MovePicker::next_move(bool skipQuiets)
         {
             if (gen_quiet == false)
             {
+                // les coups tranquilles sont ajoutés après les captures
                 if (board.turn() == WHITE)
-                    board.legal_moves<WHITE, MoveGenType::QUIET>(mlq);
+                    board.add_legal_moves<WHITE, MoveGenType::QUIET>(ml);
                 else
-                    board.legal_moves<BLACK, MoveGenType::QUIET>(mlq);
+                    board.add_legal_moves<BLACK, MoveGenType::QUIET>(ml);
                 gen_quiet = true;
                 score_quiet();
             }
@@ -263,10 +166,10 @@ MLMove MovePicker::next_move(bool skipQuiets)
     case STAGE_QUIET:
 
         // Vérifie s'il reste des coups quiets
-        if (mlq.count != 0 && !skipQuiets)
+        if (ml.count != quiet_begin && !skipQuiets)
         {
-            size_t  best     = get_best(mlq);
-            MLMove bestMove = pop_move(mlq, best);
+            size_t  best     = get_best(quiet_begin, ml.count);
+            MLMove bestMove = pop_move(best, ml.count);
 
             if (   bestMove.move == tt_move
                    || bestMove.move == killer1
@@ -284,10 +187,12 @@ MLMove MovePicker::next_move(bool skipQuiets)
 
     case STAGE_BAD_NOISY:
 
-        if (mlb.count > 0)
+        if (bad_begin != quiet_begin)
         {
-            size_t  best     = get_best(mlb);
-            MLMove bestMove = pop_move(mlb, best);
+            // la dernière mauvaise capture trouvée est en bad_begin
+            size_t  best     = get_best_bad();
+            MLMove bestMove = ml.mlmoves[best];
+            ml.mlmoves[best] = ml.mlmoves[bad_begin++];
 
             // Ne pas rejouer un coup déjà proposé (table, killer, counter)
             if (   bestMove.move == tt_move
@@ -319,9 +224,9 @@ void MovePicker::score_noisy()
     MOVE move;
     int  value;
 
-    for (size_t i = 0; i < mln.count; i++)
+    for (size_t i = 0; i < ml.count; i++)
     {
-        move     = mln.mlmoves[i].move;
+        move     = ml.mlmoves[i].move;
 
         // Utilise le MVV-LVA standard
         // PieceType dest_type = board.piece_on(Move::dest(move));  // pièce prise ou promotion
@@ -344,7 +249,7 @@ void MovePicker::score_noisy()
             value = MvvLvaScores[PieceType::PAWN][PieceType::PAWN];
         // eg_value[PAWN] -PieceType::PAWN;
 
-        mln.mlmoves[i].value = value + history.get_capture_history(info, move) ; //TODO à modérer ??
+        ml.mlmoves[i].value = value + history.get_capture_history(info, move) ; //TODO à modérer ??
     }
 }
 
@@ -357,9 +262,9 @@ void MovePicker::score_quiet()
     int value;
 
     // Utilise le score d'history pour le tri
-    for (size_t i = 0; i < mlq.count; i++)
+    for (size_t i = quiet_begin; i < ml.count; i++)
     {
-        move = mlq.mlmoves[i].move;
+        move = ml.mlmoves[i].move;
 
         Piece piece = Move::piece(move);
         SQUARE dest = Move::dest(move);
@@ -374,23 +279,44 @@ void MovePicker::score_quiet()
         if (Move::is_ok((info-4)->move))
             value +=     (int)(*(info - 4)->cont_hist)[piece][dest];
 
-        mlq.mlmoves[i].value = value;
+        ml.mlmoves[i].value = value;
     }
 }
 
 //====================================================
 //! \brief  Retourne l'indice du meilleur élément
 //!
-//! \param[in]  ml  liste de coups dans laquelle chercher
+//! \param[in]  begin   début de la zone de la liste
+//! \param[in]  end     fin de la zone (exclue)
 //!
 //! \return Indice du coup ayant la plus haute valeur
 //-----------------------------------------------------
-size_t MovePicker::get_best(const MoveList& ml)
+size_t MovePicker::get_best(size_t begin, size_t end) const
 {
-    size_t best_index = 0;
+    size_t best_index = begin;
 
     // Trouve le coup ayant la valeur la plus haute
-    for (size_t i = 1; i < ml.count; i++)
+    for (size_t i = begin + 1; i < end; i++)
+    {
+        if (ml.mlmoves[i].value > ml.mlmoves[best_index].value)
+            best_index = i;
+    }
+
+    return best_index;
+}
+
+//====================================================
+//! \brief  Retourne l'indice de la meilleure mauvaise capture
+//!
+//! Les mauvaises captures sont parcourues dans l'ordre
+//! de leur découverte, c'est-à-dire depuis quiet_begin
+//! vers bad_begin : à valeur égale, la première trouvée est choisie.
+//-----------------------------------------------------
+size_t MovePicker::get_best_bad() const
+{
+    size_t best_index = quiet_begin - 1;
+
+    for (size_t i = quiet_begin - 1; i-- > bad_begin; )
     {
         if (ml.mlmoves[i].value > ml.mlmoves[best_index].value)
             best_index = i;
@@ -401,57 +327,58 @@ size_t MovePicker::get_best(const MoveList& ml)
 
 //========================================================
 //! \brief  Retourne le coup indiqué
-//! puis déplace le dernier élément à la position
+//! puis déplace le dernier élément de la zone à la position
 //! du coup indiqué
 //!
-//! \param[in,out]  ml   liste de coups modifiée (élément retiré)
 //! \param[in]      idx  indice du coup à extraire
+//! \param[in,out]  end  fin de la zone, diminuée de 1
 //!
 //! \return Le coup extrait
 //--------------------------------------------------------
-MLMove MovePicker::pop_move(MoveList& ml, size_t idx)
+MLMove MovePicker::pop_move(size_t idx, size_t& end)
 {
     /*
     ---------------+-----------------+
-                   idx               count
-                                    count
+                   idx               end
     */
 
     MLMove temp = ml.mlmoves[idx];
 
-    ml.count--;
-    std::memcpy(&ml.mlmoves[idx], &ml.mlmoves[ml.count], sizeof(MLMove));
+    end--;
+    ml.mlmoves[idx] = ml.mlmoves[end];
 
     return temp;
 }
 
 //========================================================
-//! \brief  Déplace le dernier élément à la position indiquée
+//! \brief  Déplace le dernier élément de la zone à la position indiquée
 //!
-//! \param[in,out]  ml   liste de coups modifiée
 //! \param[in]      idx  indice de la position à écraser
+//! \param[in,out]  end  fin de la zone, diminuée de 1
 //--------------------------------------------------------
-void MovePicker::shift_move(MoveList& ml, size_t idx)
+void MovePicker::shift_move(size_t idx, size_t& end)
 {
-    ml.count--;
-    std::memcpy(&ml.mlmoves[idx], &ml.mlmoves[ml.count], sizeof(MLMove));
+    end--;
+    ml.mlmoves[idx] = ml.mlmoves[end];
 }
 
 //======================================================
-//! \brief  Déplace le coup indiqué dans la liste mlb
-//! Puis enlève le coup de la liste mln
+//! \brief  Déplace le coup indiqué dans la zone des mauvaises captures
+//! Puis enlève le coup de la zone des captures à examiner
 //!
-//! \param[in]  idx  indice du coup (dans mln) à déplacer vers mlb
+//! \param[in]  idx  indice du coup à déplacer
 //------------------------------------------------------
 void MovePicker::shift_bad(size_t idx)
 {
-    // Place la mauvaise capture dans la liste des "bad"
-    std::memcpy(&mlb.mlmoves[mlb.count], &mln.mlmoves[idx], sizeof(MLMove));
-    mlb.count++;
+    MLMove temp = ml.mlmoves[idx];
 
     // met la dernière bonne capture à sa place
-    mln.count--;
-    std::memcpy(&mln.mlmoves[idx], &mln.mlmoves[mln.count], sizeof(MLMove));
+    noisy_end--;
+    ml.mlmoves[idx] = ml.mlmoves[noisy_end];
+
+    // Place la mauvaise capture dans la zone des "bad" ;
+    // bad_begin reste toujours au-delà de noisy_end
+    ml.mlmoves[--bad_begin] = temp;
 }
 
 
@@ -466,44 +393,8 @@ bool MovePicker::is_legal(MOVE move)
 {
     assert(move != Move::MOVE_NULL);
 
-    // coup non initialisé
-    if (move == Move::MOVE_NONE)
-    {
-        // std::cout << "---- 0000" << std::endl;
-        return false;
-    }
-
-    // pièce non initialisée
-    SQUARE from = Move::from(move);
-    if (board.piece_at(from) == Piece::PIECE_NONE)
-    {
-        // std::cout << "--------11111 "  << std::endl;
-        return false;
-    }
-
-    // la couleur de la pièce est fausse
-    if (Move::color(board.piece_at(from)) != board.turn())
-    {
-        // std::cout << "------------2222 "  << std::endl;
-        return false;
-    }
-
-    // on essaye de minimiser les appels à legal_moves
-    if (gen_legal == false)
-    {
-        if (board.turn() == WHITE)
-            board.legal_moves<WHITE, MoveGenType::ALL>(mll);
-        else
-            board.legal_moves<BLACK, MoveGenType::ALL>(mll);
-        gen_legal = true;
-    }
-
-    // en dernier ressort, on teste
-    for (size_t n=0; n<mll.count; n++)
-        if (mll.mlmoves[n].move == move)
-            return true;
-
-    return false;
+    // test direct du coup, sans générer tous les coups légaux
+    return board.is_pseudo_legal(move) && board.is_legal(move);
 }
 
 
@@ -36,7 +36,7 @@ class MovePicker
 {
 public:
 
-    MovePicker(Board& _board, const History& _history, const SearchInfo* _info,
+    MovePicker(Board& _board, const History& _history, const SearchInfo* _info, MoveList& _ml,
                MOVE _ttMove, MOVE _killer1, MOVE _killer2, MOVE _counter,
                int _threshold) ;
 
@@ -46,11 +46,12 @@ public:
     bool   is_legal(MOVE move);
     void   verify_MvvLva();
 
-    MLMove pop_move(MoveList &ml, size_t idx);
-    void   shift_move(MoveList& ml, size_t idx);
+    MLMove pop_move(size_t idx, size_t& end);
+    void   shift_move(size_t idx, size_t& end);
 
     void shift_bad(size_t idx);
-    size_t get_best(const MoveList &ml);
+    size_t get_best(size_t begin, size_t end) const;
+    size_t get_best_bad() const;
     //! \brief Retourne l'étape courante du sélecteur de coups
     int  get_stage() const { return stage;}
 
@@ -65,7 +66,6 @@ private:
 
     int     stage;         // étape courante du sélecteur
     bool    gen_quiet;     // a-t-on déjà généré les coups tranquilles ?
-    bool    gen_legal;
     int     threshold;
 
     MOVE tt_move = Move::MOVE_NONE;
@@ -73,10 +73,19 @@ private:
     MOVE killer2 = Move::MOVE_NONE;
     MOVE counter = Move::MOVE_NONE;
 
-    MoveList mlq;
-    MoveList mln;
-    MoveList mlb;
-    MoveList mll;   // MoveList de tous les coups légaux pour déterminer si un coup est légal
+    //  Tous les coups sont dans une seule liste, fournie par Search (une par ply) :
+    //
+    //  0                 noisy_end        bad_begin     quiet_begin            ml.count
+    //  +---------------------+----------------+--------------+-----------------------+
+    //  | captures à examiner |    (jouées)    |   mauvaises  |  coups tranquilles    |
+    //  +---------------------+----------------+--------------+-----------------------+
+    //
+    //  Les mauvaises captures sont rangées depuis la fin de la zone des captures,
+    //  dans l'ordre inverse de leur découverte.
+    MoveList& ml;
+    size_t    noisy_end   = 0;
+    size_t    bad_begin   = 0;
+    size_t    quiet_begin = 0;
 
 };
 
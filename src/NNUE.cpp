@@ -1,10 +1,25 @@
 #include "NNUE.h"
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <vector>
 #include "types.h"
 #include "bitmask.h"
-#include "simd.h"
+#include "Kernels.h"
+#include "MappedFile.h"
 #include "Move.h"
 #include "Board.h"
+#include "Layers.h"
 
 /*   INCBIN est une macro (de la bibliothèque incbin) qui insère le contenu brut du fichier EVALFILE
  *   directement dans une section de données de l'exécutable, au moment de la compilation.
@@ -16,17 +31,645 @@
  *  Après le passage du préprocesseur, il existe donc trois identifiants distincts dans ce fichier :
  *      - Network       : le type, la struct définie dans NNUE.h ;
  *      - gnetworkxxx   : les 3 symboles générés par la macro ;
- *      - network       : pointeur sur le réseau
+ *      - NNUE::embedded_network() : pointeur sur le réseau embarqué
+ *      - NNUE::main_network()     : réseau chargé par "nnload" ou l'option EvalFile,
+ *                                   sinon le réseau embarqué
  *
- *  Tout est dans un namespace anonyme : network est privé à NNUE.cpp.
+ *  Tout est dans un namespace anonyme : les symboles sont privés à NNUE.cpp.
+ *  Chaque instance de NNUE lit ses poids via son propre pointeur "network",
+ *  qui désigne le réseau embarqué ou sa copie sur le nœud NUMA de la thread.
  */
 
 namespace {
 
 #include "incbin/incbin.h"
+#if defined USE_DISPATCH
+//  incbin aligne selon les options de compilation de ce fichier (SSE2 : 16 octets) ;
+//  les noyaux AVX-512 lisent les poids par chargements alignés sur 64 octets.
+  #undef  INCBIN_ALIGNMENT_INDEX
+  #define INCBIN_ALIGNMENT_INDEX 6
+#endif
 INCBIN(network, EVALFILE);
-const Network *network = reinterpret_cast<const Network *>(gnetworkData);
 
+// Réseau chargé par NNUE::load_file ; à défaut, on utilise le réseau embarqué
+std::unique_ptr<Network>    loaded_network;
+std::unique_ptr<LayerStack> loaded_layers;
+
+// Réseau projeté en mémoire par NNUE::set_eval_file (sans copie)
+std::unique_ptr<MappedFile> mapped_file;
+const Network*              mapped_network = nullptr;
+
+// Réseau publié en mémoire partagée par NNUE::set_shared ; shared_owns_copy :
+// la copie privée (loaded_network) a été libérée au profit du segment.
+std::unique_ptr<SharedSegment> shared_segment;
+const Network*                 shared_network   = nullptr;
+bool                           shared_owns_copy = false;
+std::string                    shared_name;
+
+//  En-tête du segment partagé ; le réseau suit, à SHARED_NET_OFFSET
+struct SharedNetHeader {
+    char magic[8];          // "ZANGSHM"
+    U64  hash;              // empreinte des poids (net_hash)
+    U64  size;              // sizeof(Network)
+    U32  ready;             // 1 : poids écrits par le créateur (accès atomique)
+};
+
+constexpr char   SHARED_NET_MAGIC[8] = "ZANGSHM";
+constexpr char   SHARED_NET_PREFIX[] = "/zangdar-net-";
+constexpr size_t SHARED_NET_OFFSET   = 64;
+static_assert(sizeof(SharedNetHeader) <= SHARED_NET_OFFSET && SHARED_NET_OFFSET % ALIGN == 0);
+
+//  Objet de type T placé à "offset" octets du début d'une projection
+//  (MappedFile, SharedSegment). Une projection commence sur une page :
+//  l'objet est aligné dès que "offset" est un multiple de ALIGN. Le passage
+//  par void* évite l'avertissement -Wcast-align sur unsigned char*.
+static_assert(alignof(Network) <= ALIGN && alignof(SharedNetHeader) <= ALIGN && ALIGN <= 4096);
+
+template <typename T>
+T* mapped_as(unsigned char* base, size_t offset = 0)
+{
+    assert(offset % ALIGN == 0);
+    return static_cast<T*>(static_cast<void*>(base + offset));
+}
+
+template <typename T>
+const T* mapped_as(const unsigned char* base, size_t offset = 0)
+{
+    assert(offset % ALIGN == 0);
+    return static_cast<const T*>(static_cast<const void*>(base + offset));
+}
+
+//  Taille des poids au format Bullet (réseau embarqué, sans en-tête) :
+//  la structure Network sans le remplissage final dû à l'alignement.
+constexpr size_t NET_RAW_SIZE = offsetof(Network, output_bias) + sizeof(Network::output_bias);
+
+// Copies du réseau, une par nœud NUMA (voir NNUE::node_network)
+std::vector<std::unique_ptr<Network>> replicas;
+std::mutex                            replicas_mutex;
+
+#if defined USE_VNNI
+// Poids de sortie int8, un jeu par réseau et par taille de vecteur (voir NNUE::quantized_output)
+std::vector<std::tuple<const Network*, size_t, std::unique_ptr<OutputWeightsI8>>> quantized;
+std::mutex                                                                       quantized_mutex;
+#endif
+
+//======================================================
+//! \brief  Empreinte 64 bits d'un bloc de données (NetFileHeader::checksum)
+//! Les données peuvent être passées en plusieurs morceaux, tous de
+//! taille multiple de 8 sauf le dernier ; net_hash_final termine le calcul.
+//------------------------------------------------------
+U64 net_hash_update(U64 h, const unsigned char* data, size_t size)
+{
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        U64 word;
+        std::memcpy(&word, data + i, 8);
+        h = ((h ^ word) * 0x9E3779B97F4A7C15ULL);
+        h ^= h >> 29;
+    }
+    for (; i < size; i++)
+        h = (h ^ data[i]) * 0x100000001B3ULL;
+    return h;
+}
+
+U64 net_hash_final(U64 h, size_t size)
+{
+    h ^= size;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+constexpr U64 NET_HASH_SEED = 0x5A414E474E455431ULL;   // "ZANGNET1"
+
+U64 net_hash(const unsigned char* data, size_t size)
+{
+    return net_hash_final(net_hash_update(NET_HASH_SEED, data, size), size);
+}
+
+//! \brief  Empreinte stockée dans l'en-tête (0 : fichier écrit sans empreinte)
+U64 header_checksum(const NetFileHeader& header)
+{
+    return (static_cast<U64>(header.checksum[1]) << 32) | header.checksum[0];
+}
+
+//======================================================
+//! \brief  L'en-tête décrit-il un réseau utilisable par ce programme ?
+//! Les dimensions de l'accumulateur doivent être celles du programme ;
+//! les tailles des couches denses sont libres (≤ MAX_LAYER_SIZE).
+//------------------------------------------------------
+bool header_ok(const NetFileHeader& header)
+{
+    return std::memcmp(header.magic, NET_FILE_MAGIC, sizeof(header.magic)) == 0
+        && header.version        == NET_FILE_VERSION
+        && header.input_size     == INPUT_LAYER_SIZE
+        && header.king_buckets   == KING_BUCKETS_COUNT
+        && header.hidden_size    == HIDDEN_LAYER_SIZE
+        && header.output_buckets == OUTPUT_BUCKETS
+        && header.l1_size        <= MAX_LAYER_SIZE
+        && header.l2_size        <= MAX_LAYER_SIZE
+        && header.l1_shift       <= 31
+        && header.l2_shift       <= 31
+        && (header.l1_size == 0 || (header.l2_size != 0 && header.eval_divisor > 0));
+}
+
+//======================================================
+//! \brief  Oublie les données calculées à partir de l'ancien réseau
+//! (copies NUMA, poids de sortie int8) : un nouveau réseau peut
+//! se trouver à la même adresse que l'ancien.
+//------------------------------------------------------
+void forget_derived()
+{
+    {
+        std::lock_guard<std::mutex> lock(replicas_mutex);
+        replicas.clear();
+    }
+#if defined USE_VNNI
+    {
+        std::lock_guard<std::mutex> lock(quantized_mutex);
+        quantized.clear();
+    }
+#endif
+}
+
+//! \brief  Affiche une empreinte en hexadécimal
+std::string hash_string(U64 h)
+{
+    std::ostringstream oss;
+    oss << "0x" << std::hex << std::setw(16) << std::setfill('0') << h;
+    return oss.str();
+}
+
+}
+
+//======================================================
+//! \brief  Retourne le réseau embarqué dans l'exécutable
+//! Pas de variable globale initialisée à partir de gnetworkData :
+//! le ThreadPool global construit ses NNUE avant qu'elle le soit.
+//------------------------------------------------------
+const Network* NNUE::embedded_network()
+{
+    return reinterpret_cast<const Network *>(gnetworkData);
+}
+
+//======================================================
+//! \brief  Retourne le réseau utilisé par les nouvelles instances :
+//! sa copie en mémoire partagée (set_shared), sinon celui chargé
+//! par load_file ou projeté par set_eval_file, sinon le réseau embarqué
+//------------------------------------------------------
+const Network* NNUE::main_network()
+{
+    if (shared_network != nullptr)
+        return shared_network;
+    if (loaded_network)
+        return loaded_network.get();
+    return mapped_network != nullptr ? mapped_network : embedded_network();
+}
+
+//======================================================
+//! \brief  Retourne les couches denses du réseau principal
+//! \return nullptr pour un réseau à une couche (réseau embarqué)
+//------------------------------------------------------
+const LayerStack* NNUE::main_layers()
+{
+    return loaded_layers.get();
+}
+
+//======================================================
+//! \brief  Chargement d'un réseau décrit par un en-tête (NetFileHeader)
+//!
+//! Les dimensions de l'accumulateur doivent être celles du programme ;
+//! les tailles des couches denses sont libres (≤ MAX_LAYER_SIZE).
+//! En cas d'erreur, le réseau courant est conservé.
+//! Aucune instance de NNUE ne doit exister pendant l'appel :
+//! voir ThreadPool::load_network.
+//!
+//! \param[in] filename     nom du fichier
+//! \return "true" si le réseau a été chargé
+//------------------------------------------------------
+bool NNUE::load_file(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+    {
+        std::cout << "info string NNUE : impossible d'ouvrir le fichier " << filename << std::endl;
+        return false;
+    }
+
+    NetFileHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (!file || !header_ok(header))
+    {
+        std::cout << "info string NNUE : format de fichier incompatible (" << filename << ")" << std::endl;
+        return false;
+    }
+
+    // empreinte des données, si le fichier en contient une (nnsave)
+    if (header_checksum(header) != 0)
+    {
+        std::vector<char> chunk(1024 * 1024);
+        U64    h    = NET_HASH_SEED;
+        size_t size = 0;
+        while (file.read(chunk.data(), static_cast<std::streamsize>(chunk.size())) || file.gcount() > 0)
+        {
+            const size_t n = static_cast<size_t>(file.gcount());
+            h     = net_hash_update(h, reinterpret_cast<const unsigned char*>(chunk.data()), n);
+            size += n;
+        }
+        if (net_hash_final(h, size) != header_checksum(header))
+        {
+            std::cout << "info string NNUE : empreinte incorrecte, fichier corrompu (" << filename << ")" << std::endl;
+            return false;
+        }
+        file.clear();
+        file.seekg(sizeof(header));
+    }
+
+    auto net = std::make_unique<Network>();
+    file.read(reinterpret_cast<char*>(net->feature_weights.data()), sizeof(net->feature_weights));
+    file.read(reinterpret_cast<char*>(net->feature_biases.data()),  sizeof(net->feature_biases));
+
+    std::unique_ptr<LayerStack> stack;
+    if (header.l1_size == 0)
+    {
+        file.read(reinterpret_cast<char*>(net->output_weights.data()), sizeof(net->output_weights));
+        file.read(reinterpret_cast<char*>(net->output_bias.data()),    sizeof(net->output_bias));
+    }
+    else
+    {
+        net->output_weights.fill(0);
+        net->output_bias.fill(0);
+        stack = std::make_unique<LayerStack>(header.l1_size, header.l2_size,
+                                             header.l1_shift, header.l2_shift, header.eval_divisor);
+        stack->read(file);
+    }
+
+    if (!file || file.peek() != std::ifstream::traits_type::eof())
+    {
+        std::cout << "info string NNUE : taille de fichier incorrecte (" << filename << ")" << std::endl;
+        return false;
+    }
+
+    forget_derived();
+
+    loaded_network = std::move(net);
+    loaded_layers  = std::move(stack);
+    mapped_network = nullptr;
+    mapped_file.reset();
+
+    std::cout << "info string NNUE : réseau " << filename << " chargé ("
+              << HIDDEN_LAYER_SIZE << "x2";
+    if (loaded_layers)
+        std::cout << " -> " << loaded_layers->get_l1_size() << " -> " << loaded_layers->get_l2_size();
+    std::cout << " -> 1)" << std::endl;
+
+    return true;
+}
+
+//======================================================
+//! \brief  Sauvegarde du réseau principal, au format lu par load_file
+//! Permet par exemple de convertir le réseau embarqué (format Bullet,
+//! sans en-tête) en fichier décrit par son en-tête.
+//!
+//! \param[in] filename     nom du fichier
+//! \return "true" si l'écriture a réussi
+//------------------------------------------------------
+bool NNUE::save_file(const std::string& filename)
+{
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cout << "info string NNUE : impossible de créer le fichier " << filename << std::endl;
+        return false;
+    }
+
+    const Network*    net   = main_network();
+    const LayerStack* stack = main_layers();
+
+    NetFileHeader header{};
+    std::memcpy(header.magic, NET_FILE_MAGIC, sizeof(header.magic));
+    header.version        = NET_FILE_VERSION;
+    header.input_size     = INPUT_LAYER_SIZE;
+    header.king_buckets   = KING_BUCKETS_COUNT;
+    header.hidden_size    = HIDDEN_LAYER_SIZE;
+    header.output_buckets = OUTPUT_BUCKETS;
+    if (stack)
+        stack->fill_header(header);
+
+    // les données sont préparées en mémoire : leur empreinte va dans l'en-tête
+    std::ostringstream payload;
+    payload.write(reinterpret_cast<const char*>(net->feature_weights.data()), sizeof(net->feature_weights));
+    payload.write(reinterpret_cast<const char*>(net->feature_biases.data()),  sizeof(net->feature_biases));
+
+    if (stack)
+    {
+        stack->write(payload);
+    }
+    else
+    {
+        payload.write(reinterpret_cast<const char*>(net->output_weights.data()), sizeof(net->output_weights));
+        payload.write(reinterpret_cast<const char*>(net->output_bias.data()),    sizeof(net->output_bias));
+    }
+
+    const std::string data = payload.str();
+    const U64 h = net_hash(reinterpret_cast<const unsigned char*>(data.data()), data.size());
+    header.checksum[0] = static_cast<U32>(h);
+    header.checksum[1] = static_cast<U32>(h >> 32);
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+
+    if (!file)
+    {
+        std::cout << "info string NNUE : erreur d'écriture (" << filename << ")" << std::endl;
+        return false;
+    }
+
+    std::cout << "info string NNUE : réseau sauvegardé dans " << filename
+              << " (empreinte " << hash_string(h) << ")" << std::endl;
+    return true;
+}
+
+//======================================================
+//! \brief  Réseau donné par l'option UCI "EvalFile"
+//!
+//! Un fichier au format du réseau embarqué (Bullet, sans en-tête), ou
+//! écrit par nnsave sans couches denses, est projeté en mémoire et lu
+//! sur place : rien n'est copié, le chargement ne coûte que le calcul
+//! de l'empreinte, et tous les moteurs lancés sur la machine partagent
+//! les mêmes pages (cache du système). Un réseau avec couches denses
+//! est lu par load_file.
+//! En cas d'erreur, ou avec "<embedded>", on revient au réseau embarqué.
+//! Aucune instance de NNUE ne doit exister pendant l'appel :
+//! voir ThreadPool::set_eval_file.
+//!
+//! \param[in] filename     nom du fichier, ou "<embedded>"
+//! \return "true" si le réseau demandé est utilisé
+//------------------------------------------------------
+bool NNUE::set_eval_file(const std::string& filename)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    forget_derived();
+    loaded_network.reset();
+    loaded_layers.reset();
+    mapped_network = nullptr;
+    mapped_file.reset();
+
+    if (filename.empty() || filename == "<embedded>")
+    {
+        std::cout << "info string NNUE : réseau embarqué " << NET_NAME << std::endl;
+        return true;
+    }
+
+    auto file = std::make_unique<MappedFile>();
+    if (!file->open(filename))
+    {
+        std::cout << "info string NNUE : impossible d'ouvrir le fichier " << filename
+                  << " ; réseau embarqué utilisé" << std::endl;
+        return false;
+    }
+
+    // fichier écrit par nnsave (en-tête), ou poids bruts comme le réseau embarqué
+    NetFileHeader header{};
+    if (file->size() >= sizeof(header))
+        std::memcpy(&header, file->data(), sizeof(header));
+    const bool   has_header = std::memcmp(header.magic, NET_FILE_MAGIC, sizeof(header.magic)) == 0;
+    const size_t offset     = has_header ? sizeof(header) : 0;
+
+    if (has_header && !header_ok(header))
+    {
+        std::cout << "info string NNUE : format de fichier incompatible (" << filename
+                  << ") ; réseau embarqué utilisé" << std::endl;
+        return false;
+    }
+
+    if (has_header && header.l1_size != 0)
+    {
+        file.reset();
+        if (load_file(filename))
+            return true;
+        std::cout << "info string NNUE : réseau embarqué utilisé" << std::endl;
+        return false;
+    }
+
+    if (file->size() != offset + NET_RAW_SIZE)
+    {
+        std::cout << "info string NNUE : taille de fichier incorrecte (" << filename << " : "
+                  << file->size() << " octets, " << offset + NET_RAW_SIZE << " attendus) ; réseau embarqué utilisé" << std::endl;
+        return false;
+    }
+
+    const U64 h = net_hash(file->data() + offset, NET_RAW_SIZE);
+    if (has_header && header_checksum(header) != 0 && header_checksum(header) != h)
+    {
+        std::cout << "info string NNUE : empreinte incorrecte, fichier corrompu (" << filename
+                  << ") ; réseau embarqué utilisé" << std::endl;
+        return false;
+    }
+
+    // Le remplissage final de Network (alignement) dépasse la fin du fichier :
+    // il doit rester dans la dernière page projetée, sinon on copie les poids.
+    constexpr size_t PAGE = 4096;
+    const bool in_place = (offset + sizeof(Network) + PAGE - 1) / PAGE <= (file->size() + PAGE - 1) / PAGE;
+
+    if (in_place)
+    {
+        mapped_file    = std::move(file);
+        mapped_network = mapped_as<Network>(mapped_file->data(), offset);
+    }
+    else
+    {
+        auto net = std::make_unique<Network>();
+        std::memcpy(static_cast<void*>(net.get()), file->data() + offset, NET_RAW_SIZE);
+        loaded_network = std::move(net);
+    }
+
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "info string NNUE : réseau " << filename
+              << (in_place ? " projeté en mémoire (" : " copié (")
+              << NET_RAW_SIZE / 1024 / 1024 << " Mo, empreinte " << hash_string(h)
+              << (in_place && mapped_file->huge_pages() ? ", huge pages" : "")
+              << ", " << std::fixed << std::setprecision(1) << ms << " ms)" << std::endl;
+
+    return true;
+}
+
+//======================================================
+//! \brief  Publie le réseau principal en mémoire partagée (option UCI "SharedNetwork")
+//!
+//! Le segment est nommé d'après l'empreinte des poids : le premier
+//! processus qui utilise ce réseau le crée et le remplit, les autres
+//! s'y attachent en lecture seule. Les poids n'occupent alors qu'une
+//! fois la mémoire (et le cache L3) de la machine, même pour des
+//! exécutables différents ou un réseau chargé par nnload, dont la
+//! copie privée est libérée.
+//! Le segment reste dans /dev/shm après la fin des processus, pour
+//! les moteurs lancés ensuite (voir clean_shared).
+//! Aucune instance de NNUE ne doit exister pendant l'appel :
+//! voir ThreadPool::set_shared_network.
+//!
+//! \param[in] on   publier (true), ou revenir au réseau privé (false)
+//! \return "true" si le réseau est dans l'état demandé
+//------------------------------------------------------
+bool NNUE::set_shared(bool on)
+{
+    if (!on || shared_network != nullptr)
+    {
+        if (!on && shared_network != nullptr)
+        {
+            // la copie privée avait été libérée : on la refait
+            if (shared_owns_copy)
+                loaded_network = std::make_unique<Network>(*shared_network);
+            shared_owns_copy = false;
+            shared_network   = nullptr;
+            shared_segment.reset();
+            shared_name.clear();
+            forget_derived();
+        }
+        return true;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    const Network* net  = main_network();
+    const U64      h    = net_hash(reinterpret_cast<const unsigned char*>(net), NET_RAW_SIZE);
+    const size_t   size = SHARED_NET_OFFSET + sizeof(Network);
+    const std::string name = SHARED_NET_PREFIX + hash_string(h).substr(2) + "-" + std::to_string(sizeof(Network));
+
+    auto seg    = std::make_unique<SharedSegment>();
+    auto status = SharedSegment::Status::FAILED;
+    bool ready  = false;
+
+    // Un segment existant peut être en cours de remplissage par son créateur :
+    // on attend qu'il soit prêt. Au-delà de 2 s, son créateur s'est arrêté
+    // avant la fin ; le segment est supprimé et recréé.
+    for (int tries = 0; tries <= 200 && !ready; tries++)
+    {
+        if (tries == 200)
+            SharedSegment::remove(name);
+
+        status = seg->open(name, size);
+        if (status == SharedSegment::Status::CREATED)
+            break;
+        if (status == SharedSegment::Status::ATTACHED)
+        {
+            auto* hdr = mapped_as<SharedNetHeader>(seg->data());
+            ready = std::atomic_ref<U32>(hdr->ready).load(std::memory_order_acquire) == 1;
+            if (ready)
+                break;
+        }
+        seg->close();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    if (status == SharedSegment::Status::CREATED)
+    {
+        auto* hdr = mapped_as<SharedNetHeader>(seg->data());
+        std::memcpy(seg->data() + SHARED_NET_OFFSET, static_cast<const void*>(net), sizeof(Network));
+        std::memcpy(hdr->magic, SHARED_NET_MAGIC, sizeof(hdr->magic));
+        hdr->hash = h;
+        hdr->size = sizeof(Network);
+        std::atomic_ref<U32>(hdr->ready).store(1, std::memory_order_release);
+        seg->seal();
+    }
+    else if (status == SharedSegment::Status::ATTACHED)
+    {
+        // le nom ne suffit pas : on vérifie l'en-tête et les poids eux-mêmes
+        const auto* hdr = mapped_as<const SharedNetHeader>(seg->data());
+        if (   std::memcmp(hdr->magic, SHARED_NET_MAGIC, sizeof(hdr->magic)) != 0
+            || hdr->hash != h
+            || hdr->size != sizeof(Network)
+            || net_hash(seg->data() + SHARED_NET_OFFSET, NET_RAW_SIZE) != h)
+        {
+            std::cout << "info string NNUE : segment partagé " << name << " invalide ; réseau privé conservé" << std::endl;
+            return false;
+        }
+    }
+    else
+    {
+        std::cout << "info string NNUE : mémoire partagée indisponible (" << name << ") ; réseau privé conservé" << std::endl;
+        return false;
+    }
+
+    shared_network = mapped_as<const Network>(seg->data(), SHARED_NET_OFFSET);
+    shared_segment = std::move(seg);
+    shared_name    = name;
+    forget_derived();
+
+    // la copie privée d'un réseau chargé par nnload n'est plus utile
+    if (loaded_network)
+    {
+        loaded_network.reset();
+        shared_owns_copy = true;
+    }
+
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "info string NNUE : réseau partagé " << name
+              << (status == SharedSegment::Status::CREATED ? " (créé, " : " (attaché, ")
+              << std::fixed << std::setprecision(1) << ms << " ms)" << std::endl;
+
+    return true;
+}
+
+//======================================================
+//! \brief  Supprime les segments partagés laissés dans /dev/shm
+//!
+//! Chaque réseau publié par set_shared laisse un segment (de la taille
+//! du réseau) après la fin des processus : essayer une série de réseaux
+//! avec EvalFile les accumule. Le segment du réseau partagé courant est
+//! conservé ; les processus attachés à un segment supprimé le gardent
+//! jusqu'à leur fin, mais les moteurs lancés ensuite en créent un autre.
+//!
+//! \return Nombre de segments supprimés
+//------------------------------------------------------
+int NNUE::clean_shared()
+{
+    int removed = 0;
+    for (const auto& name : SharedSegment::list(SHARED_NET_PREFIX))
+    {
+        if (name != shared_name && SharedSegment::remove(name))
+            removed++;
+    }
+
+    std::cout << "info string NNUE : " << removed << " segment(s) partagé(s) supprimé(s)" << std::endl;
+    return removed;
+}
+
+//======================================================
+//! \brief  Retourne la copie du réseau propre au nœud NUMA "node"
+//!
+//! La copie est créée au premier appel pour ce nœud. Elle doit être
+//! demandée par une thread attachée au nœud : c'est elle qui écrit
+//! la copie, et le noyau place donc sa mémoire sur ce nœud.
+//! Les lectures des poids (refresh, updates) restent ainsi locales,
+//! au lieu de traverser le lien entre les sockets.
+//! Un réseau partagé (set_shared) n'est pas copié : une copie par
+//! nœud et par processus annulerait l'économie de mémoire.
+//!
+//! \param[in] node     indice du nœud NUMA
+//! \return Pointeur sur la copie du réseau, ou le réseau partagé
+//------------------------------------------------------
+const Network* NNUE::node_network(size_t node)
+{
+    if (shared_network != nullptr)
+        return shared_network;
+
+    std::lock_guard<std::mutex> lock(replicas_mutex);
+
+    if (replicas.size() <= node)
+        replicas.resize(node + 1);
+    if (!replicas[node])
+        replicas[node] = std::make_unique<Network>(*main_network());
+
+    return replicas[node].get();
 }
 
 
@@ -44,6 +687,24 @@ int NNUE::evaluate(const Accumulator& current, size_t count)
     auto output = 0;
     const int bucket = get_bucket(count);
 
+    if (layers != nullptr)
+    {
+        if constexpr (color == Color::WHITE)
+            return layers->propagate<true>(current.white, current.black, bucket, *kernels);
+        else
+            return layers->propagate<true>(current.black, current.white, bucket, *kernels);
+    }
+
+#if defined USE_VNNI
+    if (output_i8 != nullptr)
+    {
+        if constexpr (color == Color::WHITE)
+            return activation_i8(current.white, current.black, bucket);
+        else
+            return activation_i8(current.black, current.white, bucket);
+    }
+#endif
+
     if constexpr (color == Color::WHITE)
         output = activation(current.white, current.black, network->output_weights, bucket);
     else
@@ -59,11 +720,12 @@ int NNUE::evaluate(const Accumulator& current, size_t count)
 //----------------------------------------------------
 void NNUE::start_search(const Board& board)
 {
-    head_idx = 0;
+    head_idx   = 0;
+    lazy_stats = LazyStats{};
 
     for (int i = 0; i < 2; i++)
         for (int j = 0; j < KING_BUCKETS_COUNT; j++)
-            finny[i][j].init();
+            finny[i][j].init(network->feature_biases);
 
     Accumulator& head = stack[0];
 
@@ -113,7 +775,7 @@ void NNUE::rebase(const Board& board)
     // des bitboards obsolètes après le rebase
     for (int i = 0; i < 2; i++)
         for (int j = 0; j < KING_BUCKETS_COUNT; j++)
-            finny[i][j].init();
+            finny[i][j].init(network->feature_biases);
 }
 
 //====================================================
@@ -146,12 +808,14 @@ void NNUE::init_accumulator(Accumulator& acc)
 
 //====================================================
 //! \brief  Re-initalise les tables Finny
+//!
+//! \param[in] biases   biais de la couche d'entrée du réseau utilisé
 //----------------------------------------------------
-void FinnyEntry::init()
+void FinnyEntry::init(std::span<const I16, HIDDEN_LAYER_SIZE> biases)
 {
     typePiecesBB.fill({});
     colorPiecesBB.fill({});
-    accumulator.init_biases(network->feature_biases);
+    accumulator.init_biases(biases);
 }
 
 //========================================================================
@@ -180,6 +844,9 @@ void NNUE::add(Accumulator& accu, Piece piece, SQUARE from, SQUARE wking, SQUARE
 //=========================================
 //! \brief  Calcul de la valeur résultante des 2 accumulateurs et de leur poids
 //!
+//! Le produit SCReLU × output_weights est fait par le noyau choisi
+//! pour ce CPU (NnueKernels::activation).
+//!
 //! \param[in] us       accumulateur (HIDDEN_LAYER_SIZE) de la perspective du joueur actif
 //! \param[in] them     accumulateur (HIDDEN_LAYER_SIZE) de la perspective de l'adversaire
 //! \param[in] weights  output_weights du réseau (toutes perspectives, tous buckets)
@@ -190,54 +857,12 @@ void NNUE::add(Accumulator& accu, Piece piece, SQUARE from, SQUARE wking, SQUARE
 //! Ref : https://cosmo.tardis.ac/files/2024-06-01-nnue.html
 //! On va utiliser l'algorithme "Lizard"
 //-----------------------------------------
-#if defined USE_SIMD
-
-constexpr int kChunkSize = sizeof(simd::Vepi16) / sizeof(I16);
-
 I32 NNUE::activation(const std::array<I16, HIDDEN_LAYER_SIZE>& us,
                      const std::array<I16, HIDDEN_LAYER_SIZE>& them,
                      const std::array<I16, HIDDEN_LAYER_SIZE * N_COLORS * OUTPUT_BUCKETS>& weights,
                      const int bucket)
 {
-    const int adresse = bucket * N_COLORS * HIDDEN_LAYER_SIZE;
-
-    auto sum = simd::ZeroEpi32();
-
-    // Perspective du joueur actif (us)
-    for (size_t i = 0; i < HIDDEN_LAYER_SIZE; i += kChunkSize)
-    {
-        const auto input   = simd::LoadEpi16(&us[i]);
-        const auto weight  = simd::LoadEpi16(&weights[adresse + i]);
-
-        // Écrêtage : clamp(acc, 0, QA) → valeur entre 0 et 255
-        const auto clipped = simd::Clip(input, QA);
-
-        // 1ère multiplication : clipped × weight → I16
-        // Pas d'overflow : 255 × 127 = 32385 < 32767 (max I16)
-        const auto product = simd::MultiplyEpi16(clipped, weight);
-
-        // 2ème multiplication avec élargissement vers I32 (madd) :
-        // result[i] = product[2i] × clipped[2i] + product[2i+1] × clipped[2i+1]
-        //           = clipped² × weight  (SCReLU = activation au carré)
-        const auto result  = simd::MultiplyAddEpi16(product, clipped);
-
-        // Accumulation en I32
-        sum = simd::AddEpi32(sum, result);
-    }
-
-    // Perspective de l'adversaire (them)
-    for (size_t i = 0; i < HIDDEN_LAYER_SIZE; i += kChunkSize)
-    {
-        const auto input   = simd::LoadEpi16(&them[i]);
-        const auto weight  = simd::LoadEpi16(&weights[adresse + HIDDEN_LAYER_SIZE + i]);
-        const auto clipped = simd::Clip(input, QA);
-        const auto product = simd::MultiplyEpi16(clipped, weight);
-        const auto result  = simd::MultiplyAddEpi16(product, clipped);
-        sum = simd::AddEpi32(sum, result);
-    }
-
-    // Réduction horizontale : somme tous les I32 du vecteur en un seul scalaire
-    I32 eval = simd::ReduceAddEpi32(sum);
+    I32 eval = kernels->activation(us.data(), them.data(), &weights[bucket * N_COLORS * HIDDEN_LAYER_SIZE]);
 
     // Dé-quantification : sum est à l'échelle QA²×QB → on divise par QA → échelle QA×QB
     eval /= QA;
@@ -252,33 +877,78 @@ I32 NNUE::activation(const std::array<I16, HIDDEN_LAYER_SIZE>& us,
     return eval;
 }
 
-#else
+#if defined USE_VNNI
+
+//======================================================
+//! \brief  Retourne les poids de sortie int8 du réseau "net"
+//!
+//! La conversion est faite au premier appel pour ce réseau et ces noyaux,
+//! puis partagée par toutes les instances qui l'utilisent.
+//! Dans chaque bloc de 2 vecteurs de neurones, les poids sont
+//! rangés dans l'ordre des octets produits par PackUsEpi16 :
+//! pour chaque bloc de 128 bits, 8 neurones du 1er vecteur,
+//! puis les 8 neurones correspondants du 2nd.
+//!
+//! \param[in] net      réseau à convertir
+//! \param[in] kern     noyaux utilisés (taille des vecteurs)
+//! \return Poids int8, ou nullptr si un poids sort de [-128, 127]
+//!         ou si ces noyaux n'ont pas de couche de sortie int8
+//------------------------------------------------------
+const OutputWeightsI8* NNUE::quantized_output(const Network* net, const NnueKernels& kern)
+{
+    if (kern.activation_i8 == nullptr)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(quantized_mutex);
+
+    const size_t chunk_size = kern.vector_bytes / sizeof(I16);
+
+    for (const auto& [source, size, weights] : quantized)
+        if (source == net && size == chunk_size)
+            return weights.get();
+
+    auto result = std::make_unique<OutputWeightsI8>();
+    bool valid  = true;
+
+    const size_t     block = 2 * chunk_size;
+    constexpr size_t lane  = 16 / sizeof(I16);      // I16 par bloc de 128 bits
+
+    for (size_t base = 0; base < net->output_weights.size(); base += block)
+    {
+        for (size_t p = 0; p < block; p++)
+        {
+            const size_t l   = p / 16;
+            const size_t k   = p % 16;
+            const size_t src = (k < lane) ? l * lane + k : chunk_size + l * lane + (k - lane);
+            const I16    w   = net->output_weights[base + src];
+
+            if (w < -128 || w > 127)
+                valid = false;
+            result->weights[base + p] = static_cast<I08>(w);
+        }
+    }
+
+    quantized.emplace_back(net, chunk_size, valid ? std::move(result) : nullptr);
+    return std::get<2>(quantized.back()).get();
+}
 
 //=========================================
-//! \brief  Évaluation SCReLU + produit matrice-vecteur (activations × output_weights) → score en centipions
+//! \brief  Calcul de la couche de sortie avec des poids int8 (VNNI)
 //!
-//! Fallback scalaire (sans SIMD) — même algorithme SCReLU Lizard que la version SIMD ci-dessus
+//! Même résultat, au bit près, que activation() : voir le noyau
+//! NnueKernels::activation_i8.
 //!
 //! \param[in] us       accumulateur (HIDDEN_LAYER_SIZE) de la perspective du joueur actif
 //! \param[in] them     accumulateur (HIDDEN_LAYER_SIZE) de la perspective de l'adversaire
-//! \param[in] weights  output_weights du réseau (toutes perspectives, tous buckets)
 //! \param[in] bucket   output bucket sélectionné (selon le nb de pièces restantes)
 //!
 //! \return Score en centipions
 //-----------------------------------------
-I32 NNUE::activation(const std::array<I16, HIDDEN_LAYER_SIZE>& us,
-                     const std::array<I16, HIDDEN_LAYER_SIZE>& them,
-                     const std::array<I16, HIDDEN_LAYER_SIZE * N_COLORS * OUTPUT_BUCKETS>& weights,
-                     const int bucket)
+I32 NNUE::activation_i8(const std::array<I16, HIDDEN_LAYER_SIZE>& us,
+                        const std::array<I16, HIDDEN_LAYER_SIZE>& them,
+                        const int bucket)
 {
-    I32 eval = 0;
-    const int adresse = bucket * N_COLORS * HIDDEN_LAYER_SIZE;
-
-    for (size_t i = 0; i < HIDDEN_LAYER_SIZE; ++i)
-    {
-        eval += screlu(us[i])   * weights[adresse + i];
-        eval += screlu(them[i]) * weights[adresse + HIDDEN_LAYER_SIZE + i];
-    }
+    I32 eval = kernels->activation_i8(us.data(), them.data(), &output_i8->weights[bucket * N_COLORS * HIDDEN_LAYER_SIZE]);
 
     eval /= QA;
     eval += network->output_bias[bucket];
@@ -332,6 +1002,7 @@ void NNUE::lazy_update(const Board &board, Accumulator& acc)
             // Comme le cout d'un raffraichissement est important
             // autant le faire sur le dernier accumulateur : acc
             refresh_accumulator<side>(board, acc);
+            lazy_stats.refresh++;
             break;
         }
 
@@ -339,14 +1010,26 @@ void NNUE::lazy_update(const Board &board, Accumulator& acc)
         if (stack[iter].updated[side] == true)
         {
             size_t last_updated = iter;
+            const size_t length = head_idx - iter;
+
+            lazy_stats.chain[std::min(length, size_t(3)) - 1]++;
 
-            // on va remonter les accumulateurs;
-            // et les updater un par un
-            while (last_updated != head_idx)
+            // on va remonter les accumulateurs jusqu'au parent, par paquets
+            // de MAX_FUSED_PLIES coups : seul le dernier accumulateur de chaque
+            // paquet est calculé, les accumulateurs intermédiaires restent "dirty".
+            // Le parent est calculé car ses autres enfants vont le réutiliser ;
+            // sinon chacun d'eux referait toute la chaîne.
+            while (last_updated + 1 < head_idx)
             {
-                update<side>(stack[last_updated], stack[last_updated+1], king);
-                last_updated++;
+                const size_t next = std::min(last_updated + MAX_FUSED_PLIES, head_idx - 1);
+                if (next == last_updated + 1)
+                    update<side>(stack[last_updated], stack[next], king);
+                else
+                    fused_update<side>(last_updated, next, king);
+                last_updated = next;
             }
+
+            update<side>(stack[last_updated], acc, king);
             break;
         }
     }
@@ -420,6 +1103,85 @@ void NNUE::update(const Accumulator& src, Accumulator& dst, SQUARE king)
     dst.updated[side] = true;
 }
 
+//===================================================================
+//! \brief  Prise en compte, en une seule passe, des modifications de
+//!         plusieurs coups consécutifs
+//!
+//! Les features ajoutées et supprimées par les coups des accumulateurs
+//! first+1 ... last sont rassemblées (une feature ajoutée puis supprimée
+//! s'annule), puis appliquées à stack[first] par tuiles de registres :
+//! chaque tuile de l'accumulateur n'est lue et écrite qu'une seule fois.
+//! Les accumulateurs intermédiaires ne sont pas calculés.
+//! Les additions int16 étant modulo 2^16, le résultat est identique
+//! à celui des updates successives.
+//!
+//! \param[in]  first   indice du dernier accumulateur à jour
+//! \param[in]  last    indice de l'accumulateur à calculer
+//! \param[in]  king    case du roi de cette perspective
+//--------------------------------------------------------------------
+template <Color side>
+void NNUE::fused_update(size_t first, size_t last, SQUARE king)
+{
+    assert(last > first && last - first <= MAX_FUSED_PLIES);
+
+    U32 adds[2 * MAX_FUSED_PLIES];
+    U32 subs[2 * MAX_FUSED_PLIES];
+    size_t nbr_adds = 0;
+    size_t nbr_subs = 0;
+
+    // une feature ajoutée par un coup, puis supprimée par un autre, s'annule
+    auto push = [](U32 idx, U32* list, size_t& count, U32* other, size_t& other_count)
+    {
+        for (size_t n = 0; n < other_count; n++)
+        {
+            if (other[n] == idx)
+            {
+                other[n] = other[--other_count];
+                return;
+            }
+        }
+        list[count++] = idx;
+    };
+
+    for (size_t ply = first + 1; ply <= last; ply++)
+    {
+        const DirtyPieces& dp = stack[ply].dirtyPieces;
+
+        push(get_indice<side>(dp.sub_1.piece, dp.sub_1.square, king), subs, nbr_subs, adds, nbr_adds);
+        push(get_indice<side>(dp.add_1.piece, dp.add_1.square, king), adds, nbr_adds, subs, nbr_subs);
+        if (dp.type != DirtyPieces::NORMAL)
+            push(get_indice<side>(dp.sub_2.piece, dp.sub_2.square, king), subs, nbr_subs, adds, nbr_adds);
+        if (dp.type == DirtyPieces::CASTLING)
+            push(get_indice<side>(dp.add_2.piece, dp.add_2.square, king), adds, nbr_adds, subs, nbr_subs);
+    }
+
+    const I16* src = (side == WHITE) ? stack[first].white.data() : stack[first].black.data();
+          I16* dst = (side == WHITE) ? stack[last].white.data()  : stack[last].black.data();
+
+    apply_features(src, dst, nullptr, adds, nbr_adds, subs, nbr_subs);
+
+    stack[last].updated[side] = true;
+}
+
+//===================================================================
+//! \brief  Ajoute et supprime une liste de features d'une perspective,
+//!         par tuiles de registres (NnueKernels::apply_features)
+//!
+//! \param[in]  src         perspective source
+//! \param[out] dst         perspective destination (peut être src)
+//! \param[out] copy        seconde destination (nullptr si aucune)
+//! \param[in]  adds        indices des features ajoutées
+//! \param[in]  nbr_adds    nombre de features ajoutées
+//! \param[in]  subs        indices des features supprimées
+//! \param[in]  nbr_subs    nombre de features supprimées
+//--------------------------------------------------------------------
+void NNUE::apply_features(const I16* src, I16* dst, I16* copy,
+                          const U32* adds, size_t nbr_adds,
+                          const U32* subs, size_t nbr_subs)
+{
+    kernels->apply_features(network->feature_weights.data(), src, dst, copy, adds, nbr_adds, subs, nbr_subs);
+}
+
 //========================================================================
 //! \brief  Calcule l'indice du triplet (couleur, piece, case)
 //! dans l'Input Layer
@@ -512,87 +1274,6 @@ U32 NNUE::get_indice(Piece piece, SQUARE square, SQUARE king)
     }
 }
 
-//================================================================
-//! \brief  Ajoute une pièce (SIMD, une seule perspective)
-//! \param[in,out] accu     accumulateur de cette perspective à mettre à jour
-//! \param[in]     piece    pièce à ajouter
-//! \param[in]     from     position de cette pièce
-//! \param[in]     king     position du roi de couleur "US"
-//----------------------------------------------------------------
-template <Color side>
-void NNUE::add(Accumulator& accu, Piece piece, SQUARE from, SQUARE king)
-{
-    const auto idx = get_indice<side>(piece, from, king);
-
-#if defined USE_SIMD
-    constexpr int simd_width = sizeof(simd::Vepi16) / sizeof(I16);
-
-    for (size_t i = 0; i < HIDDEN_LAYER_SIZE; i += simd_width)
-    {
-        if constexpr (side == WHITE)
-        {
-            simd::StoreEpi16(&accu.white[i], simd::AddEpi16(simd::LoadEpi16(&accu.white[i]), simd::LoadEpi16(&network->feature_weights[idx * HIDDEN_LAYER_SIZE + i])));
-        }
-        else
-        {
-            simd::StoreEpi16(&accu.black[i], simd::AddEpi16(simd::LoadEpi16(&accu.black[i]), simd::LoadEpi16(&network->feature_weights[idx * HIDDEN_LAYER_SIZE + i])));
-        }
-    }
-#else
-
-    if constexpr (side == WHITE)
-    {
-        for (size_t i = 0; i < HIDDEN_LAYER_SIZE; ++i)
-            accu.white[i] += network->feature_weights[idx * HIDDEN_LAYER_SIZE + i];
-    }
-    else
-    {
-        for (size_t i = 0; i < HIDDEN_LAYER_SIZE; ++i)
-            accu.black[i] += network->feature_weights[idx * HIDDEN_LAYER_SIZE + i];
-    }
-#endif
-}
-
-//================================================================
-//! \brief  Supprime une pièce (SIMD, une seule perspective)
-//! \param[in,out] accu     accumulateur de cette perspective à mettre à jour
-//! \param[in]     piece    pièce à supprimer
-//! \param[in]     from     position de cette pièce
-//! \param[in]     king     position du roi de couleur "US"
-//----------------------------------------------------------------
-template <Color side>
-void NNUE::sub(Accumulator& accu, Piece piece, SQUARE from, SQUARE king)
-{
-    const auto idx = get_indice<side>(piece, from, king);
-
-#if defined USE_SIMD
-    constexpr int simd_width = sizeof(simd::Vepi16) / sizeof(I16);
-
-    for (size_t i = 0; i < HIDDEN_LAYER_SIZE; i += simd_width)
-    {
-        if constexpr (side == WHITE)
-        {
-            simd::StoreEpi16(&accu.white[i], simd::SubEpi16(simd::LoadEpi16(&accu.white[i]), simd::LoadEpi16(&network->feature_weights[idx * HIDDEN_LAYER_SIZE + i])));
-        }
-        else
-        {
-            simd::StoreEpi16(&accu.black[i], simd::SubEpi16(simd::LoadEpi16(&accu.black[i]), simd::LoadEpi16(&network->feature_weights[idx * HIDDEN_LAYER_SIZE + i])));
-        }
-    }
-#else
-    if constexpr (side == WHITE)
-    {
-        for (size_t i = 0; i < HIDDEN_LAYER_SIZE; ++i)
-            accu.white[i] -= network->feature_weights[idx * HIDDEN_LAYER_SIZE + i];
-    }
-    else
-    {
-        for (size_t i = 0; i < HIDDEN_LAYER_SIZE; ++i)
-            accu.black[i] -= network->feature_weights[idx * HIDDEN_LAYER_SIZE + i];
-    }
-#endif
-}
-
 //=================================================================================
 //! \brief  Update combiné : Ajout + Suppression
 //! \param[in]  src         accumulateur source (précédent, à jour)
@@ -613,49 +1294,12 @@ void NNUE::sub_add(const Accumulator& src, Accumulator& dst,
 
     const auto sub_idx = get_indice<side>(sub_piece, sub, king);
     const auto add_idx = get_indice<side>(add_piece, add, king);
+    const I16* weights = network->feature_weights.data();
 
-#if defined USE_SIMD
-    constexpr int simd_width = sizeof(simd::Vepi16) / sizeof(I16);
-
-    for (size_t i = 0; i < HIDDEN_LAYER_SIZE; i += simd_width)
-    {
-        if constexpr (side == WHITE)
-        {
-            auto cur_w  = simd::LoadEpi16(&src.white[i]);
-            //TODO sub_add ou add_sub ??
-            cur_w       = simd::SubEpi16(cur_w, simd::LoadEpi16(&network->feature_weights[sub_idx * HIDDEN_LAYER_SIZE + i]));
-            cur_w       = simd::AddEpi16(cur_w, simd::LoadEpi16(&network->feature_weights[add_idx * HIDDEN_LAYER_SIZE + i]));
-            simd::StoreEpi16(&dst.white[i], cur_w);
-        }
-        else
-        {
-            auto cur_w  = simd::LoadEpi16(&src.black[i]);
-            //TODO sub_add ou add_sub ??
-            cur_w       = simd::SubEpi16(cur_w, simd::LoadEpi16(&network->feature_weights[sub_idx * HIDDEN_LAYER_SIZE + i]));
-            cur_w       = simd::AddEpi16(cur_w, simd::LoadEpi16(&network->feature_weights[add_idx * HIDDEN_LAYER_SIZE + i]));
-            simd::StoreEpi16(&dst.black[i], cur_w);
-        }
-    }
-#else
-    if constexpr (side == WHITE)
-    {
-        for (size_t i = 0; i < HIDDEN_LAYER_SIZE; ++i)
-        {
-            dst.white[i] = src.white[i]
-                    + network->feature_weights[add_idx * HIDDEN_LAYER_SIZE + i]
-                    - network->feature_weights[sub_idx * HIDDEN_LAYER_SIZE + i];
-        }
-    }
-    else
-    {
-        for (size_t i = 0; i < HIDDEN_LAYER_SIZE; ++i)
-        {
-            dst.black[i] = src.black[i]
-                    + network->feature_weights[add_idx * HIDDEN_LAYER_SIZE + i]
-                    - network->feature_weights[sub_idx * HIDDEN_LAYER_SIZE + i];
-        }
-    }
-#endif
+    kernels->sub_add((side == WHITE) ? src.white.data() : src.black.data(),
+                     (side == WHITE) ? dst.white.data() : dst.black.data(),
+                     &weights[add_idx * HIDDEN_LAYER_SIZE],
+                     &weights[sub_idx * HIDDEN_LAYER_SIZE]);
 }
 
 
@@ -684,54 +1328,13 @@ void NNUE::sub_sub_add(const Accumulator& src, Accumulator& dst,
     const auto sub1_idx = get_indice<side>(sub_piece_1, sub_1, king);
     const auto sub2_idx = get_indice<side>(sub_piece_2, sub_2, king);
     const auto add1_idx = get_indice<side>(add_piece_1, add_1, king);
+    const I16* weights  = network->feature_weights.data();
 
-#if defined USE_SIMD
-    constexpr int simd_width = sizeof(simd::Vepi16) / sizeof(I16);
-
-    if constexpr (side == WHITE)
-    {
-        for (size_t i = 0; i < HIDDEN_LAYER_SIZE; i += simd_width)
-        {
-            auto cur_w = simd::LoadEpi16(&src.white[i]);
-            cur_w      = simd::AddEpi16(cur_w, simd::LoadEpi16(&network->feature_weights[add1_idx * HIDDEN_LAYER_SIZE + i]));
-            cur_w      = simd::SubEpi16(cur_w, simd::LoadEpi16(&network->feature_weights[sub1_idx * HIDDEN_LAYER_SIZE + i]));
-            cur_w      = simd::SubEpi16(cur_w, simd::LoadEpi16(&network->feature_weights[sub2_idx * HIDDEN_LAYER_SIZE + i]));
-            simd::StoreEpi16(&dst.white[i], cur_w);
-        }
-    }
-    else
-    {
-        for (size_t i = 0; i < HIDDEN_LAYER_SIZE; i += simd_width)
-        {
-            auto cur_w = simd::LoadEpi16(&src.black[i]);
-            cur_w      = simd::AddEpi16(cur_w, simd::LoadEpi16(&network->feature_weights[add1_idx * HIDDEN_LAYER_SIZE + i]));
-            cur_w      = simd::SubEpi16(cur_w, simd::LoadEpi16(&network->feature_weights[sub1_idx * HIDDEN_LAYER_SIZE + i]));
-            cur_w      = simd::SubEpi16(cur_w, simd::LoadEpi16(&network->feature_weights[sub2_idx * HIDDEN_LAYER_SIZE + i]));
-            simd::StoreEpi16(&dst.black[i], cur_w);
-        }
-    }
-#else
-    if constexpr (side == WHITE)
-    {
-        for (size_t i = 0; i < HIDDEN_LAYER_SIZE; ++i)
-        {
-            dst.white[i] = src.white[i]
-                    + network->feature_weights[add1_idx * HIDDEN_LAYER_SIZE + i]
-                    - network->feature_weights[sub1_idx * HIDDEN_LAYER_SIZE + i]
-                    - network->feature_weights[sub2_idx * HIDDEN_LAYER_SIZE + i];
-        }
-    }
-    else
-    {
-        for (size_t i = 0; i < HIDDEN_LAYER_SIZE; ++i)
-        {
-            dst.black[i] = src.black[i]
-                    + network->feature_weights[add1_idx * HIDDEN_LAYER_SIZE + i]
-                    - network->feature_weights[sub1_idx * HIDDEN_LAYER_SIZE + i]
-                    - network->feature_weights[sub2_idx * HIDDEN_LAYER_SIZE + i];
-        }
-    }
-#endif
+    kernels->sub_sub_add((side == WHITE) ? src.white.data() : src.black.data(),
+                         (side == WHITE) ? dst.white.data() : dst.black.data(),
+                         &weights[add1_idx * HIDDEN_LAYER_SIZE],
+                         &weights[sub1_idx * HIDDEN_LAYER_SIZE],
+                         &weights[sub2_idx * HIDDEN_LAYER_SIZE]);
 }
 
 //=================================================================================
@@ -761,59 +1364,14 @@ void NNUE::sub_sub_add_add(const Accumulator& src, Accumulator& dst,
     const auto sub2_idx = get_indice<side>(sub_piece_2, sub_2, king);
     const auto add1_idx = get_indice<side>(add_piece_1, add_1, king);
     const auto add2_idx = get_indice<side>(add_piece_2, add_2, king);
-
-#if defined USE_SIMD
-    constexpr int simd_width = sizeof(simd::Vepi16) / sizeof(I16);
-
-    if constexpr (side == WHITE)
-    {
-        for (size_t i = 0; i < HIDDEN_LAYER_SIZE; i += simd_width)
-        {
-            auto cur_w = simd::LoadEpi16(&src.white[i]);
-            cur_w      = simd::AddEpi16(cur_w, simd::LoadEpi16(&network->feature_weights[add1_idx * HIDDEN_LAYER_SIZE + i]));
-            cur_w      = simd::AddEpi16(cur_w, simd::LoadEpi16(&network->feature_weights[add2_idx * HIDDEN_LAYER_SIZE + i]));
-            cur_w      = simd::SubEpi16(cur_w, simd::LoadEpi16(&network->feature_weights[sub1_idx * HIDDEN_LAYER_SIZE + i]));
-            cur_w      = simd::SubEpi16(cur_w, simd::LoadEpi16(&network->feature_weights[sub2_idx * HIDDEN_LAYER_SIZE + i]));
-            simd::StoreEpi16(&dst.white[i], cur_w);
-        }
-    }
-    else
-    {
-        for (size_t i = 0; i < HIDDEN_LAYER_SIZE; i += simd_width)
-        {
-            auto cur_w = simd::LoadEpi16(&src.black[i]);
-            cur_w      = simd::AddEpi16(cur_w, simd::LoadEpi16(&network->feature_weights[add1_idx * HIDDEN_LAYER_SIZE + i]));
-            cur_w      = simd::AddEpi16(cur_w, simd::LoadEpi16(&network->feature_weights[add2_idx * HIDDEN_LAYER_SIZE + i]));
-            cur_w      = simd::SubEpi16(cur_w, simd::LoadEpi16(&network->feature_weights[sub1_idx * HIDDEN_LAYER_SIZE + i]));
-            cur_w      = simd::SubEpi16(cur_w, simd::LoadEpi16(&network->feature_weights[sub2_idx * HIDDEN_LAYER_SIZE + i]));
-            simd::StoreEpi16(&dst.black[i], cur_w);
-        }
-    }
-#else
-    if constexpr (side == WHITE)
-    {
-        for (size_t i = 0; i < HIDDEN_LAYER_SIZE; ++i)
-        {
-            dst.white[i] = src.white[i]
-                    + network->feature_weights[add1_idx * HIDDEN_LAYER_SIZE + i]
-                    + network->feature_weights[add2_idx * HIDDEN_LAYER_SIZE + i]
-                    - network->feature_weights[sub1_idx * HIDDEN_LAYER_SIZE + i]
-                    - network->feature_weights[sub2_idx * HIDDEN_LAYER_SIZE + i];
-        }
-    }
-    else
-    {
-        for (size_t i = 0; i < HIDDEN_LAYER_SIZE; ++i)
-        {
-            dst.black[i] = src.black[i]
-                    + network->feature_weights[add1_idx * HIDDEN_LAYER_SIZE + i]
-                    + network->feature_weights[add2_idx * HIDDEN_LAYER_SIZE + i]
-                    - network->feature_weights[sub1_idx * HIDDEN_LAYER_SIZE + i]
-                    - network->feature_weights[sub2_idx * HIDDEN_LAYER_SIZE + i];
-        }
-
-    }
-#endif
+    const I16* weights  = network->feature_weights.data();
+
+    kernels->sub_sub_add_add((side == WHITE) ? src.white.data() : src.black.data(),
+                             (side == WHITE) ? dst.white.data() : dst.black.data(),
+                             &weights[add1_idx * HIDDEN_LAYER_SIZE],
+                             &weights[add2_idx * HIDDEN_LAYER_SIZE],
+                             &weights[sub1_idx * HIDDEN_LAYER_SIZE],
+                             &weights[sub2_idx * HIDDEN_LAYER_SIZE]);
 }
 
 //==========================================================================
@@ -831,6 +1389,12 @@ void NNUE::refresh_accumulator(const Board &board, Accumulator& acc)
 
     FinnyEntry& entry = finny[mirrored][king_bucket];
 
+    // au plus 32 pièces à supprimer et 32 à ajouter
+    U32 adds[32];
+    U32 subs[32];
+    size_t nbr_adds = 0;
+    size_t nbr_subs = 0;
+
     SQUARE square;
 
     for (Color color : {Color::WHITE, Color::BLACK})
@@ -846,7 +1410,7 @@ void NNUE::refresh_accumulator(const Board &board, Accumulator& acc)
             while (to_remove)
             {
                 square = BB::pop_lsb(to_remove);
-                sub<side>(entry.accumulator, Move::make_piece(color, piece), square, king_square);
+                subs[nbr_subs++] = get_indice<side>(Move::make_piece(color, piece), square, king_square);
             }
 
             // recherche des pièces à ajouter
@@ -854,24 +1418,26 @@ void NNUE::refresh_accumulator(const Board &board, Accumulator& acc)
             while (to_add)
             {
                 square = BB::pop_lsb(to_add);
-                add<side>(entry.accumulator, Move::make_piece(color, piece), square, king_square);
+                adds[nbr_adds++] = get_indice<side>(Move::make_piece(color, piece), square, king_square);
             }
         }
     }
 
+    // une seule passe sur l'accumulateur de la table,
+    // recopié en même temps dans acc
+    I16* finny_acc = (side == WHITE) ? entry.accumulator.white.data() : entry.accumulator.black.data();
+    I16* dest_acc  = (side == WHITE) ? acc.white.data()               : acc.black.data();
+
+    apply_features(finny_acc, finny_acc, dest_acc, adds, nbr_adds, subs, nbr_subs);
+
     acc.updated[side] = true;
 
     entry.colorPiecesBB[side] = board.colorPiecesBB;
     entry.typePiecesBB[side]  = board.typePiecesBB;
-
-    if constexpr (side == WHITE)
-        acc.white = entry.accumulator.white;
-    else
-        acc.black = entry.accumulator.black;
 }
 
 template int NNUE::evaluate<WHITE>(const Accumulator& current, size_t count);
 template int NNUE::evaluate<BLACK>(const Accumulator& current, size_t count);
 
-
-
+template void NNUE::refresh_accumulator<WHITE>(const Board& board, Accumulator& acc);
+template void NNUE::refresh_accumulator<BLACK>(const Board& board, Accumulator& acc);
@@ -4,14 +4,20 @@
 #include <algorithm>
 #include <array>
 #include <span>
+#include <string>
 #include "types.h"
 #include "bitmask.h"
-
-#if defined __AVX2__
-#include <immintrin.h>
-#endif
-
-#if defined(__AVX512F__) && defined(__AVX512BW__)
+#include "Cpu.h"
+#include "Kernels.h"
+
+//  ARCH=multi : les noyaux (kernels.cpp) sont compilés pour plusieurs jeux
+//  d'instructions et choisis au démarrage. L'alignement et la présence de la
+//  couche de sortie int8 ne peuvent donc pas dépendre des options de
+//  compilation de chaque fichier : alignement du plus grand vecteur, et
+//  couche int8 utilisée si le noyau choisi en dispose.
+#if defined USE_DISPATCH
+  #define ALIGN   64
+#elif defined(__AVX512F__) && defined(__AVX512BW__)
   #define ALIGN   64
 #elif defined(__AVX2__)
   #define ALIGN   32
@@ -23,6 +29,17 @@
   #define ALIGN 16
 #endif
 
+//  Couche de sortie en int8, accumulée en I32 par vpdpbusd (voir NNUE::activation_i8).
+//  Seulement si les poids de sortie du réseau tiennent dans [-128, 127] ;
+//  sinon on garde le calcul en int16.
+#if defined USE_DISPATCH
+  #define USE_VNNI
+#elif defined USE_SIMD && defined(__AVX512F__) && defined(__AVX512BW__) && defined(__AVX512VNNI__)
+  #define USE_VNNI
+#elif defined USE_SIMD && !defined(__AVX512BW__) && defined(__AVX2__) && defined(__AVXVNNI__)
+  #define USE_VNNI
+#endif
+
 
 //------------------------------------------------------------------------------
 //  Description du réseau : (768×16kb → 1024)×2 → 1×8ob  SCReLU
@@ -32,6 +49,9 @@
 //      Accumulateur         : 1024 neurones par perspective (incrémental)
 //      Output Buckets       : 8 (MaterialCount : selon le nb de pièces restantes)
 //      Activation           : SCReLU = clamp(x, 0, QA)² / QA  (Squared Clipped ReLU)
+//
+//  Un réseau chargé depuis un fichier (commande nnload) peut remplacer la
+//  sortie directe par des couches denses L1 → L2 → 1 : voir Layers.h.
 
 // https://www.chessprogramming.org/NNUE#Output_Buckets
 
@@ -77,6 +97,14 @@ struct Network {
     alignas(ALIGN) std::array<I16, OUTPUT_BUCKETS>                                output_bias;
 };
 
+//-----------------------------------------------------------------------
+//  Poids de sortie convertis en int8, même ordre [bucket][couleur][neurone] ;
+//  à l'intérieur de chaque bloc de 2 vecteurs, les neurones sont réordonnés
+//  comme les produit l'instruction "pack" (voir NNUE::quantized_output).
+struct OutputWeightsI8 {
+    alignas(ALIGN) std::array<I08, N_COLORS * HIDDEN_LAYER_SIZE * OUTPUT_BUCKETS> weights;
+};
+
 //------------------------------------------------------------------------------
 // Lazy Updates
 struct SquarePiece {
@@ -94,6 +122,16 @@ struct DirtyPieces {
     } type = NORMAL;
 };
 
+//  Statistiques des Lazy Updates (une perspective par appel) :
+//  longueur de la chaîne d'accumulateurs à rattraper, ou rafraîchissement.
+struct LazyStats {
+    U64 refresh  = 0;       // rafraîchissement complet (Finny tables)
+    U64 chain[3] = {};      // chaînes de longueur 1, 2, 3 et plus
+};
+
+//  Nombre maximal de coups appliqués en une seule passe (NNUE::fused_update)
+constexpr size_t MAX_FUSED_PLIES = 8;
+
 //------------------------------------------------------------------------------
 //  Un accumulateur contient 2 perspectives.
 
@@ -132,10 +170,11 @@ struct FinnyEntry {
     Array2D<Bitboard, N_COLORS, N_COLORS>     colorPiecesBB = {{}};
     Accumulator accumulator = {};
 
-    void init();
+    void init(std::span<const I16, HIDDEN_LAYER_SIZE> biases);
 };
 
 class Board;
+class LayerStack;
 
 //-----------------------------------------------------------------------
 
@@ -143,9 +182,49 @@ class NNUE
 {
 public:
     //! \brief  Construit NNUE avec un stack d'accumulateurs vide (head_idx = 0)
-    explicit NNUE() : head_idx(0) {}
+    explicit NNUE() : head_idx(0), network(main_network()), layers(main_layers()), kernels(&Cpu::kernels())
+#if defined USE_VNNI
+        , output_i8(quantized_output(network, *kernels))
+#endif
+    {}
     ~NNUE() = default;
 
+    static const Network*    embedded_network();
+    static const Network*    main_network();
+    static const LayerStack* main_layers();
+    static const Network*    node_network(size_t node);
+    static bool              load_file(const std::string& filename);
+    static bool              set_eval_file(const std::string& filename);
+    static bool              set_shared(bool on);
+    static int               clean_shared();
+    static bool              save_file(const std::string& filename);
+
+    //! \brief  Fixe le réseau utilisé (embarqué, ou copie sur le nœud NUMA de la thread)
+    //! \param[in] net      réseau à utiliser
+    inline void set_network(const Network* net) {
+        network = net;
+#if defined USE_VNNI
+        output_i8 = quantized_output(network, *kernels);
+#endif
+    }
+
+    //! \brief  Fixe les noyaux de calcul (par défaut : ceux choisis pour ce CPU)
+    //! \param[in] kern    noyaux à utiliser ; le CPU doit pouvoir les exécuter
+    inline void set_kernels(const NnueKernels* kern) {
+        kernels = kern;
+#if defined USE_VNNI
+        output_i8 = quantized_output(network, *kernels);
+#endif
+    }
+
+    //! \brief  Retourne les noyaux de calcul utilisés par cette instance
+    inline const NnueKernels* get_kernels() const { return kernels; }
+
+    //! \brief  Retourne le réseau utilisé par cette instance
+    inline const Network* get_network() const { return network; }
+    //! \brief  Retourne les couches denses du réseau (nullptr : réseau à une couche)
+    inline const LayerStack* get_layers() const { return layers; }
+
     //! \brief  Retourne l'accumulateur courant (sommet du stack), en lecture seule
     inline const Accumulator& get_accumulator() const { return stack[head_idx]; }
     //! \brief  Retourne l'accumulateur courant (sommet du stack), modifiable
@@ -171,21 +250,41 @@ public:
                    const std::array<I16, HIDDEN_LAYER_SIZE * N_COLORS * OUTPUT_BUCKETS>& weights,
                    const int bucket);
 
-    template <Color side> void add(Accumulator& accu, Piece piece, SQUARE from, SQUARE king);
+#if defined USE_VNNI
+    static const OutputWeightsI8* quantized_output(const Network* net, const NnueKernels& kern);
+
+    //! \brief  Indique si la couche de sortie est calculée en int8
+    inline bool has_output_i8() const { return output_i8 != nullptr; }
+
+    I32 activation_i8(const std::array<I16, HIDDEN_LAYER_SIZE>& us,
+                      const std::array<I16, HIDDEN_LAYER_SIZE>& them,
+                      const int bucket);
+#endif
+
+    //! \brief  Retourne les statistiques des Lazy Updates depuis start_search
+    inline const LazyStats& get_lazy_stats() const { return lazy_stats; }
 
 private:
     std::array<Accumulator, MAX_PLY+1> stack;                       // pile des accumulateurs
 
     size_t head_idx;                                                // accumulateur utilisé (= stack_size - 1)
+    const Network* network;                                         // réseau utilisé par cette instance
+    const LayerStack* layers;                                       // couches denses (nullptr : sortie directe)
+    const NnueKernels* kernels;                                     // noyaux de calcul (SIMD)
+#if defined USE_VNNI
+    const OutputWeightsI8* output_i8;                               // poids de sortie int8 (nullptr si hors [-128, 127])
+#endif
     FinnyEntry finny[N_COLORS][KING_BUCKETS_COUNT] = {};            // tables Finny
+    LazyStats lazy_stats;                                           // statistiques des Lazy Updates
 
     template <Color side> void lazy_update(const Board& board, Accumulator& head);
     template <Color side> void update(const Accumulator &src, Accumulator& dst, SQUARE king);
+    template <Color side> void fused_update(size_t first, size_t last, SQUARE king);
+    void apply_features(const I16* src, I16* dst, I16* copy,
+                        const U32* adds, size_t nbr_adds,
+                        const U32* subs, size_t nbr_subs);
     template <Color side> bool need_refresh(SQUARE oldKing, SQUARE newKing) ;
 
-    template <Color side>
-    void sub(Accumulator& accu, Piece piece, SQUARE from, SQUARE king);
-
     template <Color side>
     void sub_add(const Accumulator& src, Accumulator& dst,
                        Piece sub_piece, SQUARE sub,
@@ -240,15 +339,6 @@ private:
     std::pair<size_t, size_t> get_indices(Piece piece, SQUARE square, SQUARE wking, SQUARE bking);
     template <Color side>U32 get_indice(Piece piece, SQUARE square, SQUARE king);
 
-
-    //! \brief  SCReLU scalaire
-    //! \param[in] x    valeur brute de l'accumulateur (I16)
-    //! \return         valeur calculée (I32)
-    inline I32 screlu(I16 x) {
-        auto clamped = std::clamp(static_cast<I32>(x), 0, QA);
-        return clamped * clamped;
-    }
-
 };
 
 #endif // NNUE_H
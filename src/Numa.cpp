@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include "Numa.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined USE_NUMA
+#include <numa.h>
+#endif
+
+namespace {
+
+//  Description des nœuds de la machine : liste des coeurs de chaque nœud
+struct Topology {
+    std::vector<std::vector<int>> nodes;
+
+    Topology();
+};
+
+bool   enabled     = true;  // option UCI "NumaBind"
+size_t nbr_threads = 1;     // nombre de threads de recherche (option UCI "Threads")
+
+//==================================================
+//! \brief  Décode une liste de coeurs du noyau ("0-3,8-11")
+//! \param[in]  str     liste lue dans /sys/devices/system/node/nodeX/cpulist
+//! \return Liste des numéros de coeurs
+//--------------------------------------------------
+std::vector<int> parse_cpulist(const std::string& str)
+{
+    std::vector<int> cpus;
+    std::istringstream iss(str);
+    std::string range;
+
+    while (std::getline(iss, range, ','))
+    {
+        if (range.empty())
+            continue;
+
+        // pas de std::stoi : il lève une exception sur une entrée invalide
+        const size_t dash  = range.find('-');
+        const int    first = static_cast<int>(std::strtol(range.c_str(), nullptr, 10));
+        const int    last  = (dash == std::string::npos) ? first : static_cast<int>(std::strtol(range.c_str() + dash + 1, nullptr, 10));
+        for (int c = first; c <= last; c++)
+            cpus.push_back(c);
+    }
+
+    return cpus;
+}
+
+//==================================================
+//! \brief  Lecture de la topologie
+//! Sous Linux, on lit /sys ; on ne garde que les coeurs autorisés
+//! pour le processus (taskset, cgroups).
+//! Partout ailleurs, ou en cas d'erreur, un seul nœud.
+//--------------------------------------------------
+Topology::Topology()
+{
+#if defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    const bool has_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+    for (int n = 0; ; n++)
+    {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(n) + "/cpulist");
+        if (!file.is_open())
+            break;
+
+        std::string line;
+        std::getline(file, line);
+
+        std::vector<int> cpus;
+        for (int c : parse_cpulist(line))
+            if (c < CPU_SETSIZE && (!has_mask || CPU_ISSET(c, &allowed)))
+                cpus.push_back(c);
+
+        // un nœud sans coeur (mémoire seule, ou exclu par taskset) ne reçoit pas de thread
+        if (!cpus.empty())
+            nodes.push_back(std::move(cpus));
+    }
+#endif
+
+    if (nodes.empty())
+    {
+        nodes.emplace_back();
+        for (int c = 0; c < static_cast<int>(std::thread::hardware_concurrency()); c++)
+            nodes[0].push_back(c);
+    }
+}
+
+//==================================================
+//! \brief  Topologie de la machine, lue au premier appel
+//--------------------------------------------------
+const Topology& topology()
+{
+    static const Topology topo;
+    return topo;
+}
+
+}
+
+namespace Numa {
+
+//==================================================
+//! \brief  Active ou désactive le placement des threads
+//! Le changement ne concerne que les threads créées ensuite.
+//--------------------------------------------------
+void set_enabled(bool f)
+{
+    enabled = f;
+}
+
+//==================================================
+//! \brief  Nombre de threads de recherche
+//! Le changement ne concerne que les threads créées ensuite.
+//--------------------------------------------------
+void set_threads(size_t nbr)
+{
+    nbr_threads = nbr;
+}
+
+//==================================================
+//! \brief  Indique si le placement est actif
+//! (option activée, plusieurs nœuds, et plus de threads
+//! que de coeurs sur un nœud)
+//!
+//! Tant que les threads tiennent sur un nœud, le système les place
+//! mieux que nous : plusieurs moteurs lancés sur la même machine
+//! (une recherche à une thread chacun) ne doivent pas se retrouver
+//! attachés au même coeur.
+//--------------------------------------------------
+bool is_active()
+{
+    if (!enabled || topology().nodes.size() < 2)
+        return false;
+
+    size_t cores = 0;
+    for (const auto& cpus : topology().nodes)
+        cores = std::max(cores, cpus.size());
+    return nbr_threads > cores;
+}
+
+//==================================================
+//! \brief  Retourne le nombre de nœuds ayant des coeurs utilisables
+//--------------------------------------------------
+size_t nbr_nodes()
+{
+    return topology().nodes.size();
+}
+
+//==================================================
+//! \brief  Nœud attribué à la thread d'indice index
+//! Les threads sont réparties à tour de rôle sur les nœuds.
+//! \param[in]  index   indice de la thread de recherche
+//--------------------------------------------------
+size_t node_of(size_t index)
+{
+    return is_active() ? index % nbr_nodes() : 0;
+}
+
+//==================================================
+//! \brief  Attache la thread appelante au coeur attribué à l'indice index
+//! Ne fait rien si le placement n'est pas actif.
+//! \param[in]  index   indice de la thread de recherche
+//--------------------------------------------------
+void bind_thread([[maybe_unused]] size_t index)
+{
+    if (!is_active())
+        return;
+
+#if defined(__linux__)
+    const auto& cpus = topology().nodes[node_of(index)];
+    const int   cpu  = cpus[(index / nbr_nodes()) % cpus.size()];
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+//==================================================
+//! \brief  Répartit les pages d'une zone mémoire sur tous les nœuds
+//! Seulement avec libnuma ; sinon c'est le "first touch" qui décide.
+//! \param[in]  ptr     début de la zone (pas encore touchée)
+//! \param[in]  size    taille de la zone, en octets
+//--------------------------------------------------
+void interleave([[maybe_unused]] void* ptr, [[maybe_unused]] size_t size)
+{
+#if defined USE_NUMA
+    if (is_active() && numa_available() >= 0)
+        numa_interleave_memory(ptr, size, numa_all_nodes_ptr);
+#endif
+}
+
+//==================================================
+//! \brief  Description de la topologie, pour la commande "v"
+//--------------------------------------------------
+std::string info()
+{
+    std::stringstream sstr;
+
+    sstr << "Noeuds NUMA         : " << nbr_nodes()
+         << (is_active() ? " (placement actif)" : " (placement inactif)") << std::endl;
+
+    for (size_t n = 0; n < nbr_nodes(); n++)
+        sstr << "   noeud " << n << "          : " << topology().nodes[n].size() << " coeurs" << std::endl;
+
+    return sstr.str();
+}
+
+}
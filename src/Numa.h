@@ -0,0 +1,38 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <string>
+#include <vector>
+#include "defines.h"
+
+//  Placement des threads sur une machine NUMA (plusieurs sockets)
+//
+//  Chaque thread de recherche est attachée à un coeur, les threads
+//  étant réparties à tour de rôle sur les nœuds NUMA.
+//  La mémoire d'une Search (accumulateurs NNUE, History) est allouée
+//  par une thread déjà attachée à son nœud : le noyau la place alors
+//  sur ce nœud ("first touch").
+//  La table de transposition est remise à zéro par des threads attachées
+//  de la même façon : ses tranches sont ainsi réparties sur tous les nœuds.
+//  Avec libnuma (make NUMA=yes), elle est en plus explicitement entrelacée.
+//
+//  Le placement n'est actif que si la machine a plusieurs nœuds, et
+//  si les threads de recherche ne tiennent pas sur un seul nœud :
+//  sinon attacher les threads n'apporte rien, et gênerait plusieurs
+//  moteurs tournant en même temps (ils seraient tous sur les mêmes coeurs).
+//  Une recherche à une thread n'est donc jamais attachée.
+
+namespace Numa {
+
+void        set_enabled(bool f);
+void        set_threads(size_t nbr);
+bool        is_active();
+size_t      nbr_nodes();
+size_t      node_of(size_t index);
+void        bind_thread(size_t index);
+void        interleave(void* ptr, size_t size);
+std::string info();
+
+}
+
+#endif // NUMA_H
@@ -0,0 +1,83 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include "types.h"
+
+class Board;
+
+//  Perft multi-thread, avec table de hachage optionnelle
+//
+//  Sert de mesure de performance du générateur de coups
+//  (Board::legal_moves) et de make_move/undo_move, indépendamment
+//  de la recherche.
+
+//  Ce qui est mesuré
+enum class PerftMode {
+    GENERATION,     // génération seule : bulk-counting à depth==1
+    MAKE_UNDO,      // chaque feuille est jouée puis annulée (pas de bulk-counting)
+    HASHED          // bulk-counting + table de hachage partagée
+};
+
+//  Table de hachage des sous-arbres de perft, partagée par les threads
+//
+//  La clé est la clé zobrist mélangée avec la profondeur restante.
+//  Pas de verrou : chaque entrée contient (clé ^ nodes) et nodes,
+//  une entrée écrite à moitié par une autre thread est rejetée à la
+//  lecture (technique "lockless" de Hyatt). Remplacement systématique.
+
+class PerftTable
+{
+public:
+    PerftTable() = default;
+
+    PerftTable(const PerftTable&)            = delete;
+    PerftTable& operator=(const PerftTable&) = delete;
+
+    void resize(size_t mb);
+    void clear();
+
+    //! \brief  Cherche le nombre de feuilles du sous-arbre (key, depth)
+    //! \param[out] nodes   nombre de feuilles trouvé
+    //! \return "true" si le sous-arbre est dans la table
+    inline bool probe(KEY key, int depth, U64& nodes) const
+    {
+        const KEY    k = mix(key, depth);
+        const Entry& e = table[k & mask];
+        const U64    n = e.nodes.load(std::memory_order_relaxed);
+        if ((e.check.load(std::memory_order_relaxed) ^ n) != k)
+            return false;
+        nodes = n;
+        return true;
+    }
+
+    //! \brief  Range le nombre de feuilles du sous-arbre (key, depth)
+    inline void store(KEY key, int depth, U64 nodes)
+    {
+        const KEY k = mix(key, depth);
+        Entry&    e = table[k & mask];
+        e.check.store(k ^ nodes, std::memory_order_relaxed);
+        e.nodes.store(nodes, std::memory_order_relaxed);
+    }
+
+    //! \brief  Taille de la table, en Mo (0 si non allouée)
+    inline size_t get_size() const { return table.size() * sizeof(Entry) / (1024 * 1024); }
+
+private:
+    struct Entry {
+        std::atomic<U64> check{0};
+        std::atomic<U64> nodes{0};
+    };
+
+    static inline KEY mix(KEY key, int depth) { return key ^ (static_cast<U64>(depth) * 0x9E3779B97F4A7C15ULL); }
+
+    std::vector<Entry> table;
+    U64                mask = 0;
+};
+
+[[nodiscard]] U64 perft_parallel(const Board& board, int depth, size_t nbr_threads,
+                                 PerftMode mode, PerftTable* table);
+
+#endif // PERFT_H
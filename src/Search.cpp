@@ -4,12 +4,13 @@
 #include "ThreadPool.h"
 #include "Move.h"
 #include "TranspositionTable.h"
+#include "Numa.h"
 
 
 //=============================================
 //! \brief  Constructeur
 //---------------------------------------------
-Search::Search() : stopFlagPtr(&stopped)
+Search::Search() : nodesTotalPtr(&nodesTotal), stopFlagPtr(&stopped)
 {
 #if defined DEBUG_LOG
     char message[100];
@@ -38,9 +39,99 @@ void Search::init_reductions()
 
 //=============================================
 //! \brief  Destructeur
+//! Termine la thread persistante si elle a été lancée
 //---------------------------------------------
 Search::~Search()
 {
+    if (thread.joinable())
+        exit_worker();
+}
+
+//=============================================
+//! \brief  Lance la thread persistante de cette Search.
+//! On attend qu'elle soit parquée dans idle_loop()
+//! avant de rendre la main.
+//---------------------------------------------
+void Search::start_worker()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        searching = true;
+        exit      = false;
+    }
+    thread = std::thread(&Search::idle_loop, this);
+    wait_for_search_finished();
+}
+
+//=============================================
+//! \brief  Demande à la thread persistante de se terminer,
+//!         et attend sa fin
+//---------------------------------------------
+void Search::exit_worker()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        exit      = true;
+        searching = true;
+    }
+    cv.notify_all();
+    thread.join();
+}
+
+//=============================================
+//! \brief  Boucle de la thread persistante.
+//! La thread signale qu'elle est libre (searching = false),
+//! puis dort jusqu'à ce que start_searching() la réveille.
+//---------------------------------------------
+void Search::idle_loop()
+{
+    // la thread reste sur le coeur (et le nœud NUMA) où sa Search a été allouée
+    Numa::bind_thread(index);
+
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        searching = false;
+        cv.notify_all();        // réveille wait_for_search_finished()
+        cv.wait(lock, [&]{ return searching; });
+
+        if (exit)
+            return;
+
+        lock.unlock();
+
+        // board et timer sont passés par valeur : think() travaille sur sa copie
+        if (rootBoard.side_to_move == WHITE)
+            think<WHITE>(rootBoard, rootTimer, index);
+        else
+            think<BLACK>(rootBoard, rootTimer, index);
+    }
+}
+
+//=============================================
+//! \brief  Réveille la thread persistante sur une nouvelle recherche
+//!
+//! \param[in]  board   position de départ de la recherche
+//! \param[in]  timer   gestion du temps alloué à la recherche
+//---------------------------------------------
+void Search::start_searching(const Board& board, const Timer& timer)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        rootBoard = board;
+        rootTimer = timer;
+        searching = true;
+    }
+    cv.notify_all();
+}
+
+//=============================================
+//! \brief  Attend que la thread soit revenue dans idle_loop()
+//---------------------------------------------
+void Search::wait_for_search_finished()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&]{ return !searching; });
 }
 
 //=========================================================
@@ -50,6 +141,19 @@ Search::~Search()
 //! \param[in] pv           variation principale à afficher
 //---------------------------------------------------------
 void Search::show_uci_result(I64 elapsed, const PVariation& pv) const
+{
+    show_uci_result(elapsed, pv, pv_scores[best_depth], 0);
+}
+
+//=========================================================
+//! \brief  Affichage UCI d'une ligne de la recherche
+//!
+//! \param[in] elapsed      temps passé pour la recherche, en millisecondes
+//! \param[in] pv           variation à afficher
+//! \param[in] score        score de la variation
+//! \param[in] multipv      numéro de la ligne (1..MultiPV) ; 0 : pas de MultiPV
+//---------------------------------------------------------
+void Search::show_uci_result(I64 elapsed, const PVariation& pv, int score, int multipv) const
 {
     elapsed++; // évite une division par 0
     // commande envoyée à UCI
@@ -73,19 +177,21 @@ void Search::show_uci_result(I64 elapsed, const PVariation& pv) const
 
     stream << "info "
            << " depth "    << best_depth
-           << " seldepth " << seldepth
+           << " seldepth " << seldepth;
+    if (multipv > 0)
+        stream << " multipv " << multipv;
 
 // time     : le temps de recherche, en ms
 // nodes    : noeuds calculés
 // nps      : nodes par seconde recherchés
 
-           << " time "       << elapsed
+    stream << " time "       << elapsed
            << " nodes "      << all_nodes
            << " nps "        << all_nodes * 1000 / elapsed
            << " tbhits "     << all_tbhits
            << " hashfull "   << hash_full;
 
-    const int iter_best_score = pv_scores[best_depth];
+    const int iter_best_score = score;
 
     if (iter_best_score >= MATE_IN_X)
     {
@@ -112,11 +218,15 @@ void Search::show_uci_result(I64 elapsed, const PVariation& pv) const
 //!         N'est utilisé que pour le thread 0
 //!
 //! \param[in]  best_move   meilleur coup trouvé, en notation UCI
+//! \param[in]  ponder_move réponse attendue de l'adversaire (MOVE_NONE si inconnue)
 //---------------------------------------------------------
-void Search::show_uci_best(MOVE best_move) const
+void Search::show_uci_best(MOVE best_move, MOVE ponder_move) const
 {
     // ATTENTION AU FORMAT D'AFFICHAGE
-    std::cout << "bestmove " << Move::name(best_move) << std::endl;
+    if (ponder_move != Move::MOVE_NONE)
+        std::cout << "bestmove " << Move::name(best_move) << " ponder " << Move::name(ponder_move) << std::endl;
+    else
+        std::cout << "bestmove " << Move::name(best_move) << std::endl;
 }
 
 //=========================================================
@@ -143,6 +253,14 @@ void Search::update_pv(SearchInfo* si, const MOVE move) const
 //------------------------------------------
 [[nodiscard]] int Search::evaluate(const Board& board)
 {
+    // Position déjà évaluée par cette thread : ni rattrapage de
+    // l'accumulateur, ni couche de sortie. L'accumulateur reste
+    // en retard ; il sera rattrapé par la prochaine évaluation.
+    const KEY key = board.get_key();
+    int value;
+    if (eval_cache.probe(key, value))
+        return value;
+
     // Du fait de lazy Updates, on a découpé la routine en 2
 
     Accumulator& acc = get_accumulator();
@@ -150,7 +268,9 @@ void Search::update_pv(SearchInfo* si, const MOVE move) const
    // Lazy Updates
    nnue.lazy_updates(board, acc);
 
-   return do_evaluate(board, acc);
+   value = do_evaluate(board, acc);
+   eval_cache.store(key, value);
+   return value;
 }
 
 //==========================================
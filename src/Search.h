@@ -4,11 +4,14 @@
 
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include <cstring>
 #include "Timer.h"
 #include "Board.h"
 #include "SearchInfo.h"
 #include "History.h"
+#include "EvalCache.h"
 #include "TranspositionTable.h"
 
 
@@ -17,6 +20,25 @@ constexpr int STACK_OFFSET = 4;
 constexpr int STACK_SIZE   = MAX_PLY + 2*STACK_OFFSET;  // taille un peu trop grande, mais multiple de 8
 
 
+//! \brief  Compteur d'une thread (nodes, tbhits)
+//!
+//! Écrit par sa seule thread, lu par les autres (affichage UCI, nps) :
+//! un atomic "relaxed" suffit, et l'incrément (load + store, sans
+//! instruction "lock") coûte autant qu'un incrément ordinaire.
+//! Le compteur occupe sa propre ligne de cache : les lectures des
+//! autres threads ne gênent pas les données voisines de la recherche.
+class NodeCounter
+{
+public:
+    operator U64() const noexcept { return value.load(std::memory_order_relaxed); }
+    NodeCounter& operator=(U64 n) noexcept { value.store(n, std::memory_order_relaxed); return *this; }
+    void operator++(int) noexcept { value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+    void operator--(int) noexcept { value.store(value.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed); }
+
+private:
+    alignas(64) std::atomic<U64> value{0};
+};
+
 //! \brief  Données d'une thread
 class Search
 {
@@ -25,9 +47,18 @@ public:
     ~Search();
 
     NNUE                nnue;
-    std::thread         thread;
     TranspositionTable* table = nullptr;
     History             history;
+    EvalCache           eval_cache;     // évaluations déjà calculées par cette thread
+
+    //==============================================
+    //  Thread persistante (ThreadPool)
+    //  La thread est créée une seule fois, puis reste
+    //  en attente sur "cv" entre deux recherches.
+    void start_worker();
+    void exit_worker();
+    void start_searching(const Board& board, const Timer& timer);
+    void wait_for_search_finished();
 
     //==============================================
     //  Evaluation
@@ -37,8 +68,45 @@ public:
     template <Color US, bool Update_NNUE> void make_move(Board& board, const MOVE move) noexcept;
     template <Color US, bool Update_NNUE> void undo_move(Board& board) noexcept;
 
-    U64         nodes;          // nombre de neuds recherchés
-    U64         tbhits;
+    NodeCounter nodes;          // nombre de neuds recherchés
+    NodeCounter tbhits;
+
+    // Total des nodes de toutes les threads : chaque thread y publie ses nodes
+    // par lots de NODES_BATCH. La limite "go nodes" est contrôlée sur ce total.
+    static constexpr I64 NODES_BATCH = 512; // taille des lots publiés dans le total
+    I64                nodes_batch = 0;     // nodes pas encore publiés (< 0 possible : razoring)
+    std::atomic<U64>   nodesTotal{0};       // total local (DataGen)
+    std::atomic<U64>*  nodesTotalPtr;       // pointe vers nodesTotal (DataGen) ou ThreadPool::searchNodes (engine)
+
+    //! \brief  Compte un node ; le lot est publié tous les NODES_BATCH nodes
+    void count_node() noexcept {
+        nodes++;
+        if (++nodes_batch >= NODES_BATCH)
+            publish_nodes();
+    }
+
+    //! \brief  Annule le comptage d'un node
+    void uncount_node() noexcept {
+        nodes--;
+        nodes_batch--;
+    }
+
+    //! \brief  Ajoute les nodes du lot en cours au total de toutes les threads
+    void publish_nodes() noexcept {
+        nodesTotalPtr->fetch_add(static_cast<U64>(nodes_batch), std::memory_order_relaxed);
+        nodes_batch = 0;
+    }
+
+    //! \brief  Nombre de nodes de toutes les threads, vu par cette thread :
+    //! exact avec une seule thread, sinon en retard d'au plus un lot par autre thread
+    U64 global_nodes() const noexcept { return nodesTotalPtr->load(std::memory_order_relaxed) + static_cast<U64>(nodes_batch); }
+
+    //! \brief  Remet à zéro les compteurs de nodes de la thread (pas le total partagé)
+    void reset_nodes() noexcept {
+        nodes       = 0;
+        nodes_batch = 0;
+        nodesTotal.store(0, std::memory_order_relaxed);
+    }
 
     int         index;          // indice de la thread
     int         seldepth;       // selective depth
@@ -62,6 +130,18 @@ public:
     // PV complète de la dernière itération terminée.
     PVariation  last_pv;
 
+    // MultiPV (thread 0 seulement) : les lignes sont cherchées l'une après
+    // l'autre à chaque itération, en excluant à la racine les premiers coups
+    // des lignes déjà trouvées. Les lignes sont triées par score décroissant.
+    int         multipv_count = 1;                          // nombre de lignes cherchées
+    int         multipv_index = 0;                          // ligne en cours de recherche
+    std::array<MOVE, MAX_MULTIPV>       multipv_moves;      // premiers coups des lignes déjà trouvées (itération en cours)
+    std::array<PVariation, MAX_MULTIPV> multipv_lines;      // lignes de la dernière itération terminée
+    std::array<int, MAX_MULTIPV>        multipv_scores;     // scores de ces lignes
+
+    // "go searchmoves" : seuls ces coups sont cherchés à la racine (vide : tous les coups)
+    MoveList    search_moves;
+
     // Point de départ de la recherche
     template <Color C> void think(Board board, Timer timer, size_t _index);
     template <Color C> int  aspiration_window(Board& board, Timer& timer, SearchInfo* si, int prev_score);
@@ -76,12 +156,57 @@ public:
 
 private:
 
+    std::thread             thread;
+    std::mutex              mutex;
+    std::condition_variable cv;
+    bool                    searching = false;  // protégé par mutex : une recherche est en cours (ou demandée)
+    bool                    exit      = false;  // protégé par mutex : la thread doit se terminer
+    Board                   rootBoard;          // position de départ transmise à la thread
+    Timer                   rootTimer;          // gestion du temps transmise à la thread
+
+    void idle_loop();
+
     template <Color C> void iterative_deepening(Board& board, Timer& timer, SearchInfo* si);
     template <Color C> int  alpha_beta(Board& board, Timer& timer, int alpha, int beta, int depth, bool cut_node, SearchInfo* si);
     template <Color C> int  quiescence(Board& board, Timer& timer, int alpha, int beta, SearchInfo* si);
 
     void show_uci_result(I64 elapsed, const PVariation &pv) const;
-    void show_uci_best(MOVE best_move) const;
+    void show_uci_result(I64 elapsed, const PVariation &pv, int score, int multipv) const;
+
+    //! \brief  Indique si le coup racine "move" est déjà la tête d'une ligne MultiPV
+    bool is_multipv_excluded(MOVE move) const {
+        for (int k = 0; k < multipv_index; k++)
+            if (multipv_moves[k] == move)
+                return true;
+        return false;
+    }
+
+    //! \brief  Indique si le coup racine "move" est hors de la liste "go searchmoves"
+    bool is_searchmoves_excluded(MOVE move) const {
+        if (search_moves.count == 0)
+            return false;
+        for (size_t k = 0; k < search_moves.count; k++)
+            if (search_moves.mlmoves[k].move == move)
+                return false;
+        return true;
+    }
+
+    //! \brief  Indique si le coup racine "move" ne doit pas être cherché
+    bool is_root_excluded(MOVE move) const { return is_multipv_excluded(move) || is_searchmoves_excluded(move); }
+
+    //! \brief  Indique si la racine ne cherche qu'une partie des coups légaux :
+    //! son score n'est alors pas celui de la position
+    bool is_root_restricted() const { return multipv_index > 0 || search_moves.count > 0; }
+
+    //! \brief  Meilleur coup racine non exclu, d'après les lignes de l'itération précédente
+    MOVE multipv_hint() const {
+        for (int k = 0; best_depth > 0 && k < multipv_count; k++)
+            if (!is_root_excluded(multipv_lines[k].line[0]))
+                return multipv_lines[k].line[0];
+        return Move::MOVE_NONE;
+    }
+    void show_uci_best(MOVE best_move, MOVE ponder_move) const;
+    template <Color C> MOVE tt_ponder_move(Board& board, MOVE best);
     void update_pv(SearchInfo* si, const MOVE move) const;
 
     static constexpr int LateMovePruningDepth = 7;
@@ -92,6 +217,15 @@ private:
 
     int Reductions[2][32][32];
 
+    // Listes de coups des MovePicker, une par ply.
+    // La recherche singulière (si->excluded) se fait au même ply
+    // que le nœud qui la lance, pendant qu'il parcourt ses coups :
+    // elle utilise son propre jeu de listes.
+    MoveList move_lists[2][MAX_PLY+1];
+
+    //! \brief  Retourne la liste de coups du MovePicker du ply "si"
+    MoveList& get_move_list(const SearchInfo* si) { return move_lists[si->excluded != Move::MOVE_NONE][si->ply]; }
+
 }__attribute__((aligned(64)));
 
 
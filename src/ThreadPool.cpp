@@ -6,7 +6,15 @@
 #include "Board.h"
 #include "Search.h"
 #include "Move.h"
+#include "Numa.h"
 
+//=================================================
+//! \brief  Instant courant, en nanosecondes
+//-------------------------------------------------
+static I64 now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(TimePoint::now().time_since_epoch()).count();
+}
 
 //=================================================
 //! \brief  Constructeur avec arguments
@@ -55,24 +63,150 @@ void ThreadPool::set_threads(U32 nbr)
 
     // Réallouer uniquement si le nombre change
     if (newNbr != nbrThreads)
+        create_threads(newNbr);
+
+#if defined DEBUG_LOG
+    sprintf(message, "ThreadPool::set_threads : nbrThreads=%d ", nbrThreads);
+    printlog(message);
+#endif
+}
+
+//=================================================
+//! \brief  Active ou désactive le placement NUMA des threads
+//! Les threads sont recréées pour être placées (ou non) sur les nœuds.
+//!
+//! \param[in]  f   valeur de l'option UCI "NumaBind"
+//-------------------------------------------------
+void ThreadPool::set_numa(bool f)
+{
+    Numa::set_enabled(f);
+    create_threads(nbrThreads);
+}
+
+//=================================================
+//! \brief  Active ou désactive la copie du réseau sur chaque nœud NUMA
+//! N'a d'effet que si le placement NUMA est actif.
+//!
+//! \param[in]  f   valeur de l'option UCI "NumaNetReplicas"
+//-------------------------------------------------
+void ThreadPool::set_net_replicas(bool f)
+{
+    netReplicas = f;
+    create_threads(nbrThreads);
+}
+
+//=================================================
+//! \brief  Chargement d'un réseau depuis un fichier (commande "nnload")
+//! Les Search sont détruites avant le chargement (elles référencent
+//! l'ancien réseau), puis recréées avec le nouveau.
+//!
+//! \param[in]  filename    fichier réseau (voir NetFileHeader)
+//! \return "true" si le réseau a été chargé
+//-------------------------------------------------
+bool ThreadPool::load_network(const std::string& filename)
+{
+    if (!search.empty())
+        stop();
+    search.clear();
+
+    NNUE::set_shared(false);
+    const bool ok = NNUE::load_file(filename);
+    if (netShared)
+        NNUE::set_shared(true);
+    create_threads(nbrThreads);
+    return ok;
+}
+
+//=================================================
+//! \brief  Réseau donné par l'option UCI "EvalFile"
+//! Comme load_network, mais le fichier est projeté en mémoire
+//! (voir NNUE::set_eval_file) ; "<embedded>" revient au réseau embarqué.
+//!
+//! \param[in]  filename    fichier réseau, ou "<embedded>"
+//! \return "true" si le réseau demandé est utilisé
+//-------------------------------------------------
+bool ThreadPool::set_eval_file(const std::string& filename)
+{
+    if (!search.empty())
+        stop();
+    search.clear();
+
+    NNUE::set_shared(false);
+    const bool ok = NNUE::set_eval_file(filename);
+    if (netShared)
+        NNUE::set_shared(true);
+    create_threads(nbrThreads);
+    return ok;
+}
+
+//=================================================
+//! \brief  Publie le réseau en mémoire partagée entre les processus,
+//!         ou revient à un réseau privé (voir NNUE::set_shared)
+//!
+//! \param[in]  f   valeur de l'option UCI "SharedNetwork"
+//-------------------------------------------------
+void ThreadPool::set_shared_network(bool f)
+{
+    if (!search.empty())
+        stop();
+    search.clear();
+
+    netShared = f;
+    NNUE::set_shared(f);
+    create_threads(nbrThreads);
+}
+
+//=================================================
+//! \brief  Création des Search et de leurs threads
+//!
+//! Sur une machine NUMA, chaque Search est construite par une
+//! thread déjà attachée à son nœud : sa mémoire (accumulateurs,
+//! History) est ainsi allouée sur ce nœud ("first touch").
+//! Chaque Search utilise alors aussi la copie du réseau de son nœud,
+//! sauf si le réseau est en mémoire partagée (voir NNUE::node_network).
+//!
+//! \param[in]  nbr   nombre de threads à créer
+//-------------------------------------------------
+void ThreadPool::create_threads(U32 nbr)
+{
+    // Arrêter toute recherche en cours avant de réallouer.
+    // La destruction des anciennes Search termine leurs threads.
+    if (!search.empty())
+        stop();
+    search.clear();
+
+    nbrThreads = nbr;
+    Numa::set_threads(nbrThreads);
+    search.resize(nbrThreads);
+    for (size_t i = 0; i < nbrThreads; i++)
     {
-        // Arrêter toute recherche en cours avant de réallouer
-        if (search)
-            stop();
+        if (Numa::is_active())
+        {
+            std::thread([this, i]
+            {
+                Numa::bind_thread(i);
+                search[i] = std::make_unique<Search>();
 
-        nbrThreads = newNbr;
-        search = std::make_unique<Search[]>(nbrThreads);
-        for (size_t i = 0; i < nbrThreads; i++)
+                // copie locale du réseau, créée par la première thread du nœud
+                if (netReplicas)
+                    search[i]->nnue.set_network(NNUE::node_network(Numa::node_of(i)));
+            }).join();
+        }
+        else
         {
-            search[i].table = nullptr;
-            search[i].index = i;
+            search[i] = std::make_unique<Search>();
         }
+
+        if (evalCacheKB != EVAL_CACHE_SIZE)
+            search[i]->eval_cache.resize(evalCacheKB);
+
+        search[i]->table = nullptr;
+        search[i]->index = i;
+        search[i]->start_worker();
     }
 
-#if defined DEBUG_LOG
-    sprintf(message, "ThreadPool::set_threads : nbrThreads=%d ", nbrThreads);
-    printlog(message);
-#endif
+    // La remise à zéro de la TT est répartie sur le même nombre de threads
+    transpositionTable.set_threads(nbrThreads);
 }
 
 //=================================================
@@ -82,7 +216,24 @@ void ThreadPool::set_threads(U32 nbr)
 void ThreadPool::reset()
 {
     for (size_t i = 0; i < nbrThreads; i++)
-        search[i].history.reset();
+    {
+        search[i]->history.reset();
+        search[i]->eval_cache.clear();
+    }
+}
+
+//=================================================
+//! \brief  Fixe la taille du cache d'évaluation de chaque thread
+//!
+//! \param[in]  kb  valeur de l'option UCI "EvalCache", en Ko (0 : désactivé)
+//-------------------------------------------------
+void ThreadPool::set_eval_cache(U64 kb)
+{
+    if (!search.empty())
+        stop();
+    evalCacheKB = kb;
+    for (size_t i = 0; i < nbrThreads; i++)
+        search[i]->eval_cache.resize(evalCacheKB);
 }
 
 //=================================================
@@ -92,7 +243,7 @@ void ThreadPool::reset()
 void ThreadPool::reinit_reductions()
 {
     for (size_t i = 0; i < nbrThreads; i++)
-        search[i].init_reductions();
+        search[i]->init_reductions();
 }
 
 //=================================================
@@ -101,8 +252,9 @@ void ThreadPool::reinit_reductions()
 //!
 //! \param[in]  board   position de départ de la recherche
 //! \param[in]  timer   gestion du temps alloué à la recherche
+//! \param[in]  search_moves    coups racine à chercher ("go searchmoves") ; vide : tous
 //-------------------------------------------------
-void ThreadPool::start_thinking(const Board& board, const Timer& timer)
+void ThreadPool::start_thinking(const Board& board, const Timer& timer, const MoveList& search_moves)
 {
 #if defined DEBUG_LOG
     char message[100];
@@ -110,16 +262,29 @@ void ThreadPool::start_thinking(const Board& board, const Timer& timer)
     printlog(message);
 #endif
 
-    // Garantit qu'aucune recherche précédente n'est encore active (double "go")
+    // Garantit qu'aucune recherche précédente n'est encore active (double "go"),
+    // ni son Watchdog : un arrêt tardif ne doit pas toucher la nouvelle recherche
     stop();
+    watchdog.wait_idle();
+
+    goTime.store(now_ns(), std::memory_order_relaxed);
+    stopTime.store(0, std::memory_order_relaxed);
+    goLatency.store(0, std::memory_order_relaxed);
+    stopLatency.store(0, std::memory_order_relaxed);
 
     MOVE best = Move::MOVE_NONE;
 
+    // "go ponder" : la recherche ne s'arrêtera pas avant "ponderhit" ou "stop"
+    pondering.store(timer.is_pondering_requested(), std::memory_order_relaxed);
+
     //  une ouverture est choisie par la GUI, depuis le book, et les moteurs jouent à partir de là
     //  c'est ainsi que fonctionnent les tests de moteurs, ou les tournois
 
-    // Probe Syzygy TableBases : joue directement le coup DTZ-optimal si la position est dans les TB.
-    if (useSyzygy && board.probe_root(best) == true)
+    // Probe Syzygy TableBases : joue directement le coup DTZ-optimal si la position est dans les TB
+    // (parmi les coups de "go searchmoves" s'il y en a).
+    // En "ponder", le "bestmove" doit attendre ; en MultiPV, il faut les lignes :
+    // on passe par la recherche.
+    if (useSyzygy && !pondering.load(std::memory_order_relaxed) && multiPV == 1 && board.probe_root(best, search_moves) == true)
     {
         transpositionTable.update_age();
         std::cout << "bestmove " << Move::name(best) << std::endl;
@@ -133,36 +298,37 @@ void ThreadPool::start_thinking(const Board& board, const Timer& timer)
 #endif
 
         searchStopped.store(false, std::memory_order_relaxed);
+        searchNodes.store(0, std::memory_order_relaxed);
 
         for (size_t i = 0; i < nbrThreads; i++)
         {
-            search[i].stopFlagPtr     = &searchStopped;
-            search[i].seldepth        = 0;
-            search[i].nodes           = 0;
-            search[i].tbhits          = 0;
-            search[i].best_depth      = 0;
-            search[i].last_pv.length  = 0;
+            search[i]->stopFlagPtr     = &searchStopped;
+            search[i]->nodesTotalPtr   = &searchNodes;
+            search[i]->seldepth        = 0;
+            search[i]->reset_nodes();
+            search[i]->tbhits          = 0;
+            search[i]->best_depth      = 0;
+            search[i]->last_pv.length  = 0;
+            search[i]->search_moves    = search_moves;
 
             // Init de l'historique par profondeur
             for (int d = 0; d <= MAX_PLY; d++)
             {
-                search[i].pv_scores[d] = -INFINITE;
-                search[i].pv_moves [d] = Move::MOVE_NONE;
+                search[i]->pv_scores[d] = -INFINITE;
+                search[i]->pv_moves [d] = Move::MOVE_NONE;
             }
 
-            search[i].table           = &transpositionTable;
+            search[i]->table           = &transpositionTable;
         }
 
-        // Il faut mettre le lancement des threads dans une boucle séparée
-        // car il faut être sur que la Search soit bien créée
-        // board et timer sont passés par valeur.
+        // La limite en temps est surveillée par le Watchdog, pas par les threads
+        watchdog.start(timer.get_start_time(), timer.get_hard_limit(), pondering.load(std::memory_order_relaxed));
+
+        // Il faut mettre le réveil des threads dans une boucle séparée
+        // car il faut être sur que toutes les Search soient bien initialisées.
+        // Les threads sont persistantes : on ne fait que les réveiller.
         for (size_t i = 0; i < nbrThreads; i++)
-        {
-            if (board.side_to_move == WHITE)
-                search[i].thread = std::thread(&Search::think<WHITE>, &search[i], board, timer, i);
-            else
-                search[i].thread = std::thread(&Search::think<BLACK>, &search[i], board, timer, i);
-        }
+            search[i]->start_searching(board, timer);
     }
 }
 
@@ -173,22 +339,33 @@ void ThreadPool::start_thinking(const Board& board, const Timer& timer)
 //-------------------------------------------------
 void ThreadPool::main_thread_stopped()
 {
+    watchdog.cancel();
+    mark_stop();
     searchStopped.store(true, std::memory_order_relaxed);
 }
 
 //=================================================
-//! \brief  Blocage du programme en attendant
-//! les threads.
+//! \brief  Commande uci "ponderhit" : l'adversaire a joué
+//! le coup attendu. La recherche en cours continue, la
+//! thread 0 passe en recherche limitée (Timer::ponderhit).
+//-------------------------------------------------
+void ThreadPool::ponderhit()
+{
+    watchdog.ponderhit();
+    pondering.store(false, std::memory_order_relaxed);
+}
+
+//=================================================
+//! \brief  Blocage du programme en attendant que
+//! les threads soient revenues au repos.
+//! Les threads ne sont pas détruites.
 //!
 //! \param[in]  start   indice de la première thread à attendre
 //-------------------------------------------------
 void ThreadPool::wait(size_t start)
 {
     for (size_t i = start; i < nbrThreads; i++)
-    {
-        if (search[i].thread.joinable())
-            search[i].thread.join();
-    }
+        search[i]->wait_for_search_finished();
 }
 
 //=================================================
@@ -197,10 +374,58 @@ void ThreadPool::wait(size_t start)
 //-------------------------------------------------
 void ThreadPool::stop()
 {
+    watchdog.cancel();
+    mark_stop();
+    pondering.store(false, std::memory_order_relaxed);
     searchStopped.store(true, std::memory_order_relaxed);
     wait(0);
 }
 
+//=================================================
+//! \brief  Échéance de la limite en temps (thread du Watchdog)
+//! Toutes les threads s'arrêtent ; la thread 0 affiche
+//! ensuite le résultat, comme pour "stop".
+//-------------------------------------------------
+void ThreadPool::watchdog_timeout()
+{
+    mark_stop();
+    searchStopped.store(true, std::memory_order_relaxed);
+}
+
+//=================================================
+//! \brief  Mémorise l'instant de la première demande
+//! d'arrêt de la recherche courante
+//-------------------------------------------------
+void ThreadPool::mark_stop()
+{
+    I64 expected = 0;
+    if (goTime.load(std::memory_order_relaxed) != 0)
+        stopTime.compare_exchange_strong(expected, now_ns(), std::memory_order_relaxed);
+}
+
+//=================================================
+//! \brief  Mesure la latence "go" -> première ligne "info".
+//! Appelée par la thread 0 à la fin de sa première itération.
+//-------------------------------------------------
+void ThreadPool::mark_first_info()
+{
+    const I64 start = goTime.load(std::memory_order_relaxed);
+    if (start != 0 && goLatency.load(std::memory_order_relaxed) == 0)
+        goLatency.store(std::max<I64>(1, (now_ns() - start) / 1000), std::memory_order_relaxed);
+}
+
+//=================================================
+//! \brief  Mesure la latence "stop" -> "bestmove".
+//! Appelée par la thread 0, une fois toutes les threads
+//! revenues au repos, juste avant d'afficher "bestmove".
+//-------------------------------------------------
+void ThreadPool::mark_bestmove()
+{
+    const I64 start = stopTime.load(std::memory_order_relaxed);
+    if (start != 0)
+        stopLatency.store(std::max<I64>(1, (now_ns() - start) / 1000), std::memory_order_relaxed);
+}
+
 //=================================================
 //! \brief  Sortie du programme
 //-------------------------------------------------
@@ -218,13 +443,14 @@ void ThreadPool::quit()
 int ThreadPool::get_best_thread() const
 {
     // À 1 thread, rien à départager : la thread principale (0) est retenue.
-    if (nbrThreads == 1)
+    // En MultiPV, seule la thread 0 a cherché toutes les lignes : elle est retenue.
+    if (nbrThreads == 1 || multiPV > 1)
         return 0;
 
     // Accesseurs sur les données finales d'une thread
-    auto final_score = [&](size_t i) { return search[i].pv_scores[search[i].best_depth]; };
-    auto final_move  = [&](size_t i) { return search[i].pv_moves [search[i].best_depth]; };
-    auto final_depth = [&](size_t i) { return search[i].best_depth; };
+    auto final_score = [&](size_t i) { return search[i]->pv_scores[search[i]->best_depth]; };
+    auto final_move  = [&](size_t i) { return search[i]->pv_moves [search[i]->best_depth]; };
+    auto final_depth = [&](size_t i) { return search[i]->best_depth; };
 
     // Score minimal parmi les threads
     int minScore = INFINITE;
@@ -243,7 +469,7 @@ int ThreadPool::get_best_thread() const
     // est jugée fiable ; une PV trop courte (≤ 2) voit son poids annulé.
     auto tiebreak_value = [&](size_t i) -> I64
     {
-        return search[i].last_pv.length > 2 ? thread_value(i) : 0;
+        return search[i]->last_pv.length > 2 ? thread_value(i) : 0;
     };
 
     // Chaque thread vote pour SON meilleur coup, avec son poids. Les threads ayant
@@ -287,13 +513,61 @@ int ThreadPool::get_best_thread() const
 
 //=================================================
 //! \brief  Retourne le nombre total des nodes recherchés
+//! Somme des compteurs de chaque thread (atomiques : lecture
+//! sans verrou pendant la recherche, pour "info nodes/nps")
 //-------------------------------------------------
 U64 ThreadPool::get_all_nodes() const
 {
     U64 total = 0;
     for (size_t i=0; i<nbrThreads; i++)
     {
-        total += search[i].nodes;
+        total += search[i]->nodes;
+    }
+    return(total);
+}
+
+//=================================================
+//! \brief  Retourne le nombre de nodes recherchés par nœud NUMA
+//! Sans placement NUMA, tout est compté sur le nœud 0.
+//-------------------------------------------------
+std::vector<U64> ThreadPool::get_nodes_per_numa() const
+{
+    std::vector<U64> total(Numa::is_active() ? Numa::nbr_nodes() : 1, 0);
+    for (size_t i=0; i<nbrThreads; i++)
+    {
+        total[Numa::node_of(i)] += search[i]->nodes;
+    }
+    return(total);
+}
+
+//=================================================
+//! \brief  Retourne les statistiques des Lazy Updates
+//! cumulées sur toutes les threads
+//-------------------------------------------------
+LazyStats ThreadPool::get_lazy_stats() const
+{
+    LazyStats total;
+    for (size_t i=0; i<nbrThreads; i++)
+    {
+        const LazyStats& stats = search[i]->nnue.get_lazy_stats();
+        total.refresh += stats.refresh;
+        for (int n = 0; n < 3; n++)
+            total.chain[n] += stats.chain[n];
+    }
+    return(total);
+}
+
+//=================================================
+//! \brief  Retourne les statistiques des caches d'évaluation, cumulées sur les threads
+//-------------------------------------------------
+EvalCacheStats ThreadPool::get_eval_cache_stats() const
+{
+    EvalCacheStats total;
+    for (size_t i=0; i<nbrThreads; i++)
+    {
+        const EvalCacheStats& stats = search[i]->eval_cache.get_stats();
+        total.probes += stats.probes;
+        total.hits   += stats.hits;
     }
     return(total);
 }
@@ -306,7 +580,7 @@ int ThreadPool::get_all_depths() const
     int total = 0;
     for (size_t i=0; i<nbrThreads; i++)
     {
-        total += search[i].best_depth;
+        total += search[i]->best_depth;
     }
     return(total);
 }
@@ -319,7 +593,7 @@ U64 ThreadPool::get_all_tbhits() const
     U64 total = 0;
     for (size_t i=0; i<nbrThreads; i++)
     {
-        total += search[i].tbhits;
+        total += search[i]->tbhits;
     }
     return(total);
 }
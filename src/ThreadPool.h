@@ -3,42 +3,70 @@
 
 class ThreadPool;
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 #include "defines.h"
 #include "Board.h"
 #include "Timer.h"
 #include "Search.h"
+#include "Watchdog.h"
 
 class ThreadPool
 {
 public:
     explicit ThreadPool(U32 _nbr, bool _tb, bool _log);
     void set_threads(U32 nbr);
+    void set_numa(bool f);
+    void set_net_replicas(bool f);
+    bool load_network(const std::string& filename);
+    bool set_eval_file(const std::string& filename);
+    void set_shared_network(bool f);
+    void set_eval_cache(U64 kb);
     void reset();
     void reinit_reductions();
 
-    void start_thinking(const Board &board, const Timer &timer);
+    void start_thinking(const Board &board, const Timer &timer, const MoveList& search_moves = MoveList());
     void main_thread_stopped();
+    void ponderhit();
     void stop();
     void wait(size_t start);
     void quit();
 
     U64  get_all_nodes() const;
+    std::vector<U64> get_nodes_per_numa() const;
+    LazyStats get_lazy_stats() const;
+    EvalCacheStats get_eval_cache_stats() const;
     int  get_all_depths() const;
     int  get_best_thread() const;
     //! \brief  Retourne le meilleur coup, joué par la thread retenue par get_best_thread()
     MOVE get_best_move() const {
         int bt = get_best_thread();
-        return search[bt].pv_moves[search[bt].best_depth];
+        return search[bt]->pv_moves[search[bt]->best_depth];
     }
     U64  get_all_tbhits() const;
 
+    void mark_first_info();
+    void mark_bestmove();
+    //! \brief  Latence "go" -> première ligne "info" de la dernière recherche, en microsecondes
+    I64  get_go_latency()   const { return goLatency.load(std::memory_order_relaxed);   }
+    //! \brief  Latence "stop" -> "bestmove" de la dernière recherche, en microsecondes
+    I64  get_stop_latency() const { return stopLatency.load(std::memory_order_relaxed); }
+    //! \brief  Retard du Watchdog sur l'échéance de la dernière recherche, en microsecondes (-1 : pas d'échéance)
+    I64  get_watchdog_lateness() const { return watchdog.get_lateness(); }
+    //! \brief  La thread 0 a atteint Watchdog::MIN_DEPTH : la limite en temps s'applique
+    void arm_watchdog() { watchdog.arm(); }
+
     //! \brief  Active/désactive l'affichage des informations UCI pendant la recherche
     void set_logUci(bool f)          { logUci = f;       }
     //! \brief  Active/désactive l'utilisation des tables Syzygy
     void set_useSyzygy(bool f)       { useSyzygy = f;    }
     //! \brief  Fixe le nombre maximum de pièces pour le probe Syzygy WDL/DTZ
     void set_syzygyProbeLimit(int n) { syzygyProbeLimit = n; }
+    //! \brief  Active/désactive l'option UCI "Ponder"
+    void set_usePonder(bool f)       { usePonder = f;    }
+    //! \brief  Fixe le nombre de lignes cherchées (option UCI "MultiPV")
+    void set_multiPV(int n)          { multiPV = std::clamp(n, 1, MAX_MULTIPV); }
 
     //! \brief  Indique si l'affichage des informations UCI est actif
     bool get_logUci()           const { return logUci; }
@@ -48,16 +76,39 @@ public:
     bool get_useSyzygy()        const { return useSyzygy; }
     //! \brief  Retourne le nombre maximum de pièces pour le probe Syzygy WDL/DTZ
     int  get_syzygyProbeLimit() const { return syzygyProbeLimit; }
+    //! \brief  Indique si la GUI autorise le "ponder" (option UCI "Ponder")
+    bool get_usePonder()        const { return usePonder; }
+    //! \brief  Retourne le nombre de lignes cherchées (option UCI "MultiPV")
+    int  get_multiPV()          const { return multiPV; }
 
-    std::unique_ptr<Search[]> search;
-    std::atomic<bool> searchStopped{false};
+    std::vector<std::unique_ptr<Search>> search;
+    alignas(64) std::atomic<U64>  searchNodes{0};     // nodes publiés par toutes les threads (Search::publish_nodes)
+    alignas(64) std::atomic<bool> searchStopped{false};
+    std::atomic<bool> pondering{false};     // "go ponder" en cours, pas encore de "ponderhit"
 
 private:
     U32     nbrThreads;
     bool    useSyzygy;
     int     syzygyProbeLimit;  // max pieces for WDL/DTZ probing (0 = no limit)
     bool    logUci;
+    bool    usePonder   = false;  // option UCI "Ponder"
+    int     multiPV     = 1;      // option UCI "MultiPV"
+    bool    netReplicas = true;   // copie du réseau sur chaque nœud NUMA
+    bool    netShared   = false;  // réseau en mémoire partagée entre processus
+    U64     evalCacheKB = EVAL_CACHE_SIZE;  // taille du cache d'évaluation de chaque thread
+
+    // Mesures de latence (en nanosecondes depuis l'epoch de TimePoint ; 0 = pas encore mesuré)
+    std::atomic<I64> goTime{0};         // appel de start_thinking
+    std::atomic<I64> stopTime{0};       // première demande d'arrêt (stop, ou fin de la thread 0)
+    std::atomic<I64> goLatency{0};      // en microsecondes
+    std::atomic<I64> stopLatency{0};    // en microsecondes
+
+    // Surveillance de la limite en temps ; déclaré en dernier : détruit en premier
+    Watchdog watchdog{[this]{ watchdog_timeout(); }};
 
+    void mark_stop();
+    void watchdog_timeout();
+    void create_threads(U32 nbr);
 };
 
 extern ThreadPool threadPool;
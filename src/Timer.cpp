@@ -31,6 +31,7 @@ Timer::Timer(bool infinite,
     limits.movetime    = movetime;
 
     mode               = TimerMode::TIME;
+    ponderedMode       = TimerMode::TIME;
     this->moveOverhead = moveOverhead;
     timeForThisDepth   = 0;
     timeForThisMove    = 0;
@@ -58,7 +59,6 @@ void Timer::start()
     startTime = TimePoint::now();
     std::fill(MoveNodeCounts.begin(), MoveNodeCounts.end(), 0);
     pv_stability = 0;
-    counter      = MAX_COUNTER;
 }
 
 //===========================================================
@@ -168,6 +168,13 @@ void Timer::setup(Color color)
         timeForThisMove  = std::min(timeForThisMove,  time_remaining);
     }
 
+    // Les limites calculées ne s'appliqueront qu'au "ponderhit"
+    if (limits.ponder)
+    {
+        ponderedMode = mode;
+        mode         = TimerMode::PONDER;
+    }
+
 #if defined DEBUG_TIME
     debug(color);
 #endif
@@ -187,57 +194,33 @@ void Timer::setup(U64 soft_limit, U64 hard_limit)
     nodesForThisMove  = hard_limit;
 }
 
-//=========================================================
-//! \brief  Controle du time-out
-//! \param[in]  depth       profondeur de recherche courante
-//! \param[in]  index       index du thread (le contrôle n'est fait que pour le thread 0)
-//! \param[in]  total_nodes nombre total de noeuds calculés
-//! \return Retourne "true" si la recherche a dépassé sa limite de temps
-//!
-//! De façon à éviter un nombre important de mesure de temps , on ne fera
-//! ce calcul que tous les MAX_COUNTER .
+//============================================================
+//! \brief  Recherche en "ponder"
+//! À appeler avant setup(color). La recherche n'a aucune limite
+//! tant que "flag" vaut "true" ; elle prend ensuite les limites
+//! données par "go ponder", voir ponderhit().
 //!
-//! On ne coupe jamais la toute première itération (depth == 1), pour
-//! garantir qu'un coup soit toujours enregistré avant un abandon.
-
-//---------------------------------------------------------
-bool Timer::check_limits(const int depth, const int index, const U64 total_nodes)
+//! \param[in]  flag    mis à "false" par la commande "ponderhit"
+//------------------------------------------------------------
+void Timer::set_ponder(const std::atomic<bool>* flag)
 {
-    if (index == 0)
-    {
-        if (mode == TimerMode::TIME && depth >= 4)
-        {
-            // ce mode est utilisé :
-            //  > pour le jeu normal
-            // Toutes les MAX_COUNTER itérations, on vérifie si le temps est écoulé.
-            if (--counter > 0)
-                return false;
-            counter = MAX_COUNTER;
-
-            return(elapsedTime() > timeForThisMove);
-        }
-        else if (mode == TimerMode::NODE)
-        {
-            // ce mode est utilisé :
-            //  > pour datagen,
-            //  > pour des tests perso (run ...)
-            return (depth > 1 && total_nodes > nodesForThisMove);
-        }
-        else if (mode == TimerMode::DEPTH)
-        {
-            // ce mode est utilisé :
-            //  > pour le bench
-            //  > pour datagen, dans la partie random_game
-            //  > pour des tests perso (run ...)
-            return (depth > searchDepth);
-        }
-        else
-        {
-            // Problème
-        }
-    }
+    limits.ponder = true;
+    ponderFlag    = flag;
+}
 
-    return false;
+//============================================================
+//! \brief  L'adversaire a joué le coup attendu ("ponderhit")
+//!
+//! La recherche continue, avec les limites calculées par setup(color)
+//! pour la pendule reçue avec "go ponder". Le temps est compté à
+//! partir d'ici : le temps de réflexion de l'adversaire est gagné.
+//! Seul le Timer de la thread 0 est converti, par check_limits ;
+//! l'échéance est surveillée par le Watchdog du ThreadPool.
+//------------------------------------------------------------
+void Timer::ponderhit()
+{
+    mode      = ponderedMode;
+    startTime = TimePoint::now();
 }
 
 //===========================================================
@@ -3,6 +3,7 @@
 
 class Timer;
 
+#include <atomic>
 #include <chrono>
 #include "defines.h"
 #include "types.h"
@@ -10,7 +11,8 @@ class Timer;
 enum TimerMode {
     TIME,
     DEPTH,
-    NODE
+    NODE,
+    PONDER      // "go ponder" : aucune limite jusqu'à "ponderhit"
 };
 
 struct Limits {
@@ -21,8 +23,9 @@ struct Limits {
     U64  nodes;       // limite la recherche par nombre de nodes cherchés
     int  movetime;    // limite la recherche par temps
     bool infinite;    // ignore les limites (recherche infinie)
+    bool ponder;      // recherche pendant le temps de l'adversaire ("go ponder")
 
-    Limits() : time{}, incr{}, movestogo(0), depth(0), nodes(0), movetime(0), infinite(false) {}
+    Limits() : time{}, incr{}, movestogo(0), depth(0), nodes(0), movetime(0), infinite(false), ponder(false) {}
 };
 
 class Timer
@@ -58,13 +61,87 @@ public:
     void start();
     void setup(Color color);
     void setup(U64 soft_limit, U64 hard_limit);
-    bool check_limits(const int depth, const int index, const U64 total_nodes);
+    void set_ponder(const std::atomic<bool>* flag);
+    void ponderhit();
+
+    //=========================================================
+    //! \brief  Controle des limites de la recherche, à chaque nœud
+    //! \param[in]  depth       profondeur de recherche courante
+    //! \param[in]  index       index du thread (le contrôle n'est fait que pour le thread 0,
+    //!                         sauf la limite en nodes)
+    //! \param[in]  total_nodes nombre total de noeuds calculés, toutes threads confondues
+    //! \return Retourne "true" si la recherche a dépassé sa limite
+    //!
+    //! La limite en temps n'est pas contrôlée ici : le Watchdog du
+    //! ThreadPool lève le flag d'arrêt à l'échéance (get_hard_limit).
+    //!
+    //! On ne coupe jamais la toute première itération (depth == 1), pour
+    //! garantir qu'un coup soit toujours enregistré avant un abandon.
+    //---------------------------------------------------------
+    bool check_limits(const int depth, const int index, const U64 total_nodes)
+    {
+        if (mode == TimerMode::NODE)
+        {
+            // ce mode est utilisé :
+            //  > pour datagen,
+            //  > pour "go nodes" et des tests perso (run ...)
+            // Toutes les threads contrôlent le total : une comparaison, sans mesure de temps.
+            return (depth > 1 && total_nodes > nodesForThisMove);
+        }
+
+        if (index == 0)
+        {
+            if (mode == TimerMode::DEPTH)
+            {
+                // ce mode est utilisé :
+                //  > pour le bench
+                //  > pour datagen, dans la partie random_game
+                //  > pour des tests perso (run ...)
+                return (depth > searchDepth);
+            }
+            else if (mode == TimerMode::PONDER)
+            {
+                // ce mode est utilisé :
+                //  > pour "go ponder", jusqu'au "ponderhit"
+                if (!ponderFlag->load(std::memory_order_relaxed))
+                    ponderhit();
+            }
+        }
+
+        return false;
+    }
+
     bool finishOnThisDepth(int elapsed, int depth, U64 total_nodes, const int* pv_scores, const MOVE *pv_moves);
 
     //===========================================================
     //! \brief  Retourne la profondeur de recherche imposée
     //-----------------------------------------------------------
     int  getSearchDepth() const { return(searchDepth); }
+    //===========================================================
+    //! \brief  Indique si la recherche a été lancée par "go ponder"
+    //-----------------------------------------------------------
+    bool is_pondering_requested() const { return limits.ponder; }
+    //===========================================================
+    //! \brief  Indique si la recherche est toujours en "ponder"
+    //! (pas encore de "ponderhit", ni de "stop")
+    //-----------------------------------------------------------
+    bool is_pondering() const { return mode == TimerMode::PONDER && ponderFlag->load(std::memory_order_relaxed); }
+    //===========================================================
+    //! \brief  Indique si la recherche est limitée en nombre de nodes
+    //-----------------------------------------------------------
+    bool is_node_limited() const { return mode == TimerMode::NODE; }
+    //===========================================================
+    //! \brief  Temps maximum de la recherche en millisecondes, compté
+    //! depuis start() (ou le "ponderhit") ; -1 si pas de limite en temps
+    //-----------------------------------------------------------
+    I64  get_hard_limit() const {
+        const int m = (mode == TimerMode::PONDER) ? ponderedMode : mode;
+        return (m == TimerMode::TIME) ? timeForThisMove : -1;
+    }
+    //===========================================================
+    //! \brief  Début de la recherche (start)
+    //-----------------------------------------------------------
+    TimePoint::time_point get_start_time() const { return startTime; }
     I64  elapsedTime() const;
 
     void updateMoveNodes(MOVE move, U64 nodes);
@@ -73,13 +150,12 @@ public:
 private:
     Limits limits;
 
-    constexpr static U32 MAX_COUNTER = 2048;
-    U32 counter {MAX_COUNTER};
-
     // donne le moment exact où cette recherche a démarré.
     TimePoint::time_point startTime;
 
     int  mode;
+    int  ponderedMode;           // mode appliqué au "ponderhit"
+    const std::atomic<bool>* ponderFlag = nullptr;  // "true" jusqu'au "ponderhit" (ThreadPool::pondering)
     int  moveOverhead;           // temps de réserve pour l'interface (option UCI MoveOverhead)
     I64  timeForThisDepth;       // temps pour "iterative deepening"
     I64  timeForThisMove;        // temps pour une recherche "alpha-beta" ou "quiescence"
@@ -4,13 +4,43 @@
 #include "defines.h"
 #include <iostream>
 #include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
 #include "Move.h"
 #include "TranspositionTable.h"
+#include "Numa.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
 
 
 // Code inspiré de Sungorus, puis Stormphrax
 // Idées provenant de Bruce Moreland
 
+//  En-tête du fichier de sauvegarde de la table (commandes ttsave/ttload)
+//  Les clusters suivent l'en-tête, tels qu'ils sont en mémoire.
+struct TTFileHeader {
+    char magic[8];          // "ZANGTT"
+    U32  version;           // version du format de fichier
+    U32  entry_size;        // sizeof(HashEntry) : distingue les formats 32 et 16 bits
+    U32  cluster_size;      // nombre d'entrées par cluster
+    U32  tt_age;            // âge de la table au moment de la sauvegarde
+    U64  nbr_cluster;       // nombre de clusters
+};
+
+static_assert(sizeof(TTFileHeader) == 32);
+
+static constexpr char   TT_FILE_MAGIC[8]  = "ZANGTT";
+static constexpr U32    TT_FILE_VERSION   = 1;
+static constexpr size_t TT_FILE_CHUNK     = 64 * 1024 * 1024;      // taille des blocs lus ou écrits
+
 
 #include <cassert>
 #include "TranspositionTable.h"
@@ -21,13 +51,13 @@
 //! \brief  Constructeur avec argument
 //! \param[in]  MB  taille de la table de transposition, en mégaoctets
 //--------------------------------------------------------
-TranspositionTable::TranspositionTable(int MB) :
+TranspositionTable::TranspositionTable(U64 MB) :
     nbr_cluster(0),
     tt_age(0)
 {
 #if defined DEBUG_LOG
     char message[100];
-    sprintf(message, "TranspositionTable::constructeur MB : %d ", MB);
+    sprintf(message, "TranspositionTable::constructeur MB : %llu ", static_cast<unsigned long long>(MB));
     printlog(message);
 #endif
 
@@ -39,21 +69,170 @@ TranspositionTable::TranspositionTable(int MB) :
 //--------------------------------------------------------
 TranspositionTable::~TranspositionTable()
 {
+    deallocate();
+}
+
+//========================================================
+//! \brief  Allocation de la mémoire de la table
+//!
+//! La mémoire est alignée sur 2 Mo, et sous Linux on demande au noyau
+//! de la servir en "huge pages" (Transparent Huge Pages, madvise).
+//! Chaque probe n'utilise alors qu'une entrée du TLB pour 2 Mo au lieu de 4 Ko.
+//! Si le noyau refuse (THP désactivé, autre OS), on garde simplement
+//! des pages normales. Le noyau peut aussi accorder moins de huge pages
+//! que demandé : info() donne la quantité réellement obtenue.
+//! La mémoire n'est pas touchée ici : c'est clear() qui s'en charge.
+//!
+//! \param[in]  size    taille demandée, en octets
+//--------------------------------------------------------
+void TranspositionTable::allocate(size_t size)
+{
+    // aligned_alloc exige une taille multiple de l'alignement
+    alloc_size = ((size + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
+    huge_pages = false;
+
+#if defined(_WIN32)
+    tt_entries = static_cast<HashCluster*>(_aligned_malloc(alloc_size, PAGE_SIZE));
+#else
+    tt_entries = static_cast<HashCluster*>(std::aligned_alloc(PAGE_SIZE, alloc_size));
+#endif
+
+    if (tt_entries == nullptr)
+    {
+        std::cout << "info string TranspositionTable : impossible d'allouer " << alloc_size / 1024 / 1024 << " Mo" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (madvise(tt_entries, alloc_size, MADV_HUGEPAGE) == 0)
+    {
+        // madvise réussit même si THP est à "never" : on vérifie la config du noyau.
+        // Ce n'est qu'une demande : voir huge_pages_size()
+        std::ifstream thp("/sys/kernel/mm/transparent_hugepage/enabled");
+        std::string   mode;
+        std::getline(thp, mode);
+        huge_pages = thp.is_open() && mode.find("[never]") == std::string::npos;
+    }
+#endif
+
+    // avec libnuma, les pages sont entrelacées sur tous les nœuds
+    Numa::interleave(tt_entries, alloc_size);
+}
+
+//========================================================
+//! \brief  Libération de la mémoire de la table
+//--------------------------------------------------------
+void TranspositionTable::deallocate()
+{
+    if (tt_entries == nullptr)
+        return;
+
+#if defined(_WIN32)
+    _aligned_free(tt_entries);
+#else
+    std::free(tt_entries);
+#endif
+    tt_entries = nullptr;
+    alloc_size = 0;
+}
+
+//========================================================
+//! \brief  Mémoire de la table servie en huge pages
+//!
+//! Lue dans /proc/self/smaps (AnonHugePages) : le noyau n'accorde les
+//! huge pages qu'au premier accès, et peut se rabattre sur des pages
+//! normales (mémoire fragmentée). madvise isole la table dans sa propre
+//! zone ; on n'accepte que la zone [table, table + alloc_size[ exacte.
+//! Une zone plus large (tas, zones fusionnées) décrirait autre chose.
+//!
+//! \param[out] bytes   taille servie en huge pages, en octets
+//! \return "false" si la quantité est inconnue (hors Linux, zone non isolée)
+//--------------------------------------------------------
+bool TranspositionTable::huge_pages_size(size_t& bytes) const
+{
+    bytes = 0;
+
+#if defined(__linux__)
+    if (tt_entries == nullptr)
+        return false;
+
+    std::ifstream smaps("/proc/self/smaps");
+    const auto    first = reinterpret_cast<std::uintptr_t>(tt_entries);
+    const auto    last  = first + alloc_size;
+    bool          found = false;
+    std::string   line;
+
+    while (std::getline(smaps, line))
+    {
+        // en-tête d'une zone : "début-fin perms offset ..."
+        unsigned long long start = 0, end = 0;
+        if (std::sscanf(line.c_str(), "%llx-%llx ", &start, &end) == 2)
+        {
+            if (found)
+                break;
+            found = (start == first && end == last);
+        }
+        else if (found)
+        {
+            size_t kb = 0;
+            if (std::sscanf(line.c_str(), "AnonHugePages: %zu kB", &kb) == 1)
+            {
+                bytes = kb * 1024;
+                return true;
+            }
+        }
+    }
+#endif
+
+    return false;
+}
+
+//========================================================
+//! \brief  Nombre de threads utilisées par clear() et load()
+//! Celles de la recherche (option Threads) : plusieurs moteurs
+//! peuvent tourner sur la machine. Chaque thread traite au moins
+//! MIN_SLICE octets ; une petite table est traitée sur place.
+//--------------------------------------------------------
+size_t TranspositionTable::slice_threads() const
+{
+    const size_t slices = nbr_cluster * sizeof(HashCluster) / MIN_SLICE;
+    return std::clamp<size_t>(slices, 1, nbr_threads);
+}
+
+//========================================================
+//! \brief  Taille maximale de la table, en mégaoctets
+//!
+//! MAX_HASH_SIZE est une borne théorique ; on la limite
+//! à la mémoire physique de la machine quand on peut la connaître.
+//--------------------------------------------------------
+U64 TranspositionTable::max_size()
+{
+    U64 max_mb = MAX_HASH_SIZE;
+
+#if defined(_SC_PHYS_PAGES) && defined(_SC_PAGE_SIZE)
+    const long pages     = sysconf(_SC_PHYS_PAGES);
+    const long page_size = sysconf(_SC_PAGE_SIZE);
+    if (pages > 0 && page_size > 0)
+        max_mb = std::min(max_mb, static_cast<U64>(pages) * static_cast<U64>(page_size) / (1024 * 1024));
+#endif
+
+    return std::max(max_mb, MIN_HASH_SIZE);
 }
 
 //========================================================
 //! \brief  Initialisation de la table
 //! \param[in]  mbsize  taille de la table de transposition, en mégaoctets
 //--------------------------------------------------------
-void TranspositionTable::init_size(int mbsize)
+void TranspositionTable::init_size(U64 mbsize)
 {
 #if defined DEBUG_LOG
     char message[1000];
-    sprintf(message, "TranspositionTable::init_size : %d ", mbsize);
+    sprintf(message, "TranspositionTable::init_size : %llu ", static_cast<unsigned long long>(mbsize));
     printlog(message);
 #endif
 
-    size_t size  = (mbsize * 1024 * 1024) / sizeof(HashCluster);
+    // Calcul en 64 bits : avec des int, mbsize * 1024 * 1024 déborde dès 2 Go
+    size_t size  = static_cast<size_t>(mbsize * 1024 * 1024 / sizeof(HashCluster));
 
     // L'index est calculé par : key & tt_mask
     // if faut que le nombre de clusters soit un multiple de 2
@@ -61,8 +240,9 @@ void TranspositionTable::init_size(int mbsize)
 
     if (size != nbr_cluster)
     {
+        deallocate();
         nbr_cluster = size;
-        tt_entries.resize(nbr_cluster);
+        allocate(nbr_cluster * sizeof(HashCluster));
     }
 
     clear();
@@ -87,8 +267,37 @@ void TranspositionTable::clear(void)
 
     tt_age = 0;
 
-    // réinitialise chaque HashCluster à sa valeur par défaut
-    std::fill(tt_entries.begin(), tt_entries.end(), HashCluster{});
+    // Chaque thread remet à zéro sa propre tranche de la table.
+    // C'est aussi le premier accès à la mémoire après allocate() :
+    // sur une grosse table, un seul thread mettrait plusieurs secondes.
+    const size_t nthreads = slice_threads();
+    const size_t stride   = nbr_cluster / nthreads;
+
+    auto clear_slice = [this, stride, nthreads](size_t t)
+    {
+        // sur une machine NUMA, la tranche t est placée sur le nœud de la thread t
+        if (nthreads > 1)
+            Numa::bind_thread(t);
+
+        const size_t start = t * stride;
+        const size_t end   = (t == nthreads - 1) ? nbr_cluster : start + stride;
+
+        // réinitialise chaque HashCluster à sa valeur par défaut
+        std::fill(tt_entries + start, tt_entries + end, HashCluster{});
+    };
+
+    if (nthreads == 1)
+    {
+        clear_slice(0);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(nthreads);
+    for (size_t t = 0; t < nthreads; t++)
+        workers.emplace_back(clear_slice, t);
+    for (auto& w : workers)
+        w.join();
 }
 
 //========================================================
@@ -107,11 +316,14 @@ void TranspositionTable::store(U64 key, MOVE move, int score, int eval, int boun
     assert(0 <= depth && depth <= MAX_PLY);
     assert(move != Move::MOVE_NULL);
 
-    // extrait la clé 32 bits à partir du hash Zobrist 64 bits
-    // U32 key32 = (key >> 32);
-    const U32 key32 = static_cast<U32>(key);
-    //  static_cast<U16>(key);
-    // key & 0xFFFF;
+    // extrait la clé 32 (ou 16) bits à partir du hash Zobrist 64 bits
+    // Ce sont les bits de poids faible : l'index du cluster utilise les bits de poids fort
+    const TTKey key_tt = static_cast<TTKey>(key);
+#if defined USE_TT_KEY16
+    const TTMove move_tt = Move::pack(move);
+#else
+    const TTMove move_tt = move;
+#endif
 
     /*
     hash64  = 8020241708cd0710 ;
@@ -132,7 +344,7 @@ void TranspositionTable::store(U64 key, MOVE move, int score, int eval, int boun
         //     auquel cas une entrée avec un score de recherche est préférable
         // >>> autrement dit on met en cache un score d'évaluation statique et non un score de
         //     recherche, pour éviter d'appeler eval
-        if (entry.key32 == key32 || entry.bound() == BOUND_NONE)
+        if (entry.key == key_tt || entry.bound() == BOUND_NONE)
         {
             replace = &entry;
             break;
@@ -153,17 +365,17 @@ void TranspositionTable::store(U64 key, MOVE move, int score, int eval, int boun
     // On n'écrase pas une entrée de la même position, sauf si on a
     // une borne exacte ou une profondeur presque aussi bonne que l'ancienne
     if ((bound == BOUND_EXACT
-         || key32 != replace->key32
+         || key_tt != replace->key
          || replace->relative_age(tt_age)           // replace->age() != tt_age
          || depth + 3 + 2*pv > replace->depth))
     {
         // idée de Sirius, Stockfish et Ethereal
         // Préserve le coup existant pour la même position
         // Ne pas écraser le coup s'il n'y a pas de nouveau meilleur coup
-        if (move != Move::MOVE_NONE || replace->key32 != key32)
-            replace->move = move;
+        if (move != Move::MOVE_NONE || replace->key != key_tt)
+            replace->move = move_tt;
 
-        replace->key32  = key32;
+        replace->key    = key_tt;
         replace->score  = static_cast<I16>(ScoreToTT(score, ply));
         replace->eval   = static_cast<I16>(eval);
         replace->depth  = static_cast<U08>(depth);
@@ -175,7 +387,8 @@ void TranspositionTable::store(U64 key, MOVE move, int score, int eval, int boun
 //! \brief  Recherche d'une donnée dans la table de transposition
 //! \param[in]  key     code hash (Zobrist) de la position recherchée
 //! \param[in]  ply     profondeur (distance à la racine) de la position
-//! \param[out] move    coup trouvé
+//! \param[out] move    coup trouvé ; avec USE_TT_KEY16, c'est le coup compressé
+//!                     qu'il faut reconstruire avec Board::unpack_move
 //! \param[out] score   score de la position (converti depuis le format TT)
 //! \param[out] eval    évaluation statique stockée
 //! \param[out] bound   type de borne (BOUND_NONE/UPPER/LOWER/EXACT)
@@ -185,12 +398,12 @@ void TranspositionTable::store(U64 key, MOVE move, int score, int eval, int boun
 //--------------------------------------------------------
 bool TranspositionTable::probe(U64 key, int ply, MOVE& move, int &score, int& eval, int &bound, int& depth, bool& pv)
 {
-    // extrait la clé 32 bits à partir du hash Zobrist 64 bits
-    const U32 key32 = static_cast<U32>(key);
+    // extrait la clé 32 (ou 16) bits à partir du hash Zobrist 64 bits
+    const TTKey key_tt = static_cast<TTKey>(key);
     const HashCluster& cluster = tt_entries[index(key)];
     for (const HashEntry& entry : cluster.entries)
     {
-        if (entry.key32 == key32)
+        if (entry.key == key_tt)
         {
             move  = entry.move;
             bound = entry.bound();
@@ -214,19 +427,20 @@ bool TranspositionTable::probe(U64 key, int ply, MOVE& move, int &score, int& ev
 int TranspositionTable::hash_full() const
 {
     int used = 0;
+    const size_t samples = std::min<size_t>(1000, nbr_cluster);
 
-    for (int i = 0; i < 1000; i++)
+    for (size_t i = 0; i < samples; i++)
     {
         for (size_t j=0; j<CLUSTER_SIZE; j++)
         {
-            if (   tt_entries[i].entries[j].move != Move::MOVE_NONE
+            if (   tt_entries[i].entries[j].move != 0
                    && tt_entries[i].entries[j].age() == tt_age
                    )
                 used++;
         }
     }
 
-    return used/CLUSTER_SIZE;
+    return static_cast<int>(used * 1000 / (samples * CLUSTER_SIZE));
 }
 
 
@@ -239,6 +453,9 @@ std::string TranspositionTable::info()
 {
     std::stringstream sstr;
 
+    size_t     huge  = 0;
+    const bool known = huge_pages_size(huge);
+
     sstr <<      "Nombre de clusters  : " << std::to_string(nbr_cluster) << std::endl
               << "Taille d'un cluster : " << sizeof(HashCluster) << " octets" << std::endl
               << "Entrées par cluster : " << CLUSTER_SIZE << std::endl
@@ -246,7 +463,153 @@ std::string TranspositionTable::info()
               << "Total entrées       : " << nbr_cluster * CLUSTER_SIZE << std::endl
               << "Taille totale       : " << nbr_cluster*sizeof(HashCluster) << "  " << nbr_cluster*CLUSTER_SIZE*sizeof(HashEntry)
               << " (" << nbr_cluster*sizeof(HashCluster)/1024.0/1024.0 << ") Mo"
-              << std::endl;
+              << std::endl
+              << "Pages mémoire       : " << (huge_pages ? "2 Mo (huge pages demandées)" : "4 Ko (pages normales)") << std::endl
+              << "Huge pages obtenues : " << (known ? std::to_string(huge / 1024 / 1024) + " Mo sur " + std::to_string(alloc_size / 1024 / 1024)
+                                               : std::string("inconnu (table non isolée)")) << std::endl
+              << "Threads pour clear  : " << slice_threads() << std::endl;
 
     return sstr.str();
 }
+
+
+//=======================================================================
+//! \brief  Sauvegarde de la table de transposition dans un fichier
+//!
+//! Le fichier contient un en-tête (format des entrées, nombre de clusters,
+//! âge de la table), puis les clusters tels qu'ils sont en mémoire.
+//! Il n'est donc relisible que par une version utilisant le même format
+//! d'entrée (USE_TT_KEY16 ou non) et la même taille de table.
+//!
+//! \param[in]  filename    nom du fichier à créer
+//! \return Retourne "true" si la sauvegarde a réussi
+//-----------------------------------------------------------------------
+bool TranspositionTable::save(const std::string& filename) const
+{
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cout << "info string TranspositionTable : impossible de créer le fichier " << filename << std::endl;
+        return false;
+    }
+
+    TTFileHeader header{};
+    std::memcpy(header.magic, TT_FILE_MAGIC, sizeof(header.magic));
+    header.version      = TT_FILE_VERSION;
+    header.entry_size   = sizeof(HashEntry);
+    header.cluster_size = CLUSTER_SIZE;
+    header.tt_age       = tt_age;
+    header.nbr_cluster  = nbr_cluster;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // écriture par blocs : certaines implémentations limitent la taille d'un write
+    const char*  data  = reinterpret_cast<const char*>(tt_entries);
+    const size_t total = nbr_cluster * sizeof(HashCluster);
+    for (size_t done = 0; done < total && file.good(); done += TT_FILE_CHUNK)
+        file.write(data + done, static_cast<std::streamsize>(std::min(TT_FILE_CHUNK, total - done)));
+
+    file.close();
+    if (!file)
+    {
+        std::cout << "info string TranspositionTable : erreur d'écriture dans " << filename << std::endl;
+        return false;
+    }
+
+    std::cout << "info string TranspositionTable : " << total / 1024 / 1024 << " Mo sauvegardés dans " << filename << std::endl;
+    return true;
+}
+
+//=======================================================================
+//! \brief  Chargement de la table de transposition depuis un fichier
+//!
+//! L'en-tête est vérifié : un fichier d'un autre format ou d'une autre
+//! taille de table est refusé, et la table actuelle est conservée.
+//! La lecture est répartie entre plusieurs threads, chacune ouvrant
+//! le fichier et lisant directement sa tranche dans la table.
+//!
+//! \param[in]  filename    nom du fichier à lire
+//! \return Retourne "true" si le chargement a réussi
+//-----------------------------------------------------------------------
+bool TranspositionTable::load(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        std::cout << "info string TranspositionTable : impossible d'ouvrir le fichier " << filename << std::endl;
+        return false;
+    }
+
+    const U64 file_size = static_cast<U64>(file.tellg());
+    TTFileHeader header{};
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (   !file
+        || std::memcmp(header.magic, TT_FILE_MAGIC, sizeof(header.magic)) != 0
+        || header.version      != TT_FILE_VERSION
+        || header.entry_size   != sizeof(HashEntry)
+        || header.cluster_size != CLUSTER_SIZE
+        || header.tt_age        > HashEntry::AgeMask)
+    {
+        std::cout << "info string TranspositionTable : format de fichier incompatible (" << filename << ")" << std::endl;
+        return false;
+    }
+
+    if (header.nbr_cluster != nbr_cluster)
+    {
+        std::cout << "info string TranspositionTable : le fichier contient " << header.nbr_cluster
+                  << " clusters, la table en a " << nbr_cluster
+                  << " ; utiliser Hash = " << header.nbr_cluster * sizeof(HashCluster) / 1024 / 1024 << std::endl;
+        return false;
+    }
+
+    const size_t total = nbr_cluster * sizeof(HashCluster);
+    if (file_size != sizeof(TTFileHeader) + total)
+    {
+        std::cout << "info string TranspositionTable : fichier tronqué (" << filename << ")" << std::endl;
+        return false;
+    }
+    file.close();
+
+    // Lecture répartie comme clear()
+    const size_t nthreads = slice_threads();
+    const size_t stride   = nbr_cluster / nthreads;
+    std::vector<char> ok(nthreads, 0);
+
+    auto load_slice = [this, &filename, &ok, stride, nthreads](size_t t)
+    {
+        const size_t start = t * stride;
+        const size_t end   = (t == nthreads - 1) ? nbr_cluster : start + stride;
+
+        std::ifstream in(filename, std::ios::binary);
+        in.seekg(static_cast<std::streamoff>(sizeof(TTFileHeader) + start * sizeof(HashCluster)));
+
+        char*        data = reinterpret_cast<char*>(tt_entries + start);
+        const size_t size = (end - start) * sizeof(HashCluster);
+        for (size_t done = 0; done < size && in.good(); done += TT_FILE_CHUNK)
+            in.read(data + done, static_cast<std::streamsize>(std::min(TT_FILE_CHUNK, size - done)));
+
+        ok[t] = in.good();
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(nthreads);
+    for (size_t t = 0; t < nthreads; t++)
+        workers.emplace_back(load_slice, t);
+    for (auto& w : workers)
+        w.join();
+
+    if (std::find(ok.begin(), ok.end(), 0) != ok.end())
+    {
+        // la table est partiellement écrasée : on repart d'une table vide
+        std::cout << "info string TranspositionTable : erreur de lecture dans " << filename << std::endl;
+        clear();
+        return false;
+    }
+
+    tt_age = header.tt_age;
+
+    std::cout << "info string TranspositionTable : " << total / 1024 / 1024 << " Mo chargés depuis " << filename << std::endl;
+    return true;
+}
@@ -15,19 +15,39 @@ static constexpr int BOUND_EXACT = 3;   // PV-node   (Knuth's Type 1) : alpha <
 class TranspositionTable;
 
 #include <cassert>
+#include <algorithm>
 #include "defines.h"
 
+//  Deux formats d'entrée sont disponibles :
+//      + par défaut  : clé de 32 bits, coup complet de 32 bits ; 16 octets, 4 entrées par cluster
+//      + USE_TT_KEY16 : clé de 16 bits, coup compressé sur 16 bits ; 10 octets, 6 entrées par cluster
+//  Le format compact met 50% d'entrées en plus dans la même mémoire,
+//  au prix de collisions plus fréquentes et de la reconstruction du coup
+//  à partir de la position (Board::unpack_move).
+//  Taux de succès des probes (bench, 1 thread) : à 16 Mo, identique
+//  (21.4/21.5 % en profondeur 8, 14.0/14.0 % en profondeur 13) ;
+//  avec une table saturée (1 Mo, profondeur 13) : 13.1 % -> 13.7 %.
+#if defined USE_TT_KEY16
+using TTKey  = U16;
+using TTMove = U16;
+static constexpr size_t CLUSTER_SIZE = 6;
+#else
+using TTKey  = U32;
+using TTMove = MOVE;
+static constexpr size_t CLUSTER_SIZE = 4;
+#endif
+
 struct HashEntry {
     static constexpr U32 AgeBits  = 5;
     static constexpr U32 AgeCycle = 1 << AgeBits;       // 32
     static constexpr U32 AgeMask  = AgeCycle - 1;       // 31
 
-    U32   key32;        // 32 bits
-    MOVE  move;         // 32 bits  (seuls 24 bits sont utilisés)
-    I16   score;        // 16 bits
-    I16   eval;         // 16 bits
-    U08   depth;        //  8 bits
-    U08   agePvBound;   //  8 bits  (5 bits age : 1 bit pv ; 2 bits bound)      : 0-31
+    TTKey   key;          // 16 ou 32 bits
+    TTMove  move;         // 16 bits (coup compressé) ou 32 bits (seuls 27 bits sont utilisés)
+    I16     score;        // 16 bits
+    I16     eval;         // 16 bits
+    U08     depth;        //  8 bits
+    U08     agePvBound;   //  8 bits  (5 bits age : 1 bit pv ; 2 bits bound)      : 0-31
 
     //==================================================
     //! \brief  Extrait l'âge stocké dans agePvBound
@@ -93,26 +113,27 @@ Total entrées       : 8388608
 
 /* key16 :
  *
- * 88 bits = 11 octets --> alignement sur 12 octets (12*8 = 96 = 3*32)
- * le compilateur ajoute 8 octets
+ * 80 bits = 10 octets ; tous les champs sont alignés sur 16 bits,
+ * le compilateur n'ajoute donc aucun padding
+ * 6 entrées = 60 octets, + 4 octets de padding pour le cluster
  *
-Nombre de clusters  : 2796202
-Taille d'un cluster : 48 octets
-Entrées par cluster : 4
-Taille d'une entrée : 12 octets
-Total entrées       : 11.184.808
-Taille totale       : 134217696  134217696 (128) Mo
+Nombre de clusters  : 2097152
+Taille d'un cluster : 64 octets
+Entrées par cluster : 6
+Taille d'une entrée : 10 octets
+Total entrées       : 12582912
  */
 
 };
 
-static constexpr size_t CLUSTER_SIZE = 4;
-
 struct alignas(64) HashCluster {
     std::array<HashEntry, CLUSTER_SIZE> entries{};
 };
 
 static_assert(sizeof(HashCluster) == 64);
+#if defined USE_TT_KEY16
+static_assert(sizeof(HashEntry) == 10);
+#endif
 
 
 //----------------------------------------------------------
@@ -123,9 +144,20 @@ class TranspositionTable
 private:
     static constexpr U64 ONE = 1ULL;
 
+    static constexpr size_t PAGE_SIZE  = 2 * 1024 * 1024;    // taille d'une "huge page"
+    static constexpr size_t MIN_SLICE  = 4 * 1024 * 1024;    // tranche minimale par thread (clear, load)
+
     size_t                      nbr_cluster{};
     U32                         tt_age{};
-    std::vector<HashCluster>    tt_entries = {};
+    HashCluster*                tt_entries = nullptr;
+    size_t                      alloc_size{};           // taille réellement allouée, en octets
+    bool                        huge_pages = false;     // "true" si les huge pages ont été demandées (madvise)
+    size_t                      nbr_threads = 1;        // nombre de threads utilisées par clear() et load()
+
+    void allocate(size_t size);
+    void deallocate();
+    bool huge_pages_size(size_t& bytes) const;
+    size_t slice_threads() const;
 
     //==================================================
     //! \brief  Calcule l'index du cluster correspondant à une clé de hachage
@@ -134,6 +166,8 @@ private:
     //--------------------------------------------------
     inline U64 index(U64 key) const noexcept {
         // ceci génère une unique multiplication, aussi bien sur x64 que sur arm64
+        // Le produit est fait sur 128 bits : l'index reste dans [0, nbr_cluster[
+        // et uniforme quel que soit nbr_cluster, y compris au-delà de 2^32 clusters.
         return static_cast<U64>((static_cast<U128>(key) * static_cast<U128>(nbr_cluster)) >> 64);
     }
 
@@ -143,17 +177,25 @@ public:
     //! Utilise la taille de hash par défaut (HASH_SIZE)
     //--------------------------------------------------
     TranspositionTable() : TranspositionTable(HASH_SIZE) {}
-    TranspositionTable(int MB);
+    TranspositionTable(U64 MB);
     ~TranspositionTable();
 
-    void init_size(int mbsize);
+    static U64 max_size();
+    void init_size(U64 mbsize);
+    //==================================================
+    //! \brief  Fixe le nombre de threads utilisées pour remettre la table à zéro
+    //! \param[in]  nbr  nombre de threads (celui du ThreadPool)
+    //--------------------------------------------------
+    void set_threads(size_t nbr) { nbr_threads = std::max<size_t>(1, nbr); }
     //==================================================
     //! \brief  Retourne le nombre de clusters de la table
     //--------------------------------------------------
-    int  get_hash_size(void) const { return nbr_cluster; }
+    U64  get_hash_size(void) const { return nbr_cluster; }
     std::string info();
 
     void clear(void);
+    bool save(const std::string& filename) const;
+    bool load(const std::string& filename);
     //==================================================
     //! \brief  Incrémente l'âge courant de la table de transposition (nouvelle recherche)
     //--------------------------------------------------
@@ -1,11 +1,13 @@
 #include <iostream>
 #include <sstream>
+#include <cstdlib>
 #include <fstream>
 #include <string>
 #include <algorithm>
 #include <iomanip>
 #include <unordered_set>
 #include <unordered_map>
+#include <vector>
 
 #include "defines.h"
 #include "Uci.h"
@@ -15,7 +17,10 @@
 #include "pyrrhic/tbprobe.h"
 #include "Move.h"
 #include "bench.h"
+#include "Numa.h"
 #include "Tunable.h"
+#include "Cpu.h"
+#include "Kernels.h"
 
 Board   uci_board;
 
@@ -90,12 +95,20 @@ void Uci::run()
             // Lorsque l'utilisateur va agir sur une de ces options,
             // Arena va envoyer la commande "setoption.." au programme.
 
-            std::cout << "option name Hash type spin default " << HASH_SIZE <<" min " << MIN_HASH_SIZE << " max " << MAX_HASH_SIZE << std::endl;
+            std::cout << "option name Hash type spin default " << HASH_SIZE <<" min " << MIN_HASH_SIZE << " max " << TranspositionTable::max_size() << std::endl;
             std::cout << "option name Clear Hash type button" << std::endl;
+            std::cout << "option name EvalCache type spin default " << EVAL_CACHE_SIZE << " min 0 max " << MAX_EVAL_CACHE_SIZE << std::endl;
             std::cout << "option name Threads type spin default 1 min 1 max " << std::max(1U, std::thread::hardware_concurrency()) << std::endl;
+            std::cout << "option name Ponder type check default false" << std::endl;
+            std::cout << "option name MultiPV type spin default 1 min 1 max " << MAX_MULTIPV << std::endl;
+            std::cout << "option name EvalFile type string default " << "<embedded>" << std::endl;
             std::cout << "option name SyzygyPath type string default " << "<empty>" << std::endl;
             std::cout << "option name SyzygyProbeLimit type spin default 6 min 0 max 7" << std::endl;
             std::cout << "option name MoveOverhead type spin default " << MOVE_OVERHEAD << " min 0 max 10000" << std::endl;
+            std::cout << "option name NumaBind type check default true" << std::endl;
+            std::cout << "option name NumaNetReplicas type check default true" << std::endl;
+            std::cout << "option name SharedNetwork type check default false" << std::endl;
+            std::cout << "option name SharedNetworkClean type button" << std::endl;
 
 #if defined USE_TUNING
             std::cout << Tunable::paramsToUci();
@@ -137,6 +150,13 @@ void Uci::run()
             stop();
         }
 
+        else if (token == "ponderhit")
+        {
+            // l'adversaire a joué le coup attendu : la recherche "go ponder"
+            // continue, avec les limites de temps reçues
+            threadPool.ponderhit();
+        }
+
         else if (token == "quit")
         {
             // quitte le programme au plus vite
@@ -155,24 +175,42 @@ void Uci::run()
             std::cout << "s <ref/big> [dmax]            : test suite_perft "                                    << std::endl;
             std::cout << "p <r/k/s/f> [dmax]            : test perft  <Ref/Kiwipete/Silver2/fen> "              << std::endl;
             std::cout << "d <r/k/s/f> [dmax]            : test divide <Ref/Kiwipete/Silver2/fen> "              << std::endl;
+            std::cout << "perft <r/k/s/f> [dmax] [threads] [hash] : perft multi-thread, table de hash en Mo (0 : sans)"  << std::endl;
+            std::cout << "perft bench [threads] [hash]  : Mnps génération / make-undo / hash sur une suite fixe"  << std::endl;
             std::cout << "test                          : test de recherche sur un ensemble de positions"       << std::endl;
             std::cout << "eval [fen]                    : test evaluation sur la position courante ou le fen donné"   << std::endl;
             std::cout << "syzygy [fen]                  : test syzygy sur la position courante ou le fen donné" << std::endl;
             std::cout << "run <fen> [dmax][tmax][nmax][thread]      : test de recherche <Silver2/Kiwipete/Quies/Fine70/WAC2/BUG/REF>"           << std::endl;
             std::cout << "mirror                        : test mirror"                                          << std::endl;
             std::cout << "see                           : test see"                                             << std::endl;
+            std::cout << "vnni                          : test couche de sortie int8 (VNNI) contre int16"       << std::endl;
+            std::cout << "legal [n]                     : test is_pseudo_legal/is_legal sur n positions"        << std::endl;
+            std::cout << "nnbench [l1] [l2]             : coût d'une évaluation pour chaque noyau NNUE"          << std::endl;
+            std::cout << "refresh                       : coût d'un rafraîchissement d'accumulateur (Finny)"    << std::endl;
+            std::cout << "kernels                       : compare et mesure les noyaux NNUE exécutables"         << std::endl;
+            std::cout << "sliders                       : vérifie et mesure les attaques fou/tour (magic, pext)"  << std::endl;
+            std::cout << "ponder                        : test go ponder / ponderhit / stop"                     << std::endl;
+            std::cout << "multipv [n] [depth]           : coût de n lignes MultiPV par rapport à une seule"      << std::endl;
+            std::cout << "nodes [n] [threads]           : test de la limite go nodes (1 thread, puis n threads)" << std::endl;
+            std::cout << "watchdog [movetime]           : latence échéance -> bestmove (MoveOverhead 1 ms), nps" << std::endl;
+            std::cout << "rootscores [nodes] [fen]      : score de chaque coup légal (go searchmoves), TT conservée" << std::endl;
+            std::cout << "nnload <fichier>              : charge un réseau décrit par son en-tête"              << std::endl;
+            std::cout << "nnsave <fichier>              : sauvegarde le réseau courant avec son en-tête"        << std::endl;
             std::cout << "fen [str]                     : positionne la chaine fen"                             << std::endl;
             std::cout << "dmax [p]                      : positionne la profondeur de recherche"                << std::endl;
             std::cout << "tmax [ms]                     : positionne le temps de recherche en millisecondes"    << std::endl;
             std::cout << "nmax [n]                      : positionne le nombre de nodes"                        << std::endl;
             std::cout << "display                       : affiche la position"                                  << std::endl;
-            std::cout << "systeme                       : informe sur les minimums systeme"                     << std::endl;
+            std::cout << "systeme                       : CPU détecté et noyaux choisis à l'exécution"          << std::endl;
+            std::cout << "ttsave <fichier>              : sauvegarde la table de transposition"                 << std::endl;
+            std::cout << "ttload <fichier>              : recharge une table de transposition sauvegardée"      << std::endl;
         }
 
         else if (token == "v")
         {
             std::cout << "Zangdar " << VERSION << " NNUE " << NET_NAME << std::endl;
             std::cout << transpositionTable.info();
+            std::cout << Numa::info();
             uci_board.syzygy_info();
         }
         else if (token == "s")
@@ -202,6 +240,25 @@ void Uci::run()
             test_perft<true>(str, fen, dmax);
         }
 
+        else if (token == "perft")
+        {
+            std::string str;
+            iss >> str;
+
+            size_t nbr_threads = 0;
+            size_t hash_mb     = 0;
+            if (str == "bench")
+            {
+                iss >> nbr_threads >> hash_mb;
+                test_perft_bench(nbr_threads, hash_mb);
+            }
+            else
+            {
+                iss >> dmax >> nbr_threads >> hash_mb;
+                test_perft_parallel(str, fen, dmax, nbr_threads, hash_mb);
+            }
+        }
+
         else if(token == "mirror")
         {
             test_mirror();
@@ -219,6 +276,90 @@ void Uci::run()
             test_see();
         }
 
+        else if(token == "vnni")
+        {
+            test_vnni();
+        }
+
+        else if(token == "legal")
+        {
+            U64 nbr = 1000000;
+            iss >> nbr;
+            test_legal(nbr);
+        }
+
+        else if(token == "nnbench")
+        {
+            U32 l1 = 16;
+            U32 l2 = 32;
+            iss >> l1 >> l2;
+            test_nnbench(l1, l2);
+        }
+
+        else if(token == "refresh")
+        {
+            test_refresh();
+        }
+
+        else if(token == "kernels")
+        {
+            test_kernels();
+        }
+
+        else if(token == "sliders")
+        {
+            test_sliders();
+        }
+
+        else if(token == "ponder")
+        {
+            test_ponder();
+        }
+
+        else if(token == "multipv")
+        {
+            int nbr   = 5;
+            int depth = 12;
+            iss >> nbr >> depth;
+            test_multipv(std::clamp(nbr, 1, MAX_MULTIPV), std::clamp(depth, 1, MAX_PLY - 1));
+        }
+
+        else if(token == "nodes")
+        {
+            U64 nodes       = 50000;
+            U32 nbr_threads = 4;
+            iss >> nodes >> nbr_threads;
+            test_nodes(std::max(nodes, U64{1}), std::clamp(nbr_threads, 1U, MAX_THREADS));
+        }
+
+        else if(token == "watchdog")
+        {
+            int movetime = 100;
+            iss >> movetime;
+            test_watchdog(std::max(movetime, 1));
+        }
+
+        else if(token == "rootscores")
+        {
+            U64 nodes = 100000;
+            iss >> nodes;
+            std::string rest;
+            std::getline(iss >> std::ws, rest);
+            test_root_scores(rest.empty() ? fen : rest, nodes);
+        }
+
+        else if (token == "nnload" || token == "nnsave")
+        {
+            std::string filename;
+            std::getline(iss >> std::ws, filename);
+            if (filename.empty())
+                std::cout << "info string " << token << " : nom de fichier manquant" << std::endl;
+            else if (token == "nnload")
+                threadPool.load_network(filename);
+            else
+                NNUE::save_file(filename);
+        }
+
         else if(token == "syzygy")
         {
             std::string rest;
@@ -273,6 +414,26 @@ void Uci::run()
             iss >> nmax;
         }
 
+        else if (token == "ttsave" || token == "ttload")
+        {
+            // La table ne doit pas être modifiée pendant la copie :
+            // on arrête une éventuelle recherche en cours.
+            std::string filename;
+            std::getline(iss >> std::ws, filename);
+            if (filename.empty())
+            {
+                std::cout << "info string " << token << " : nom de fichier manquant" << std::endl;
+            }
+            else
+            {
+                threadPool.stop();
+                if (token == "ttsave")
+                    transpositionTable.save(filename);
+                else
+                    transpositionTable.load(filename);
+            }
+        }
+
         else if (token == "json")
         {
             Tunable::paramsToJSON();
@@ -328,57 +489,47 @@ void Uci::run()
             printf("compilateur Clang \n");
 #endif
 
-            // Jeux d'instructions, du plus ancien au plus récent
-#if defined(__SSE__)
-            std::cout << "__SSE__        OK " << std::endl;
-#endif
-#if defined(__SSE2__)
-            std::cout << "__SSE2__       OK " << std::endl;
-#endif
-#if defined(__SSE3__)
-            std::cout << "__SSE3__       OK " << std::endl;
-#endif
-#if defined(__SSSE3__)
-            std::cout << "__SSSE3__      OK " << std::endl;
-#endif
-#if defined(__SSE4_1__)
-            std::cout << "__SSE4_1__     OK " << std::endl;
-#endif
-#if defined(__SSE4_2__)
-            std::cout << "__SSE4_2__     OK " << std::endl;
-#endif
-#if defined(__POPCNT__)
-            std::cout << "__POPCNT__     OK " << std::endl;
-#endif
-#if defined(__AVX__)
-            std::cout << "__AVX__        OK " << std::endl;
-#endif
-#if defined(__AVX2__)
-            std::cout << "__AVX2__       OK " << std::endl;
-#endif
-#if defined(__FMA__)
-            std::cout << "__FMA__        OK " << std::endl;
-#endif
-#if defined(__BMI2__)
-            std::cout << "__BMI2__       OK " << std::endl;
-#endif
-#if defined(__AVX512F__)
-            std::cout << "__AVX512F__    OK " << std::endl;
-#endif
-#if defined (__AVX512BW__)
-            std::cout << "__AVX512BW__   OK " << std::endl;
-#endif
-#if defined (__AVX512VNNI__)
-            std::cout << "__AVX512VNNI__ OK " << std::endl;
-#endif
-#if defined(__ARM_NEON)
-            std::cout << "__ARM_NEON     OK " << std::endl;
-#endif
-#if defined(USE_PEXT)
-            std::cout << "USE_PEXT       OK (attaques glisseurs par PEXT)" << std::endl;
+            // Jeux d'instructions : détectés à l'exécution (cpuid),
+            // pas les macros de compilation
+            const Cpu::Features& cpu = Cpu::features();
+            std::cout << "CPU            : " << (cpu.brand.empty() ? cpu.vendor : cpu.brand);
+            if (cpu.family != 0)
+                std::cout << " (" << cpu.vendor << ", famille 0x" << std::hex << cpu.family
+                          << ", modèle 0x" << cpu.model << std::dec << ")";
+            std::cout << std::endl;
+
+            std::cout << "instructions   :";
+            for (const auto& [name, present] : { std::pair{"sse2",       cpu.sse2},
+                                                 std::pair{"popcnt",     cpu.popcnt},
+                                                 std::pair{"avx2",       cpu.avx2},
+                                                 std::pair{"bmi2",       cpu.bmi2},
+                                                 std::pair{"avx512",     cpu.avx512},
+                                                 std::pair{"avx512vnni", cpu.avx512vnni},
+                                                 std::pair{"avxvnni",    cpu.avxvnni},
+                                                 std::pair{"neon",       cpu.neon} })
+                if (present)
+                    std::cout << " " << name;
+            std::cout << std::endl;
+
+            std::cout << "exécutable     : " << (Cpu::is_dispatch() ? "multi-architectures, noyaux :" : "une architecture, noyaux :");
+            for (const NnueKernels* kern : Cpu::available_kernels())
+                std::cout << " " << kern->name;
+            std::cout << std::endl;
+
+            const NnueKernels& kern = Cpu::kernels();
+            std::cout << "noyaux NNUE    : " << kern.name << std::endl;
+#if defined USE_VNNI
+            const bool output_i8 = NNUE::quantized_output(NNUE::main_network(), kern) != nullptr;
 #else
-            std::cout << "USE_PEXT       absent (magic bitboards)" << std::endl;
+            const bool output_i8 = false;
 #endif
+            std::cout << "couche sortie  : " << (output_i8 ? "int8 (dpbusd)" : "int16") << std::endl;
+            std::cout << "L1 creux       : " << (kern.add_blocks ? "SIMD" : "scalaire") << std::endl;
+            std::cout << "attaques       : " << (Cpu::use_pext() ? "PEXT" : "magic bitboards");
+            if (cpu.slow_pext)
+                std::cout << (Cpu::use_pext() ? " (pext microcodé sur ce CPU : préférer ARCH=avx2 ou multi)"
+                                              : " (pext microcodé sur ce CPU)");
+            std::cout << std::endl;
 
         }
     } while (token != "quit");
@@ -414,6 +565,7 @@ void Uci::quit()
 void Uci::parse_go(std::istringstream& iss)
 {
     bool infinite   = false;
+    bool ponder     = false;
     int wtime       = 0;
     int btime       = 0;
     int winc        = 0;
@@ -422,6 +574,8 @@ void Uci::parse_go(std::istringstream& iss)
     int depth       = 0;
     U64 nodes       = 0;
     int movetime    = 0;
+    bool searchmoves = false;                   // les tokens suivants sont des coups
+    std::vector<std::string> searchmoves_names; // coups de "searchmoves"
 
     // Arrête toute recherche en cours
     Uci::stop();
@@ -439,6 +593,11 @@ void Uci::parse_go(std::istringstream& iss)
             // recherche jusqu'à la commande "stop". Ne pas sortir de la recherche sans y être invité dans ce mode !
             infinite = true;
         }
+        else if (token == "ponder")
+        {
+            // recherche pendant le temps de l'adversaire, jusqu'à "ponderhit" ou "stop"
+            ponder = true;
+        }
         else if (token == "wtime")
         {
             // il reste x msec sur la pendule des Blancs
@@ -482,10 +641,44 @@ void Uci::parse_go(std::istringstream& iss)
             iss >> searchTime;
             movetime = searchTime;
         }
+        else if (token == "searchmoves")
+        {
+            // restreint la recherche à ces coups racine
+            searchmoves = true;
+            continue;
+        }
+        else if (searchmoves)
+        {
+            searchmoves_names.push_back(token);
+            continue;
+        }
+        searchmoves = false;
+    }
+
+    // Les coups de "searchmoves" sont pris parmi les coups légaux ;
+    // un coup inconnu est ignoré, une liste vide autorise tous les coups.
+    MoveList search_moves;
+    if (!searchmoves_names.empty())
+    {
+        MoveList ml;
+        uci_board.legal_moves<MoveGenType::ALL>(ml);
+        for (const auto& name : searchmoves_names)
+        {
+            for (size_t k = 0; k < ml.count; k++)
+            {
+                if (Move::name(ml.mlmoves[k].move) == name)
+                {
+                    search_moves.mlmoves[search_moves.count++].move = ml.mlmoves[k].move;
+                    break;
+                }
+            }
+        }
     }
 
     // Initialise le gestionnaire de temps
     Timer uci_timer(infinite, wtime, btime, winc, binc, movestogo, depth, nodes, movetime, moveOverhead);
+    if (ponder)
+        uci_timer.set_ponder(&threadPool.pondering);
     uci_timer.start();
     uci_timer.setup(uci_board.side_to_move);
 
@@ -501,7 +694,7 @@ void Uci::parse_go(std::istringstream& iss)
 #endif
 
     // démarre la recherche
-    threadPool.start_thinking(uci_board, uci_timer);
+    threadPool.start_thinking(uci_board, uci_timer, search_moves);
 }
 
 //=========================================================
@@ -554,13 +747,15 @@ setoption name <id> [value <x>]
         if (option_name == "Hash")
         {
             iss >> value;      // "value"
-            int mb;
-            iss >> mb;
-            mb = std::min(mb, MAX_HASH_SIZE);
-            mb = std::max(mb, MIN_HASH_SIZE);
+            // Lu en signé : "-1" dans un U64 donnerait 2^64-1 (toute la mémoire)
+            I64 value_mb = static_cast<I64>(HASH_SIZE);
+            iss >> value_mb;
+            const U64 mb = static_cast<U64>(std::clamp(value_mb,
+                                                       static_cast<I64>(MIN_HASH_SIZE),
+                                                       static_cast<I64>(TranspositionTable::max_size())));
 
 #if defined DEBUG_LOG
-            sprintf(message, "Uci::parse_options : Set Hash to %d MB", mb);
+            sprintf(message, "Uci::parse_options : Set Hash to %llu MB", static_cast<unsigned long long>(mb));
             printlog(message);
 #endif
             // Il faut arrêter la recherche avant de réallouer.
@@ -583,6 +778,32 @@ setoption name <id> [value <x>]
             }
         }
 
+        else if (option_name == "EvalCache")
+        {
+            // Cache d'évaluation de chaque thread, en Ko (0 : désactivé)
+            iss >> value;      // "value"
+            U64 kb = EVAL_CACHE_SIZE;
+            iss >> kb;
+            threadPool.set_eval_cache(std::min(kb, MAX_EVAL_CACHE_SIZE));
+        }
+
+        else if (option_name == "Ponder")
+        {
+            // La GUI indique si elle enverra "go ponder"
+            iss >> value;      // "value"
+            iss >> value;
+            threadPool.set_usePonder(value == "true");
+        }
+
+        else if (option_name == "MultiPV")
+        {
+            // Nombre de lignes affichées (analyse)
+            iss >> value;      // "value"
+            int nbr = 1;
+            iss >> nbr;
+            threadPool.set_multiPV(nbr);
+        }
+
         else if (option_name == "Threads")
         {
             iss >> value;      // "value"
@@ -592,6 +813,48 @@ setoption name <id> [value <x>]
             threadPool.set_threads(nbr);
         }
 
+        else if (option_name == "NumaBind")
+        {
+            // N'a d'effet que sur une machine ayant plusieurs nœuds NUMA,
+            // avec plus de threads que de coeurs sur un nœud
+            iss >> value;      // "value"
+            iss >> value;
+            threadPool.set_numa(value == "true");
+        }
+
+        else if (option_name == "NumaNetReplicas")
+        {
+            // Une copie du réseau par nœud NUMA : n'a d'effet qu'avec NumaBind
+            iss >> value;      // "value"
+            iss >> value;
+            threadPool.set_net_replicas(value == "true");
+        }
+
+        else if (option_name == "EvalFile")
+        {
+            // setoption name EvalFile value /chemin/vers/reseau.bin
+            // "<embedded>" (ou rien) : réseau embarqué dans l'exécutable
+            iss >> value;      // "value"
+
+            std::string filename;
+            std::getline(iss >> std::ws, filename);
+            threadPool.set_eval_file(filename);
+        }
+
+        else if (option_name == "SharedNetwork")
+        {
+            // Poids du réseau en mémoire partagée, une seule fois par machine
+            iss >> value;      // "value"
+            iss >> value;
+            threadPool.set_shared_network(value == "true");
+        }
+
+        else if (option_name == "SharedNetworkClean")
+        {
+            // Supprime les segments /zangdar-net-* des réseaux essayés auparavant
+            NNUE::clean_shared();
+        }
+
         else if (option_name == "SyzygyPath")
         {
             // Pour mettre plusieurs chemins
@@ -1025,6 +1288,11 @@ void Uci::bench(int argCount, char* argValue[])
     double  times[256];
     U64     nodes[256];
     MOVE    moves[256];
+    I64     go_lat[256];    // latence go -> première info, en µs
+    I64     stop_lat[256];  // latence stop -> bestmove, en µs
+    std::vector<U64> numa_nodes;    // nodes cumulés par nœud NUMA
+    LazyStats lazy_stats;           // longueur des chaînes de Lazy Updates
+    EvalCacheStats eval_stats;      // caches d'évaluation
 
     int     total       = 0;
     U64     total_nodes = 0;
@@ -1033,7 +1301,8 @@ void Uci::bench(int argCount, char* argValue[])
     int depth       = argCount > 2 ? atoi(argValue[2]) : 20;
     depth           = std::min(depth, MAX_PLY-1);
     int nbr_threads = argCount > 3 ? atoi(argValue[3]) : 1;
-    int hash_size   = argCount > 4 ? atoi(argValue[4]) : HASH_SIZE;
+    U64 hash_size   = argCount > 4 ? std::strtoull(argValue[4], nullptr, 10) : HASH_SIZE;
+    hash_size       = std::clamp(hash_size, MIN_HASH_SIZE, TranspositionTable::max_size());
 
     if (nbr_threads > 1)
         threadPool.set_threads(nbr_threads);
@@ -1070,10 +1339,26 @@ void Uci::bench(int argCount, char* argValue[])
         const auto ms  = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
 
         int bt = threadPool.get_best_thread();
-        scores[total] = threadPool.search[bt].pv_scores[threadPool.search[bt].best_depth];
-        moves[total]  = threadPool.search[bt].pv_moves[threadPool.search[bt].best_depth];
+        scores[total] = threadPool.search[bt]->pv_scores[threadPool.search[bt]->best_depth];
+        moves[total]  = threadPool.search[bt]->pv_moves[threadPool.search[bt]->best_depth];
         nodes[total]  = threadPool.get_all_nodes();
         times[total]  = ms;
+        go_lat[total]   = threadPool.get_go_latency();
+        stop_lat[total] = threadPool.get_stop_latency();
+
+        const auto per_node = threadPool.get_nodes_per_numa();
+        numa_nodes.resize(per_node.size(), 0);
+        for (size_t n = 0; n < per_node.size(); n++)
+            numa_nodes[n] += per_node[n];
+
+        const LazyStats stats = threadPool.get_lazy_stats();
+        lazy_stats.refresh += stats.refresh;
+        for (int n = 0; n < 3; n++)
+            lazy_stats.chain[n] += stats.chain[n];
+
+        const EvalCacheStats cache = threadPool.get_eval_cache_stats();
+        eval_stats.probes += cache.probes;
+        eval_stats.hits   += cache.hits;
 
         total++;
     } // boucle position
@@ -1091,12 +1376,40 @@ void Uci::bench(int argCount, char* argValue[])
 
     printf("===============================================================================\n");
 
+    // Latences des threads persistantes : moyenne et maximum sur les positions
+    I64 sum_go = 0, max_go = 0, sum_stop = 0, max_stop = 0;
+    for (int i=0; i<total; i++)
+    {
+        sum_go   += go_lat[i];
+        sum_stop += stop_lat[i];
+        max_go    = std::max(max_go,   go_lat[i]);
+        max_stop  = std::max(max_stop, stop_lat[i]);
+    }
+
     std::cout << "===============================================" << std::endl;
     std::cout << "total nodes = " << total_nodes << std::endl;
     std::cout << "time        = " << std::fixed << std::setprecision(3) << static_cast<double>(total_time)/1000.0 << " s" << std::endl;
     std::cout << "nps         = " << static_cast<U64>(1000.0 * total_nodes / (total_time + 1)) << std::endl;
+    if (numa_nodes.size() > 1)
+    {
+        for (size_t n = 0; n < numa_nodes.size(); n++)
+            std::cout << "nps noeud " << n << " = " << static_cast<U64>(1000.0 * numa_nodes[n] / (total_time + 1)) << std::endl;
+    }
     std::cout << "depth       = " << depth << std::endl;
     std::cout << "nbr threads = " << threadPool.get_nbrThreads() << std::endl;
     std::cout << "hash size   = " << transpositionTable.get_hash_size() << std::endl;
+    std::cout << "go -> info  = " << sum_go   / std::max(1, total) << " µs (moy) ; " << max_go   << " µs (max)" << std::endl;
+    std::cout << "stop -> bm  = " << sum_stop / std::max(1, total) << " µs (moy) ; " << max_stop << " µs (max)" << std::endl;
+
+    // Lazy Updates : répartition des longueurs de chaîne (par perspective)
+    const U64 lazy_total = std::max<U64>(1, lazy_stats.refresh + lazy_stats.chain[0] + lazy_stats.chain[1] + lazy_stats.chain[2]);
+    std::cout << "lazy update = " << std::setprecision(1)
+              << "1 : "  << 100.0 * lazy_stats.chain[0] / lazy_total << " % ; "
+              << "2 : "  << 100.0 * lazy_stats.chain[1] / lazy_total << " % ; "
+              << "3+ : " << 100.0 * lazy_stats.chain[2] / lazy_total << " % ; "
+              << "refresh : " << 100.0 * lazy_stats.refresh / lazy_total << " %" << std::endl;
+    std::cout << "eval cache  = " << 100.0 * eval_stats.hits / std::max<U64>(1, eval_stats.probes) << " % ("
+              << eval_stats.hits << " / " << eval_stats.probes << ") ; "
+              << threadPool.search[0]->eval_cache.get_size() << " Ko par thread" << std::endl;
     std::cout << "===============================================" << std::endl;
 }
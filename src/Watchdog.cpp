@@ -0,0 +1,133 @@
+#include "Watchdog.h"
+
+//=================================================
+//! \brief  Constructeur : lance la thread persistante
+//!
+//! \param[in]  _on_timeout     appelée (hors verrou) quand l'échéance est atteinte
+//-------------------------------------------------
+Watchdog::Watchdog(std::function<void()> _on_timeout) :
+    on_timeout(std::move(_on_timeout))
+{
+    thread = std::thread(&Watchdog::idle_loop, this);
+}
+
+//=================================================
+//! \brief  Destructeur : termine la thread
+//-------------------------------------------------
+Watchdog::~Watchdog()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        exit = true;
+    }
+    cv.notify_all();
+    thread.join();
+}
+
+//=================================================
+//! \brief  Attend la fin d'un éventuel on_timeout en cours
+//! À appeler après cancel, avant de remettre à zéro le flag
+//! d'arrêt de la nouvelle recherche : un on_timeout tardif
+//! de la recherche précédente l'arrêterait sinon.
+//-------------------------------------------------
+void Watchdog::wait_idle()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&]{ return !firing; });
+}
+
+//=================================================
+//! \brief  Début de la surveillance d'une recherche
+//! (après wait_idle)
+//!
+//! \param[in]  start_time  début de la recherche (Timer::start)
+//! \param[in]  _limit      temps maximum en millisecondes ; < 0 : pas de limite
+//! \param[in]  pondering   "go ponder" : le décompte commencera au "ponderhit"
+//-------------------------------------------------
+void Watchdog::start(TimePoint::time_point start_time, I64 _limit, bool pondering)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        generation++;
+        active   = (_limit >= 0);
+        armed    = false;
+        waiting  = pondering;
+        limit    = _limit;
+        lateness = -1;
+        deadline = start_time + std::chrono::milliseconds(limit);
+    }
+    cv.notify_all();
+}
+
+//=================================================
+//! \brief  La thread 0 a atteint MIN_DEPTH : l'échéance s'applique
+//-------------------------------------------------
+void Watchdog::arm()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        armed = true;
+    }
+    cv.notify_all();
+}
+
+//=================================================
+//! \brief  "ponderhit" : le décompte commence maintenant
+//-------------------------------------------------
+void Watchdog::ponderhit()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!waiting)
+            return;
+        waiting  = false;
+        deadline = TimePoint::now() + std::chrono::milliseconds(limit);
+    }
+    cv.notify_all();
+}
+
+//=================================================
+//! \brief  Fin de la recherche (arrêt par la thread 0, ou "stop")
+//-------------------------------------------------
+void Watchdog::cancel()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        active = false;
+    }
+    cv.notify_all();
+}
+
+//=================================================
+//! \brief  Boucle de la thread persistante
+//! Dort jusqu'à ce qu'une recherche soit à surveiller,
+//! puis jusqu'à son échéance ; un changement (cancel,
+//! nouvelle recherche) interrompt l'attente.
+//-------------------------------------------------
+void Watchdog::idle_loop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true)
+    {
+        cv.wait(lock, [&]{ return exit || (active && armed && !waiting); });
+        if (exit)
+            return;
+
+        const U64 gen = generation;
+        if (cv.wait_until(lock, deadline, [&]{ return exit || !active || generation != gen; }))
+            continue;
+
+        // Échéance atteinte
+        lateness = std::chrono::duration_cast<std::chrono::microseconds>(TimePoint::now() - deadline).count();
+        active   = false;
+        firing   = true;
+        lock.unlock();
+
+        on_timeout();
+
+        lock.lock();
+        firing = false;
+        cv.notify_all();
+    }
+}
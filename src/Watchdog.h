@@ -0,0 +1,62 @@
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "defines.h"
+#include "types.h"
+
+//  Surveillance du temps de recherche (ThreadPool)
+//
+//  Une thread persistante dort jusqu'à l'échéance "hard" de la recherche
+//  (Timer::get_hard_limit), puis appelle "on_timeout", qui lève le flag
+//  d'arrêt. La recherche n'a plus à lire l'horloge : le contrôle du temps,
+//  dans alpha_beta et quiescence, se réduit à la lecture de ce flag.
+//
+//  L'échéance n'est appliquée qu'une fois la thread 0 arrivée à la
+//  profondeur MIN_DEPTH (arm), pour qu'un coup soit toujours disponible.
+//  En "ponder", le décompte ne commence qu'au "ponderhit".
+
+class Watchdog
+{
+public:
+    static constexpr int MIN_DEPTH = 4;     // profondeur avant laquelle on ne coupe pas
+
+    explicit Watchdog(std::function<void()> on_timeout);
+    ~Watchdog();
+
+    Watchdog(const Watchdog&)            = delete;
+    Watchdog& operator=(const Watchdog&) = delete;
+
+    void wait_idle();
+    void start(TimePoint::time_point start_time, I64 limit, bool pondering);
+    void arm();
+    void ponderhit();
+    void cancel();
+
+    //! \brief  Retard du réveil sur l'échéance, lors du dernier arrêt, en microsecondes (-1 : pas d'arrêt)
+    I64  get_lateness() const { std::lock_guard<std::mutex> lock(mutex); return lateness; }
+
+private:
+    std::function<void()>   on_timeout;
+    std::thread             thread;
+    mutable std::mutex      mutex;
+    std::condition_variable cv;
+
+    // tout est protégé par mutex
+    bool                    exit      = false;
+    bool                    active    = false;  // une recherche limitée en temps est en cours
+    bool                    armed     = false;  // la thread 0 a atteint MIN_DEPTH
+    bool                    waiting   = false;  // "go ponder" : pas encore de "ponderhit"
+    bool                    firing    = false;  // on_timeout en cours d'exécution
+    U64                     generation = 0;     // numéro de la recherche surveillée
+    I64                     limit     = 0;      // temps maximum, en millisecondes
+    I64                     lateness  = -1;
+    TimePoint::time_point   deadline;
+
+    void idle_loop();
+};
+
+#endif // WATCHDOG_H
@@ -39,17 +39,21 @@ using Array2D = std::array<std::array<T, y>, x>;
 
 static constexpr int MAX_PLY    =  128;     // profondeur max de recherche (en demi-coups)
 static constexpr int MAX_HISTO  = 1024;     // longueur max de l'historique (partie + recherche) (en demi-coups)
-static constexpr int MAX_MOVES  =  400;     // taille max d'une liste de coups (largement au-dessus du max théorique)
+static constexpr int MAX_MOVES  =  218;     // taille max d'une liste de coups (max théorique des coups légaux)
 static constexpr int MAX_TIME   = 60*60*1000;   // 1 heure en ms
 
-static constexpr int HASH_SIZE      = 128;      // en Mo
-static constexpr int MIN_HASH_SIZE  = 1;
-static constexpr int MAX_HASH_SIZE  = 1024;
+static constexpr U64 HASH_SIZE      = 128;      // en Mo
+static constexpr U64 MIN_HASH_SIZE  = 1;
+static constexpr U64 MAX_HASH_SIZE  = 33554432; // 32 To : borne théorique, limitée en pratique par la mémoire physique
 
 static constexpr int PAWN_HASH_SIZE = 16384;
 static constexpr int CORR_HASH_SIZE = 16384;        // puissance de 2 : accès par masque
 
+static constexpr U64 EVAL_CACHE_SIZE     = 256;     // cache d'évaluation, par thread, en Ko (0 : désactivé)
+static constexpr U64 MAX_EVAL_CACHE_SIZE = 65536;
+
 static constexpr U32 MAX_THREADS    = 256;  // borne de sécurité uniquement
+static constexpr int MAX_MULTIPV    = 64;   // nombre max de lignes (option UCI MultiPV)
 
 static constexpr int VALUE_DRAW     = 0;
 static constexpr int MATE           = 31000;
@@ -122,9 +126,22 @@ void binary_print(T code, const std::string& message)
 
 template <bool divide> extern void test_perft(const std::string& abc, const std::string& m_fen, int dmax);
 void test_suite(const std::string& abc, int dmax);
+void test_perft_parallel(const std::string& abc, const std::string& m_fen, int dmax, size_t nbr_threads, size_t hash_mb);
+void test_perft_bench(size_t nbr_threads, size_t hash_mb);
 void test_eval(const std::string& abc);
 void test_mirror();
 void test_see();
+void test_vnni();
+void test_legal(U64 nbr_positions);
+void test_nnbench(U32 l1, U32 l2);
+void test_refresh();
+void test_kernels();
+void test_sliders();
+void test_ponder();
+void test_multipv(int nbr_lines, int depth);
+void test_nodes(U64 nodes, U32 nbr_threads);
+void test_watchdog(int movetime);
+void test_root_scores(const std::string& fen, U64 nodes);
 void test_syzygy(const std::string& fen);
 
 //=========================================================
@@ -0,0 +1,456 @@
+#include <array>
+#include <bit>
+#include <cstring>
+#include "Kernels.h"
+#include "NNUE.h"
+#include "simd.h"
+
+/*  Noyaux de calcul NNUE, pour le jeu d'instructions de cette compilation.
+ *
+ *  La table est nommée "kernels_<KERNEL_ISA>" : KERNEL_ISA est donné par le
+ *  Makefile (ARCH=multi : une compilation par jeu d'instructions), sinon
+ *  "native". Tout le reste est privé à ce fichier : aucune fonction d'un
+ *  autre fichier n'est appelée, pour qu'aucune instruction d'un jeu plus
+ *  récent ne puisse s'échapper d'ici.
+ */
+
+#if !defined KERNEL_ISA
+  #define KERNEL_ISA native
+#endif
+
+#define KERNEL_TABLE_NAME(isa)  kernels_ ## isa
+#define KERNEL_TABLE(isa)       KERNEL_TABLE_NAME(isa)
+
+//  Couche de sortie en int8 (vpdpbusd) : mêmes conditions que USE_VNNI (NNUE.h)
+#if defined USE_SIMD && defined(__AVX512F__) && defined(__AVX512BW__) && defined(__AVX512VNNI__)
+  #define KERNEL_VNNI
+#elif defined USE_SIMD && !defined(__AVX512BW__) && defined(__AVX2__) && defined(__AVXVNNI__)
+  #define KERNEL_VNNI
+#endif
+
+//  L1 en SIMD : AVX2 et AVX-512 (SSE2 n'a pas vpmaddubsw, NEON pas de movemask)
+#if defined USE_SIMD && defined(__AVX2__)
+  #define KERNEL_SPARSE
+#endif
+
+#if !defined USE_SIMD
+  #define KERNEL_NAME   "generic"
+#elif defined(__AVX512F__) && defined(__AVX512BW__) && defined KERNEL_VNNI
+  #define KERNEL_NAME   "avx512-vnni"
+#elif defined(__AVX512F__) && defined(__AVX512BW__)
+  #define KERNEL_NAME   "avx512"
+#elif defined(__AVX2__) && defined KERNEL_VNNI
+  #define KERNEL_NAME   "avx2-vnni"
+#elif defined(__AVX2__)
+  #define KERNEL_NAME   "avx2"
+#elif defined(__ARM_NEON)
+  #define KERNEL_NAME   "neon"
+#else
+  #define KERNEL_NAME   "sse2"
+#endif
+
+namespace {
+
+#if defined USE_SIMD
+
+constexpr size_t kChunkSize = sizeof(simd::Vepi16) / sizeof(I16);
+
+//=================================================================================
+//! \brief  dst = src + add - sub
+//---------------------------------------------------------------------------------
+void sub_add(const I16* src, I16* dst, const I16* add, const I16* sub)
+{
+    for (size_t i = 0; i < HIDDEN_LAYER_SIZE; i += kChunkSize)
+    {
+        auto cur = simd::LoadEpi16(&src[i]);
+        cur      = simd::SubEpi16(cur, simd::LoadEpi16(&sub[i]));
+        cur      = simd::AddEpi16(cur, simd::LoadEpi16(&add[i]));
+        simd::StoreEpi16(&dst[i], cur);
+    }
+}
+
+//=================================================================================
+//! \brief  dst = src + add - sub_1 - sub_2
+//---------------------------------------------------------------------------------
+void sub_sub_add(const I16* src, I16* dst, const I16* add, const I16* sub_1, const I16* sub_2)
+{
+    for (size_t i = 0; i < HIDDEN_LAYER_SIZE; i += kChunkSize)
+    {
+        auto cur = simd::LoadEpi16(&src[i]);
+        cur      = simd::AddEpi16(cur, simd::LoadEpi16(&add[i]));
+        cur      = simd::SubEpi16(cur, simd::LoadEpi16(&sub_1[i]));
+        cur      = simd::SubEpi16(cur, simd::LoadEpi16(&sub_2[i]));
+        simd::StoreEpi16(&dst[i], cur);
+    }
+}
+
+//=================================================================================
+//! \brief  dst = src + add_1 + add_2 - sub_1 - sub_2
+//---------------------------------------------------------------------------------
+void sub_sub_add_add(const I16* src, I16* dst,
+                     const I16* add_1, const I16* add_2,
+                     const I16* sub_1, const I16* sub_2)
+{
+    for (size_t i = 0; i < HIDDEN_LAYER_SIZE; i += kChunkSize)
+    {
+        auto cur = simd::LoadEpi16(&src[i]);
+        cur      = simd::AddEpi16(cur, simd::LoadEpi16(&add_1[i]));
+        cur      = simd::AddEpi16(cur, simd::LoadEpi16(&add_2[i]));
+        cur      = simd::SubEpi16(cur, simd::LoadEpi16(&sub_1[i]));
+        cur      = simd::SubEpi16(cur, simd::LoadEpi16(&sub_2[i]));
+        simd::StoreEpi16(&dst[i], cur);
+    }
+}
+
+//===================================================================
+//! \brief  Ajoute et supprime une liste de features, par tuiles de registres
+//!
+//! Une tuile de l'accumulateur est gardée dans les registres SIMD
+//! pendant que toutes les lignes de poids lui sont ajoutées ou retirées :
+//! l'accumulateur n'est lu et écrit qu'une seule fois.
+//--------------------------------------------------------------------
+void apply_features(const I16* weights, const I16* src, I16* dst, I16* copy,
+                    const U32* adds, size_t nbr_adds,
+                    const U32* subs, size_t nbr_subs)
+{
+    constexpr size_t tile_size = (sizeof(simd::Vepi16) == 64) ? 16 : 8;     // registres par tuile
+    static_assert(HIDDEN_LAYER_SIZE % (tile_size * kChunkSize) == 0);
+
+    for (size_t t = 0; t < HIDDEN_LAYER_SIZE; t += tile_size * kChunkSize)
+    {
+        simd::Vepi16 regs[tile_size];
+
+        for (size_t r = 0; r < tile_size; r++)
+            regs[r] = simd::LoadEpi16(&src[t + r * kChunkSize]);
+
+        for (size_t n = 0; n < nbr_adds; n++)
+        {
+            const I16* row = &weights[adds[n] * HIDDEN_LAYER_SIZE + t];
+            for (size_t r = 0; r < tile_size; r++)
+                regs[r] = simd::AddEpi16(regs[r], simd::LoadEpi16(&row[r * kChunkSize]));
+        }
+
+        for (size_t n = 0; n < nbr_subs; n++)
+        {
+            const I16* row = &weights[subs[n] * HIDDEN_LAYER_SIZE + t];
+            for (size_t r = 0; r < tile_size; r++)
+                regs[r] = simd::SubEpi16(regs[r], simd::LoadEpi16(&row[r * kChunkSize]));
+        }
+
+        for (size_t r = 0; r < tile_size; r++)
+            simd::StoreEpi16(&dst[t + r * kChunkSize], regs[r]);
+        if (copy != nullptr)
+        {
+            for (size_t r = 0; r < tile_size; r++)
+                simd::StoreEpi16(&copy[t + r * kChunkSize], regs[r]);
+        }
+    }
+}
+
+//=========================================
+//! \brief  Σ clipped² × weight sur les 2 perspectives
+//!
+//! Ref : https://cosmo.tardis.ac/files/2024-06-01-nnue.html
+//! On va utiliser l'algorithme "Lizard"
+//-----------------------------------------
+I32 activation(const I16* us, const I16* them, const I16* weights)
+{
+    auto sum = simd::ZeroEpi32();
+
+    auto accumulate = [&](const I16* acc, const I16* w)
+    {
+        for (size_t i = 0; i < HIDDEN_LAYER_SIZE; i += kChunkSize)
+        {
+            const auto input   = simd::LoadEpi16(&acc[i]);
+            const auto weight  = simd::LoadEpi16(&w[i]);
+
+            // Écrêtage : clamp(acc, 0, QA) → valeur entre 0 et 255
+            const auto clipped = simd::Clip(input, QA);
+
+            // 1ère multiplication : clipped × weight → I16
+            // Pas d'overflow : 255 × 127 = 32385 < 32767 (max I16)
+            const auto product = simd::MultiplyEpi16(clipped, weight);
+
+            // 2ème multiplication avec élargissement vers I32 (madd) :
+            // result[i] = product[2i] × clipped[2i] + product[2i+1] × clipped[2i+1]
+            //           = clipped² × weight  (SCReLU = activation au carré)
+            const auto result  = simd::MultiplyAddEpi16(product, clipped);
+
+            // Accumulation en I32
+            sum = simd::AddEpi32(sum, result);
+        }
+    };
+
+    accumulate(us,   weights);
+    accumulate(them, weights + HIDDEN_LAYER_SIZE);
+
+    // Réduction horizontale : somme tous les I32 du vecteur en un seul scalaire
+    return simd::ReduceAddEpi32(sum);
+}
+
+#else
+
+//=================================================================================
+//! \brief  dst = src + add - sub  (scalaire)
+//---------------------------------------------------------------------------------
+void sub_add(const I16* src, I16* dst, const I16* add, const I16* sub)
+{
+    for (size_t i = 0; i < HIDDEN_LAYER_SIZE; ++i)
+        dst[i] = src[i] + add[i] - sub[i];
+}
+
+//=================================================================================
+//! \brief  dst = src + add - sub_1 - sub_2  (scalaire)
+//---------------------------------------------------------------------------------
+void sub_sub_add(const I16* src, I16* dst, const I16* add, const I16* sub_1, const I16* sub_2)
+{
+    for (size_t i = 0; i < HIDDEN_LAYER_SIZE; ++i)
+        dst[i] = src[i] + add[i] - sub_1[i] - sub_2[i];
+}
+
+//=================================================================================
+//! \brief  dst = src + add_1 + add_2 - sub_1 - sub_2  (scalaire)
+//---------------------------------------------------------------------------------
+void sub_sub_add_add(const I16* src, I16* dst,
+                     const I16* add_1, const I16* add_2,
+                     const I16* sub_1, const I16* sub_2)
+{
+    for (size_t i = 0; i < HIDDEN_LAYER_SIZE; ++i)
+        dst[i] = src[i] + add_1[i] + add_2[i] - sub_1[i] - sub_2[i];
+}
+
+//===================================================================
+//! \brief  Ajoute et supprime une liste de features  (scalaire)
+//--------------------------------------------------------------------
+void apply_features(const I16* weights, const I16* src, I16* dst, I16* copy,
+                    const U32* adds, size_t nbr_adds,
+                    const U32* subs, size_t nbr_subs)
+{
+    for (size_t i = 0; i < HIDDEN_LAYER_SIZE; ++i)
+    {
+        I32 value = src[i];
+        for (size_t n = 0; n < nbr_adds; n++)
+            value += weights[adds[n] * HIDDEN_LAYER_SIZE + i];
+        for (size_t n = 0; n < nbr_subs; n++)
+            value -= weights[subs[n] * HIDDEN_LAYER_SIZE + i];
+        dst[i] = static_cast<I16>(value);
+        if (copy != nullptr)
+            copy[i] = static_cast<I16>(value);
+    }
+}
+
+//! \brief  SCReLU scalaire
+inline I32 screlu(I16 x)
+{
+    const I32 clamped = x < 0 ? 0 : (x > QA ? QA : x);
+    return clamped * clamped;
+}
+
+//=========================================
+//! \brief  Σ clipped² × weight sur les 2 perspectives  (scalaire)
+//!         Même algorithme SCReLU Lizard que la version SIMD
+//-----------------------------------------
+I32 activation(const I16* us, const I16* them, const I16* weights)
+{
+    I32 sum = 0;
+
+    for (size_t i = 0; i < HIDDEN_LAYER_SIZE; ++i)
+    {
+        sum += screlu(us[i])   * weights[i];
+        sum += screlu(them[i]) * weights[HIDDEN_LAYER_SIZE + i];
+    }
+
+    return sum;
+}
+
+#endif
+
+#if defined KERNEL_VNNI
+
+//=========================================
+//! \brief  Σ clipped² × weight avec des poids int8 (VNNI)
+//!
+//! Même résultat, au bit près, que activation() :
+//!     clipped² ≤ 255² tient sur 16 bits non signés ; on le coupe en
+//!     octet haut h et octet bas l : clipped² = 256×h + l.
+//!     Chaque octet est multiplié par le poids int8 avec vpdpbusd (u8 × i8),
+//!     4 produits par I32, sans saturation.
+//!     Σ clipped²×w = 256 × Σ h×w + Σ l×w  (modulo 2^32, comme activation()).
+//-----------------------------------------
+I32 activation_i8(const I16* us, const I16* them, const I08* weights)
+{
+    auto sum_lo = simd::ZeroEpi32();
+    auto sum_hi = simd::ZeroEpi32();
+
+    auto accumulate = [&](const I16* acc, const I08* w)
+    {
+        for (size_t i = 0; i < HIDDEN_LAYER_SIZE; i += 2 * kChunkSize)
+        {
+            const auto clipped_1 = simd::Clip(simd::LoadEpi16(&acc[i]), QA);
+            const auto clipped_2 = simd::Clip(simd::LoadEpi16(&acc[i + kChunkSize]), QA);
+
+            // clipped² : la multiplication "low" garde les 16 bits (non signés) du carré
+            const auto square_1  = simd::MultiplyEpi16(clipped_1, clipped_1);
+            const auto square_2  = simd::MultiplyEpi16(clipped_2, clipped_2);
+
+            const auto weight    = simd::LoadEpi8(&w[i]);
+            const auto low       = simd::PackUsEpi16(simd::LowByteEpi16(square_1),  simd::LowByteEpi16(square_2));
+            const auto high      = simd::PackUsEpi16(simd::HighByteEpi16(square_1), simd::HighByteEpi16(square_2));
+
+            sum_lo = simd::DotProductEpu8Epi8(sum_lo, low,  weight);
+            sum_hi = simd::DotProductEpu8Epi8(sum_hi, high, weight);
+        }
+    };
+
+    accumulate(us,   weights);
+    accumulate(them, weights + HIDDEN_LAYER_SIZE);
+
+    // Recombinaison en arithmétique non signée (débordement défini, comme les I32 du SIMD)
+    const U32 low  = static_cast<U32>(simd::ReduceAddEpi32(sum_lo));
+    const U32 high = static_cast<U32>(simd::ReduceAddEpi32(sum_hi));
+    return static_cast<I32>(low + (high << 8));
+}
+
+#endif
+
+#if defined KERNEL_SPARSE
+
+//  Pour chaque masque de 8 bits : positions des bits à 1, dans l'ordre
+constexpr auto nonzero_lut = []
+{
+    std::array<std::array<U16, 8>, 256> lut{};
+    for (unsigned mask = 0; mask < 256; mask++)
+    {
+        unsigned count = 0;
+        for (unsigned bit = 0; bit < 8; bit++)
+            if (mask & (1u << bit))
+                lut[mask][count++] = static_cast<U16>(bit);
+    }
+    return lut;
+}();
+
+constexpr size_t kInt32Lanes = sizeof(simd::Vepi32) / sizeof(I32);
+
+//======================================================
+//! \brief  Liste des blocs de 4 entrées non nuls
+//!
+//! Chaque bloc de 4 octets est lu comme un I32 : les entrées étant
+//! dans [0, 127], le bloc est non nul si et seulement si l'I32 est > 0.
+//! La comparaison donne un masque (1 bit par bloc) ; la table donne,
+//! pour chaque octet du masque, les positions des blocs non nuls.
+//! On écrit toujours 8 indices : "indices" a 8 places de marge.
+//!
+//! \param[in]  input       entrées de L1 (alignées sur ALIGN)
+//! \param[in]  nbr_blocks  nombre de blocs (multiple de kInt32Lanes)
+//! \param[out] indices     indices des blocs non nuls
+//! \return Nombre de blocs non nuls
+//------------------------------------------------------
+size_t find_nonzero_blocks(const U08* input, size_t nbr_blocks, U16* indices)
+{
+    const I32* blocks = reinterpret_cast<const I32*>(input);
+    size_t count = 0;
+
+    for (size_t i = 0; i < nbr_blocks; i += kInt32Lanes)
+    {
+        const unsigned mask = simd::PositiveMaskEpi32(simd::LoadEpi32(&blocks[i]));
+
+        for (size_t j = 0; j < kInt32Lanes; j += 8)
+        {
+            const unsigned byte = (mask >> j) & 0xFF;
+            const auto&    lut  = nonzero_lut[byte];
+            for (size_t k = 0; k < 8; k++)
+                indices[count + k] = static_cast<U16>(i + j + lut[k]);
+            count += std::popcount(byte);
+        }
+    }
+
+    return count;
+}
+
+//======================================================
+//! \brief  Ajoute à L1 les colonnes de poids des blocs donnés
+//!
+//! Les 4 octets d'un bloc sont répliqués dans tout un vecteur ;
+//! DotProductEpu8Epi8 les multiplie par les poids de 4 entrées
+//! de kInt32Lanes neurones à la fois.
+//!
+//! \param[in]     input       entrées de L1
+//! \param[in]     indices     blocs à ajouter
+//! \param[in]     count       nombre de blocs
+//! \param[in]     weights     poids L1 du bucket : [bloc][l1][4], alignés
+//! \param[in]     l1_size     taille de L1 (multiple de kInt32Lanes)
+//! \param[in,out] z1          sorties de L1 (alignées), initialisées aux biais
+//------------------------------------------------------
+void add_blocks(const U08* input, const U16* indices, size_t count,
+                const I08* weights, size_t l1_size, I32* z1)
+{
+    const size_t chunks = l1_size / kInt32Lanes;
+    const size_t stride = l1_size * 4;
+
+    auto product = [&](const I08* column, size_t k, simd::Vepi32 sum)
+    {
+        I32 packed;
+        std::memcpy(&packed, &input[indices[k] * 4], sizeof(packed));
+        return simd::DotProductEpu8Epi8(sum, simd::SetEpi32(packed), simd::LoadEpi8(column + indices[k] * stride));
+    };
+
+    for (size_t c = 0; c < chunks; c++)
+    {
+        const I08* column = weights + c * sizeof(simd::Vepi8);
+
+        // 4 accumulateurs indépendants : la latence de DotProductEpu8Epi8
+        // ne s'ajoute pas d'un bloc au suivant
+        auto sum0 = simd::LoadEpi32(&z1[c * kInt32Lanes]);
+        auto sum1 = simd::ZeroEpi32();
+        auto sum2 = simd::ZeroEpi32();
+        auto sum3 = simd::ZeroEpi32();
+
+        size_t k = 0;
+        for (; k + 4 <= count; k += 4)
+        {
+            sum0 = product(column, k,     sum0);
+            sum1 = product(column, k + 1, sum1);
+            sum2 = product(column, k + 2, sum2);
+            sum3 = product(column, k + 3, sum3);
+        }
+        for (; k < count; k++)
+            sum0 = product(column, k, sum0);
+
+        const auto sum = simd::AddEpi32(simd::AddEpi32(sum0, sum1), simd::AddEpi32(sum2, sum3));
+        simd::StoreEpi32(&z1[c * kInt32Lanes], sum);
+    }
+}
+
+#endif
+
+}   // namespace
+
+extern const NnueKernels KERNEL_TABLE(KERNEL_ISA);
+
+const NnueKernels KERNEL_TABLE(KERNEL_ISA) = {
+    KERNEL_NAME,
+#if defined USE_SIMD
+    sizeof(simd::Vepi16),
+#else
+    0,
+#endif
+    sub_add,
+    sub_sub_add,
+    sub_sub_add_add,
+    apply_features,
+    activation,
+#if defined KERNEL_VNNI
+    activation_i8,
+#else
+    nullptr,
+#endif
+#if defined KERNEL_SPARSE
+    kInt32Lanes,
+    find_nonzero_blocks,
+    add_blocks,
+#else
+    0,
+    nullptr,
+    nullptr,
+#endif
+};
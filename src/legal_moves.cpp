@@ -8,12 +8,13 @@ constexpr int PUSH[] = {8, -8};
 
 //=================================================================
 //! \brief  Génération de tous les coups légaux
-//! \param  ml  Liste des coups dans laquelle on va stocker les coups
+//! \param  ml  Liste des coups à laquelle on ajoute les coups
+//!             (elle n'est pas vidée : voir legal_moves)
 //!
 //! algorithme de Mperft
 //-----------------------------------------------------------------
 template <Color US, MoveGenType MGType>
-void Board::legal_moves(MoveList& ml) const
+void Board::add_legal_moves(MoveList& ml) const
 {
     constexpr Color THEM = ~US;
     constexpr bool GenNoisy = (MGType & MoveGenType::NOISY) != 0;
@@ -58,8 +59,6 @@ void Board::legal_moves(MoveList& ml) const
 
     //-------------------------------------------------------------------------------------------
 
-    ml.clear();
-
     //    std::cout << "legal_gen 1 ; ch=%d " << BB::count_bit(checkersBB) << std::endl;
 
     // en échec : capturer ou bloquer l'unique pièce qui donne échec, s'il y en a une ;
@@ -337,12 +336,227 @@ void Board::legal_moves(MoveList& ml) const
 
 }
 
+//=================================================================
+//! \brief  Détermine si un coup est pseudo-légal dans la position
+//! \param  move    coup à tester (table de transposition, killer, counter)
+//!
+//! Le coup doit être codé exactement comme le coderait legal_moves :
+//! même pièce, même pièce prise, même promotion, mêmes flags.
+//! Seule la mise en échec de son propre roi n'est pas testée
+//! (voir is_legal), sauf pour le roque qui est entièrement vérifié ici.
+//-----------------------------------------------------------------
+template <Color US>
+bool Board::is_pseudo_legal(const MOVE move) const noexcept
+{
+    constexpr Color THEM = ~US;
+
+    if (move == Move::MOVE_NONE || move == Move::MOVE_NULL)
+        return false;
+
+    // bits inutilisés du codage
+    if (move & ~(Move::MOVE_FROMDEST_MASK | Move::MOVE_PIECE_MASK | Move::MOVE_CAPT_MASK |
+                 Move::MOVE_PROMO_MASK    | Move::MOVE_FLAGS_MASK))
+        return false;
+
+    const SQUARE from  = Move::from(move);
+    const SQUARE dest  = Move::dest(move);
+    const Piece  piece = piece_square[from];
+    const U32    flags = Move::flags(move);
+
+    // la pièce jouée doit être la nôtre, et être celle indiquée dans le coup
+    if (piece == Piece::PIECE_NONE || Move::color(piece) != US || Move::piece(move) != piece)
+        return false;
+
+    const Bitboard occupiedBB = occupancy_all();
+
+    // Roque : mêmes conditions que gen_castle
+    if (flags == Move::FLAG_CASTLE_MASK)
+    {
+        if (get_status().checkers)
+            return false;
+
+        const Piece king = Move::make_piece(US, PieceType::KING);
+
+        if (move == Move::CODE(get_king_from<US>(), get_king_dest<US, CastleSide::KING_SIDE>(), king, Piece::PIECE_NONE, Piece::PIECE_NONE, Move::FLAG_CASTLE_MASK))
+        {
+            if (!can_castle<US, CastleSide::KING_SIDE>() || (get_rook_path<US, CastleSide::KING_SIDE>() & occupiedBB))
+                return false;
+            Bitboard path = get_king_path<US, CastleSide::KING_SIDE>();
+            while (path)
+                if (attackers<THEM>(BB::pop_lsb(path)))
+                    return false;
+            return true;
+        }
+        if (move == Move::CODE(get_king_from<US>(), get_king_dest<US, CastleSide::QUEEN_SIDE>(), king, Piece::PIECE_NONE, Piece::PIECE_NONE, Move::FLAG_CASTLE_MASK))
+        {
+            if (!can_castle<US, CastleSide::QUEEN_SIDE>() || (get_rook_path<US, CastleSide::QUEEN_SIDE>() & occupiedBB))
+                return false;
+            Bitboard path = get_king_path<US, CastleSide::QUEEN_SIDE>();
+            while (path)
+                if (attackers<THEM>(BB::pop_lsb(path)))
+                    return false;
+            return true;
+        }
+        return false;
+    }
+
+    // on ne prend ni ses propres pièces, ni le roi adverse
+    const Piece target = piece_square[dest];
+    if (BB::test_bit(colorPiecesBB[US], dest))
+        return false;
+    if (target != Piece::PIECE_NONE && Move::type(target) == PieceType::KING)
+        return false;
+
+    if (Move::type(piece) == PieceType::PAWN)
+    {
+        constexpr int pawn_push = PUSH[US];
+        const Bitboard attackBB = Attacks::pawn_attacks<US>(from);
+
+        // prise en passant
+        if (flags == Move::FLAG_ENPASSANT_MASK)
+        {
+            return dest == get_status().ep_square
+                   && BB::test_bit(attackBB, dest)
+                   && Move::captured(move)  == Move::make_piece(THEM, PieceType::PAWN)
+                   && Move::promoted(move)  == Piece::PIECE_NONE;
+        }
+
+        // la pièce prise doit être celle de la case d'arrivée
+        if (Move::captured(move) != target)
+            return false;
+
+        // promotion si, et seulement si, on arrive sur la dernière rangée
+        const Piece promo = Move::promoted(move);
+        if (SQ::is_on_seventh_rank<US>(from))
+        {
+            if (   promo == Piece::PIECE_NONE
+                || Move::color(promo) != US
+                || Move::type(promo) < PieceType::KNIGHT
+                || Move::type(promo) > PieceType::QUEEN)
+                return false;
+        }
+        else if (promo != Piece::PIECE_NONE)
+            return false;
+
+        // capture
+        if (target != Piece::PIECE_NONE)
+            return flags == Move::FLAG_NONE && BB::test_bit(attackBB, dest);
+
+        // avance simple
+        if (flags == Move::FLAG_NONE)
+            return static_cast<int>(dest) == static_cast<int>(from) + pawn_push;
+
+        // double avance
+        if (flags == Move::FLAG_DOUBLE_MASK)
+            return SQ::is_on_second_rank<US>(from)
+                   && static_cast<int>(dest) == static_cast<int>(from) + 2 * pawn_push
+                   && piece_square[from + pawn_push] == Piece::PIECE_NONE;
+
+        return false;
+    }
+
+    // autres pièces : ni flag, ni promotion
+    if (flags != Move::FLAG_NONE || Move::promoted(move) != Piece::PIECE_NONE || Move::captured(move) != target)
+        return false;
+
+    switch (Move::type(piece))
+    {
+    case PieceType::KNIGHT:
+        return BB::test_bit(Attacks::knight_moves(from), dest);
+    case PieceType::BISHOP:
+        return BB::test_bit(Attacks::bishop_moves(from, occupiedBB), dest);
+    case PieceType::ROOK:
+        return BB::test_bit(Attacks::rook_moves(from, occupiedBB), dest);
+    case PieceType::QUEEN:
+        return BB::test_bit(Attacks::bishop_moves(from, occupiedBB) | Attacks::rook_moves(from, occupiedBB), dest);
+    case PieceType::KING:
+        return BB::test_bit(Attacks::king_moves(from), dest);
+    case PieceType::NONE:
+    case PieceType::PAWN:       // pion : traité plus haut
+        break;
+    default:
+        break;
+    }
+    return false;
+}
+
+//=================================================================
+//! \brief  Détermine si un coup pseudo-légal est légal
+//! \param  move    coup validé par is_pseudo_legal
+//!
+//! Utilise les pièces clouées et les échecs calculés dans le status,
+//! comme legal_moves.
+//-----------------------------------------------------------------
+template <Color US>
+bool Board::is_legal(const MOVE move) const noexcept
+{
+    constexpr Color THEM = ~US;
+
+    // le roque a été entièrement vérifié par is_pseudo_legal
+    if (Move::is_castling(move))
+        return true;
+
+    const SQUARE from = Move::from(move);
+    const SQUARE dest = Move::dest(move);
+    const SQUARE K    = get_king_square<US>();
+
+    const Bitboard occupiedBB = occupancy_all();
+    const Bitboard bq         = (typePiecesBB[PieceType::BISHOP] | typePiecesBB[PieceType::QUEEN]) & colorPiecesBB[THEM];
+    const Bitboard rq         = (typePiecesBB[PieceType::ROOK]   | typePiecesBB[PieceType::QUEEN]) & colorPiecesBB[THEM];
+    const Bitboard checkersBB = get_status().checkers;
+
+    // Roi : la case d'arrivée ne doit pas être attaquée,
+    // le roi étant enlevé de l'échiquier (voir legal_moves)
+    if (from == K)
+    {
+        const Bitboard occ = occupiedBB ^ SQ::square_BB(K);
+        return BB::empty( (Attacks::pawn_attacks<US>(dest) & occupancy_cp<THEM, PieceType::PAWN>())   |
+                          (Attacks::knight_moves(dest)     & occupancy_cp<THEM, PieceType::KNIGHT>()) |
+                          (Attacks::king_moves(dest)       & occupancy_cp<THEM, PieceType::KING>())   |
+                          (Attacks::bishop_moves(dest, occ) & bq) |
+                          (Attacks::rook_moves(dest, occ)   & rq) );
+    }
+
+    // Prise en passant : en échec, seul le pion qui vient d'avancer peut être pris ;
+    // on recalcule les attaques des pièces glissantes sur le roi
+    if (Move::is_enpassant(move))
+    {
+        const SQUARE   ep  = dest - PUSH[US];
+        if (checkersBB && checkersBB != SQ::square_BB(ep))
+            return false;
+        const Bitboard occ = occupiedBB ^ SQ::square_BB(from) ^ SQ::square_BB(ep) ^ SQ::square_BB(dest);
+        return BB::empty( (Attacks::bishop_moves(K, occ) & bq) |
+                          (Attacks::rook_moves(K, occ)   & rq) );
+    }
+
+    // en échec : capturer ou bloquer l'unique pièce qui donne échec
+    if (checkersBB)
+    {
+        if (BB::count_bit(checkersBB) > 1)
+            return false;
+        if (!BB::test_bit(checkersBB | squares_between(K, BB::get_lsb(checkersBB)), dest))
+            return false;
+    }
+
+    // pièce clouée : elle doit rester sur la ligne qui passe par son roi
+    if (BB::test_bit(get_status().pinned, from))
+        return DirectionMask[K].direction[dest] == DirectionMask[K].direction[from];
+
+    return true;
+}
+
 // Explicit instantiations.
-template void Board::legal_moves<WHITE, MoveGenType::NOISY>(MoveList& ml) const ;
-template void Board::legal_moves<BLACK, MoveGenType::NOISY>(MoveList& ml) const ;
+template void Board::add_legal_moves<WHITE, MoveGenType::NOISY>(MoveList& ml) const ;
+template void Board::add_legal_moves<BLACK, MoveGenType::NOISY>(MoveList& ml) const ;
+
+template void Board::add_legal_moves<WHITE, MoveGenType::QUIET>(MoveList& ml) const ;
+template void Board::add_legal_moves<BLACK, MoveGenType::QUIET>(MoveList& ml) const ;
+
+template void Board::add_legal_moves<WHITE, MoveGenType::ALL>(MoveList& ml) const ;
+template void Board::add_legal_moves<BLACK, MoveGenType::ALL>(MoveList& ml) const ;
 
-template void Board::legal_moves<WHITE, MoveGenType::QUIET>(MoveList& ml) const ;
-template void Board::legal_moves<BLACK, MoveGenType::QUIET>(MoveList& ml) const ;
+template bool Board::is_pseudo_legal<WHITE>(const MOVE move) const noexcept;
+template bool Board::is_pseudo_legal<BLACK>(const MOVE move) const noexcept;
 
-template void Board::legal_moves<WHITE, MoveGenType::ALL>(MoveList& ml) const ;
-template void Board::legal_moves<BLACK, MoveGenType::ALL>(MoveList& ml) const ;
+template bool Board::is_legal<WHITE>(const MOVE move) const noexcept;
+template bool Board::is_legal<BLACK>(const MOVE move) const noexcept;
@@ -1,7 +1,11 @@
+#include <atomic>
 #include <iostream>
+#include <thread>
+#include <vector>
 #include "Board.h"
 #include "defines.h"
 #include "Move.h"
+#include "Perft.h"
 
 //=======================================================
 //! \brief  Dénombrement des positions atteignables (perft)
@@ -85,3 +89,208 @@ template std::uint64_t perft<WHITE, false>(Board& board, const int depth) noexce
 template std::uint64_t perft<BLACK, true>(Board& board, const int depth) noexcept;
 template std::uint64_t perft<BLACK, false>(Board& board, const int depth) noexcept;
 
+
+//========================================================
+//! \brief  Fixe la taille de la table ; le contenu est effacé
+//! \param[in]  mb  taille en Mo, arrondie à la puissance de 2
+//!                 inférieure ; 0 libère la table
+//--------------------------------------------------------
+void PerftTable::resize(size_t mb)
+{
+    table = std::vector<Entry>();
+    mask  = 0;
+
+    size_t entries = mb * 1024 * 1024 / sizeof(Entry);
+    if (entries == 0)
+        return;
+    while (entries & (entries - 1))
+        entries &= entries - 1;
+
+    table = std::vector<Entry>(entries);
+    mask  = entries - 1;
+}
+
+//========================================================
+//! \brief  Efface le contenu de la table
+//--------------------------------------------------------
+void PerftTable::clear()
+{
+    for (auto& e : table)
+    {
+        e.check.store(0, std::memory_order_relaxed);
+        e.nodes.store(0, std::memory_order_relaxed);
+    }
+}
+
+namespace {
+
+//=======================================================
+//! \brief  Perft d'un sous-arbre, selon le mode mesuré
+//!
+//! \param[in,out]  board   échiquier propre à la thread
+//! \param[in]      depth   profondeur restante
+//! \param[in,out]  accum   accumulateur propre à la thread (ne sert pas)
+//! \param[in,out]  table   table partagée (mode HASHED seulement)
+//-------------------------------------------------------
+template <Color C, PerftMode M>
+U64 perft_node(Board& board, const int depth, Accumulator& accum, PerftTable* table) noexcept
+{
+    if (depth == 0)
+        return 1;
+
+    // les sous-arbres de profondeur 1 coûtent moins qu'un accès à la table
+    U64 nodes = 0ULL;
+    if constexpr (M == PerftMode::HASHED)
+    {
+        if (depth >= 2 && table->probe(board.get_key(), depth, nodes))
+            return nodes;
+    }
+
+    MoveList ml;
+    board.legal_moves<C, MoveGenType::ALL>(ml);
+
+    if constexpr (M != PerftMode::MAKE_UNDO)
+    {
+        if (depth == 1)
+            return ml.count;
+    }
+
+    for (size_t index = 0; index < ml.count; index++)
+    {
+        board.make_move<C, false>(accum, ml.mlmoves[index].move);
+        nodes += perft_node<~C, M>(board, depth - 1, accum, table);
+        board.undo_move<C>();
+    }
+
+    if constexpr (M == PerftMode::HASHED)
+    {
+        if (depth >= 2)
+            table->store(board.get_key(), depth, nodes);
+    }
+
+    return nodes;
+}
+
+//  Tâche d'une thread : les 2 premiers coups d'un sous-arbre
+struct PerftTask {
+    MOVE first;
+    MOVE second;
+};
+
+//=======================================================
+//! \brief  Perft réparti sur plusieurs threads
+//!
+//! L'arbre est découpé en sous-arbres au 2ème demi-coup : il y en a
+//! quelques centaines, bien plus que de threads, ce qui équilibre la
+//! charge même quand un coup racine domine. Chaque thread prend la
+//! tâche suivante dans la liste (compteur atomique) et la parcourt
+//! sur sa propre copie de l'échiquier.
+//-------------------------------------------------------
+template <Color C, PerftMode M>
+U64 perft_split(const Board& board, const int depth, const size_t nbr_threads, PerftTable* table)
+{
+    auto accum = std::make_unique<Accumulator>();   // ne sert pas
+
+    if (depth < 3 || nbr_threads <= 1)
+    {
+        Board copy = board;
+        copy.reserve_capacity();
+        return perft_node<C, M>(copy, depth, *accum, table);
+    }
+
+    // Liste des tâches
+    std::vector<PerftTask> tasks;
+    {
+        Board copy = board;
+        copy.reserve_capacity();
+
+        MoveList ml;
+        copy.legal_moves<C, MoveGenType::ALL>(ml);
+        for (size_t i = 0; i < ml.count; i++)
+        {
+            const MOVE first = ml.mlmoves[i].move;
+            copy.make_move<C, false>(*accum, first);
+
+            MoveList replies;
+            copy.legal_moves<~C, MoveGenType::ALL>(replies);
+            for (size_t j = 0; j < replies.count; j++)
+                tasks.push_back({first, replies.mlmoves[j].move});
+
+            copy.undo_move<C>();
+        }
+    }
+
+    std::atomic<size_t> next{0};
+    std::atomic<U64>    total{0};
+
+    auto worker = [&]() {
+        Board copy = board;
+        copy.reserve_capacity();
+        auto my_accum = std::make_unique<Accumulator>();
+
+        U64 nodes = 0;
+        for (size_t t = next.fetch_add(1, std::memory_order_relaxed); t < tasks.size();
+             t = next.fetch_add(1, std::memory_order_relaxed))
+        {
+            copy.make_move<C, false>(*my_accum, tasks[t].first);
+            copy.make_move<~C, false>(*my_accum, tasks[t].second);
+            nodes += perft_node<C, M>(copy, depth - 2, *my_accum, table);
+            copy.undo_move<~C>();
+            copy.undo_move<C>();
+        }
+        total.fetch_add(nodes, std::memory_order_relaxed);
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(nbr_threads - 1);
+    for (size_t i = 1; i < nbr_threads; i++)
+        threads.emplace_back(worker);
+    worker();
+    for (auto& t : threads)
+        t.join();
+
+    return total.load();
+}
+
+template <Color C>
+U64 perft_split(const Board& board, const int depth, const size_t nbr_threads,
+                PerftMode mode, PerftTable* table)
+{
+    switch (mode)
+    {
+    case PerftMode::MAKE_UNDO:
+        return perft_split<C, PerftMode::MAKE_UNDO>(board, depth, nbr_threads, table);
+    case PerftMode::HASHED:
+        if (table != nullptr && table->get_size() > 0)
+            return perft_split<C, PerftMode::HASHED>(board, depth, nbr_threads, table);
+        [[fallthrough]];                // sans table : génération seule
+    case PerftMode::GENERATION:
+        break;
+    default:
+        break;
+    }
+    return perft_split<C, PerftMode::GENERATION>(board, depth, nbr_threads, table);
+}
+
+} // namespace
+
+//=======================================================
+//! \brief  Perft multi-thread
+//!
+//! \param[in]  board       position de départ (non modifiée)
+//! \param[in]  depth       profondeur
+//! \param[in]  nbr_threads nombre de threads (au moins 1)
+//! \param[in]  mode        génération seule, make/undo, ou avec table
+//! \param[in]  table       table partagée pour le mode HASHED ; sans
+//!                         table, ce mode se comporte comme GENERATION
+//!
+//! \return Nombre de feuilles dénombrées
+//-------------------------------------------------------
+U64 perft_parallel(const Board& board, int depth, size_t nbr_threads,
+                   PerftMode mode, PerftTable* table)
+{
+    if (board.turn() == WHITE)
+        return perft_split<WHITE>(board, depth, nbr_threads, mode, table);
+    else
+        return perft_split<BLACK>(board, depth, nbr_threads, mode, table);
+}
@@ -21,7 +21,7 @@ int Search::quiescence(Board& board, Timer& timer, int alpha, int beta, SearchIn
     assert(beta > alpha);
 
     //  Time-out
-    if (is_stopped() || timer.check_limits(iter_depth, index, nodes))    // ATTENTION on peut avoir depth <=0
+    if (is_stopped() || timer.check_limits(iter_depth, index, global_nodes()))    // ATTENTION on peut avoir depth <=0
     {
         signal_stop();
         return 0;
@@ -56,7 +56,7 @@ int Search::quiescence(Board& board, Timer& timer, int alpha, int beta, SearchIn
     table->prefetch(board.get_key());
 
     // Met à jour le compteur de nodes et la profondeur sélective
-    nodes++;
+    count_node();
     seldepth = std::max(seldepth, si->ply);
 
     const int  old_alpha = alpha;
@@ -70,6 +70,9 @@ int Search::quiescence(Board& board, Timer& timer, int alpha, int beta, SearchIn
     int   tt_depth = 0;
     bool  tt_pv    = false;
     bool  tt_hit   = table->probe(board.get_key(), si->ply, tt_move, tt_score, tt_eval, tt_bound, tt_depth, tt_pv);
+#if defined USE_TT_KEY16
+    tt_move = board.unpack_move(static_cast<U16>(tt_move));
+#endif
 
     // note : on ne teste pas la profondeur, car dans la Quiescence, elle est à 0
     //        dans la cas de la Quiescence, on cut tous les coups, y compris la PV ????
@@ -114,7 +117,7 @@ int Search::quiescence(Board& board, Timer& timer, int alpha, int beta, SearchIn
     MOVE best_move  = Move::MOVE_NONE;  // meilleur coup local
     int  score;
     MOVE move;
-    MovePicker movePicker(board, history, si, Move::MOVE_NONE,
+    MovePicker movePicker(board, history, si, get_move_list(si), Move::MOVE_NONE,
                           Move::MOVE_NONE, Move::MOVE_NONE, Move::MOVE_NONE, 0);
 
     // QS History : suivi des captures essayées pour bonus/malus
@@ -21,6 +21,15 @@
  *  load aligné (_mm512/256/_load_si*) : mémoire alignée sur ALIGN octets,
  *      ALIGN = 64 (AVX-512) / 32 (AVX2) / 16 (SSE2) — défini dans NNUE.h
  *  _mm256_loadu_si256 : chargement depuis mémoire non alignée (plus lent)
+ *
+ *  AVX2 et AVX-512 ont en plus des wrappers int8 (Vepi8, DotProductEpu8Epi8...) :
+ *  L1 creux des couches denses et, avec VNNI (AVX512 VNNI ou AVX-VNNI),
+ *  couche de sortie en int8.
+ *
+ *  Seul kernels.cpp inclut ce fichier. Avec ARCH=multi, il est compilé une fois
+ *  par jeu d'instructions : les wrappers sont dans un namespace anonyme, pour
+ *  que chaque compilation garde ses propres versions (sinon l'éditeur de liens
+ *  pourrait retenir, par exemple, la version AVX-512 de SetEpi16 pour tous).
  */
 
 #if defined USE_SIMD
@@ -33,6 +42,7 @@
 
 
 namespace simd {
+namespace {
 
 //--------------------------------------------------------------------------------- AVX512
 // __AVX512F__ donne les instructions de base (entiers 32/64 bits),
@@ -171,6 +181,100 @@ inline int ReduceAddEpi32(Vepi32 v) {
     return _mm512_reduce_add_epi32(v);
 }
 
+//--------------------------------------------------------------------------------- AVX512 int8
+// Couches en int8 : L1 creux (LayerStack::propagate) et, avec VNNI,
+// couche de sortie (NNUE::activation_i8).
+
+using Vepi8 = __m512i;
+
+//=======================================================
+//! \brief  Charge 64 I8 depuis une adresse alignée sur ALIGN (64) octets
+//! \param[in] memory_address   adresse mémoire alignée
+//! \return Vecteur I8 chargé
+//-------------------------------------------------------
+inline Vepi8 LoadEpi8(const int8_t* memory_address) {
+    return _mm512_load_si512(reinterpret_cast<const __m512i*>(memory_address));
+}
+
+//=======================================================
+//! \brief  Stocke un vecteur I32 à une adresse alignée sur ALIGN (64) octets
+//! \param[out] memory_address  adresse mémoire alignée de destination
+//! \param[in]  vector          vecteur I32 à stocker
+//-------------------------------------------------------
+inline void StoreEpi32(int32_t* memory_address, Vepi32 vector) {
+    _mm512_store_si512(memory_address, vector);
+}
+
+//=======================================================
+//! \brief  Masque des éléments I32 strictement positifs (1 bit par élément)
+//! \param[in] v    vecteur I32
+//! \return Masque sur 16 bits
+//-------------------------------------------------------
+inline unsigned PositiveMaskEpi32(Vepi32 v) {
+    return _mm512_cmpgt_epi32_mask(v, _mm512_setzero_si512());
+}
+
+#if defined(__AVX512VNNI__)
+//--------------------------------------------------------------------------------- AVX512 VNNI
+// Couche de sortie en int8 (NNUE::activation_i8) :
+//      les carrés SCReLU (≤ 255² sur 16 bits) sont coupés en octet haut et octet bas,
+//      chacun multiplié par les poids int8 avec vpdpbusd (u8 × i8, accumulé en I32).
+
+//=======================================================
+//! \brief  Octet bas de chaque I16 (v & 0xFF)
+//! \param[in] v    vecteur I16
+//! \return Vecteur I16 des octets bas
+//-------------------------------------------------------
+inline Vepi16 LowByteEpi16(Vepi16 v) {
+    return _mm512_and_si512(v, _mm512_set1_epi16(0xFF));
+}
+
+//=======================================================
+//! \brief  Octet haut de chaque I16, vu comme non signé (v >> 8)
+//! \param[in] v    vecteur I16
+//! \return Vecteur I16 des octets hauts
+//-------------------------------------------------------
+inline Vepi16 HighByteEpi16(Vepi16 v) {
+    return _mm512_srli_epi16(v, 8);
+}
+
+//=======================================================
+//! \brief  Compacte 2 vecteurs I16 (valeurs 0..255) en un vecteur U8
+//! L'entrelacement se fait par blocs de 128 bits : les poids int8
+//! sont réordonnés en conséquence (NNUE::quantized_output).
+//! \param[in] v1   premier vecteur I16
+//! \param[in] v2   second vecteur I16
+//! \return Vecteur U8
+//-------------------------------------------------------
+inline Vepi8 PackUsEpi16(Vepi16 v1, Vepi16 v2) {
+    return _mm512_packus_epi16(v1, v2);
+}
+
+//=======================================================
+//! \brief  sum[i] += u8[4i]×i8[4i] + ... + u8[4i+3]×i8[4i+3]  (vpdpbusd, sans saturation)
+//! \param[in] sum  accumulateur I32
+//! \param[in] u8   vecteur d'octets non signés
+//! \param[in] i8   vecteur d'octets signés
+//! \return Accumulateur mis à jour
+//-------------------------------------------------------
+inline Vepi32 DotProductEpu8Epi8(Vepi32 sum, Vepi8 u8, Vepi8 i8) {
+    return _mm512_dpbusd_epi32(sum, u8, i8);
+}
+#else
+//=======================================================
+//! \brief  sum[i] += u8[4i]×i8[4i] + ... + u8[4i+3]×i8[4i+3]  (vpmaddubsw + vpmaddwd)
+//! vpmaddubsw sature les paires à ±32767 : exact seulement si u8 ≤ 127.
+//! \param[in] sum  accumulateur I32
+//! \param[in] u8   vecteur d'octets non signés (≤ 127)
+//! \param[in] i8   vecteur d'octets signés
+//! \return Accumulateur mis à jour
+//-------------------------------------------------------
+inline Vepi32 DotProductEpu8Epi8(Vepi32 sum, Vepi8 u8, Vepi8 i8) {
+    const __m512i pairs = _mm512_maddubs_epi16(u8, i8);
+    return _mm512_add_epi32(sum, _mm512_madd_epi16(pairs, _mm512_set1_epi16(1)));
+}
+#endif
+
 //--------------------------------------------------------------------------------- AVX2
 #elif defined __AVX2__
 
@@ -327,6 +431,98 @@ inline int ReduceAddEpi32(Vepi32 vector) {
     return _mm_cvtsi128_si32(sum32);
 }
 
+//--------------------------------------------------------------------------------- AVX2 int8
+// Couches en int8 : voir le bloc AVX512
+
+using Vepi8 = __m256i;
+
+//=======================================================
+//! \brief  Charge 32 I8 depuis une adresse alignée sur ALIGN (32) octets
+//! \param[in] memory_address   adresse mémoire alignée
+//! \return Vecteur I8 chargé
+//-------------------------------------------------------
+inline Vepi8 LoadEpi8(const int8_t* memory_address) {
+    return _mm256_load_si256(reinterpret_cast<const __m256i*>(memory_address));
+}
+
+//=======================================================
+//! \brief  Stocke un vecteur I32 à une adresse alignée sur ALIGN (32) octets
+//! \param[out] memory_address  adresse mémoire alignée de destination
+//! \param[in]  vector          vecteur I32 à stocker
+//-------------------------------------------------------
+inline void StoreEpi32(int32_t* memory_address, Vepi32 vector) {
+    _mm256_store_si256(reinterpret_cast<__m256i*>(memory_address), vector);
+}
+
+//=======================================================
+//! \brief  Masque des éléments I32 strictement positifs (1 bit par élément)
+//! \param[in] v    vecteur I32
+//! \return Masque sur 8 bits
+//-------------------------------------------------------
+inline unsigned PositiveMaskEpi32(Vepi32 v) {
+    const __m256i positive = _mm256_cmpgt_epi32(v, _mm256_setzero_si256());
+    return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(positive)));
+}
+
+#if defined(__AVXVNNI__)
+//--------------------------------------------------------------------------------- AVX-VNNI
+// Même chemin int8 que AVX512 VNNI, en 256 bits (Alder Lake et suivants)
+
+//=======================================================
+//! \brief  Octet bas de chaque I16 (v & 0xFF)
+//! \param[in] v    vecteur I16
+//! \return Vecteur I16 des octets bas
+//-------------------------------------------------------
+inline Vepi16 LowByteEpi16(Vepi16 v) {
+    return _mm256_and_si256(v, _mm256_set1_epi16(0xFF));
+}
+
+//=======================================================
+//! \brief  Octet haut de chaque I16, vu comme non signé (v >> 8)
+//! \param[in] v    vecteur I16
+//! \return Vecteur I16 des octets hauts
+//-------------------------------------------------------
+inline Vepi16 HighByteEpi16(Vepi16 v) {
+    return _mm256_srli_epi16(v, 8);
+}
+
+//=======================================================
+//! \brief  Compacte 2 vecteurs I16 (valeurs 0..255) en un vecteur U8
+//! L'entrelacement se fait par blocs de 128 bits : les poids int8
+//! sont réordonnés en conséquence (NNUE::quantized_output).
+//! \param[in] v1   premier vecteur I16
+//! \param[in] v2   second vecteur I16
+//! \return Vecteur U8
+//-------------------------------------------------------
+inline Vepi8 PackUsEpi16(Vepi16 v1, Vepi16 v2) {
+    return _mm256_packus_epi16(v1, v2);
+}
+
+//=======================================================
+//! \brief  sum[i] += u8[4i]×i8[4i] + ... + u8[4i+3]×i8[4i+3]  (vpdpbusd, sans saturation)
+//! \param[in] sum  accumulateur I32
+//! \param[in] u8   vecteur d'octets non signés
+//! \param[in] i8   vecteur d'octets signés
+//! \return Accumulateur mis à jour
+//-------------------------------------------------------
+inline Vepi32 DotProductEpu8Epi8(Vepi32 sum, Vepi8 u8, Vepi8 i8) {
+    return _mm256_dpbusd_avx_epi32(sum, u8, i8);
+}
+#else
+//=======================================================
+//! \brief  sum[i] += u8[4i]×i8[4i] + ... + u8[4i+3]×i8[4i+3]  (vpmaddubsw + vpmaddwd)
+//! vpmaddubsw sature les paires à ±32767 : exact seulement si u8 ≤ 127.
+//! \param[in] sum  accumulateur I32
+//! \param[in] u8   vecteur d'octets non signés (≤ 127)
+//! \param[in] i8   vecteur d'octets signés
+//! \return Accumulateur mis à jour
+//-------------------------------------------------------
+inline Vepi32 DotProductEpu8Epi8(Vepi32 sum, Vepi8 u8, Vepi8 i8) {
+    const __m256i pairs = _mm256_maddubs_epi16(u8, i8);
+    return _mm256_add_epi32(sum, _mm256_madd_epi16(pairs, _mm256_set1_epi16(1)));
+}
+#endif
+
 //--------------------------------------------------------------------------------- SSE2
 #elif defined __SSE2__
 
@@ -620,6 +816,7 @@ inline int ReduceAddEpi32(Vepi32 vector) {
 
 #endif
 
+} // namespace
 } // namespace simd
 
 #endif
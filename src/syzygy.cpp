@@ -105,11 +105,12 @@ bool Board::probe_wdl(int& score, int& bound, int ply) const
 //!
 //! Cette fonction ne doit pas être utilisée pendant la recherche.
 //!
-//! \param[out] move    coup DTZ-optimal trouvé (MOVE_NONE si non trouvé)
+//! \param[out] move            coup DTZ-optimal trouvé (MOVE_NONE si non trouvé)
+//! \param[in]  search_moves    coups autorisés ("go searchmoves") ; vide : tous
 //!
 //! \return true si la position a été trouvée dans les tables Syzygy, false sinon
 //-------------------------------------------------------------------------
-bool Board::probe_root(MOVE& move) const
+bool Board::probe_root(MOVE& move, const MoveList& search_moves) const
 {
     move = Move::MOVE_NONE;
 
@@ -123,6 +124,10 @@ bool Board::probe_root(MOVE& move) const
          || (probeLimit > 0 && pieceCount > probeLimit))
          return false;
 
+    // Avec "go searchmoves", il faut le résultat de chaque coup
+    const bool restricted = search_moves.count > 0;
+    unsigned results[TB_MAX_MOVES + 1];
+
     unsigned best = tb_probe_root(
         occupancy_c<WHITE>(),  occupancy_c<BLACK>(),
         occupancy_p<PieceType::KING>(),   occupancy_p<PieceType::QUEEN>(),
@@ -131,7 +136,7 @@ bool Board::probe_root(MOVE& move) const
         get_status().fiftymove_counter,
         get_status().ep_square == SQUARE_NONE ? 0 : get_status().ep_square,
         turn() == WHITE ? 1 : 0,
-        nullptr);
+        restricted ? results : nullptr);
 
     // Sondage échoué, ou la position est déjà terminée.
     if (   best == TB_RESULT_FAILED
@@ -139,6 +144,34 @@ bool Board::probe_root(MOVE& move) const
         || best == TB_RESULT_STALEMATE)
         return false;
 
+    if (restricted)
+    {
+        // Meilleur coup autorisé : WDL décroissant, puis gain le plus
+        // rapide ou défaite la plus lente
+        auto better = [](unsigned a, unsigned b) {
+            if (TB_GET_WDL(a) != TB_GET_WDL(b))
+                return TB_GET_WDL(a) > TB_GET_WDL(b);
+            return TB_GET_WDL(a) > TB_DRAW ? TB_GET_DTZ(a) < TB_GET_DTZ(b)
+                                           : TB_GET_DTZ(a) > TB_GET_DTZ(b);
+        };
+
+        best = TB_RESULT_FAILED;
+        for (const unsigned* r = results; *r != TB_RESULT_FAILED; r++)
+        {
+            const MOVE m = convertPyrrhicMove(*r);
+            bool allowed = false;
+            for (size_t k = 0; k < search_moves.count && !allowed; k++)
+                allowed = (search_moves.mlmoves[k].move == m);
+
+            if (allowed && (best == TB_RESULT_FAILED || better(*r, best)))
+                best = *r;
+        }
+
+        // aucun coup autorisé n'est connu des tables : on passe par la recherche
+        if (best == TB_RESULT_FAILED)
+            return false;
+    }
+
     // Jouer le coup DTZ-optimal immédiatement
     move = convertPyrrhicMove(best);
     unsigned wdl = TB_GET_WDL(best);
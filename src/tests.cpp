@@ -3,13 +3,17 @@
 #include <iostream>
 #include <chrono>
 #include <iomanip>      // std::setw
+#include <sstream>
 #include <filesystem>
 #include <memory>
+#include <thread>
+#include <algorithm>
 
 #include "defines.h"
 #include "Board.h"
 #include "Move.h"
 #include "Search.h"
+#include "Perft.h"
 
 bool test_mirror(Board& board, const std::string& line);
 template <Color C, bool divide=false>
@@ -185,23 +189,19 @@ void test_suite(const std::string& abc, int dmax)
 }
 
 //========================================================
-//! \brief  lancement d'un test perft sur une position
+//! \brief  Position de référence pour perft et nombres de feuilles attendus
 //!
 //! \param[in]  str     code désignant une position de référence
 //!                      (r, k, s, f, p21, pos3...pos6) ; sinon m_fen est utilisé
-//! \param[in]  m_fen   FEN de la position à tester si str ne correspond
-//!                      à aucun code connu
-//! \param[in]  depth   profondeur max de recherche
+//! \param[in]  m_fen   FEN utilisé si str ne correspond à aucun code connu
+//! \param[out] fen     FEN de la position
+//! \param[out] nbr     nombres de feuilles par profondeur (0 si inconnu)
 //---------------------------------------------------------
-template <bool divide>
-void test_perft(const std::string& str, const std::string& m_fen, int depth)
+static void perft_reference(const std::string& str, const std::string& m_fen,
+                            std::string& fen, std::array<U64, 11>& nbr)
 {
-
     // Le programme JetChess donne les valeurs, ainsi que les divide
 
-    std::string fen;
-    std::array<U64, 11> nbr;
-
     if (str == "r")
     {
         fen = START_FEN;
@@ -259,8 +259,25 @@ void test_perft(const std::string& str, const std::string& m_fen, int depth)
     else
     {
         fen = m_fen;
+        nbr = {};
     }
+}
 
+//========================================================
+//! \brief  lancement d'un test perft sur une position
+//!
+//! \param[in]  str     code désignant une position de référence
+//!                      (r, k, s, f, p21, pos3...pos6) ; sinon m_fen est utilisé
+//! \param[in]  m_fen   FEN de la position à tester si str ne correspond
+//!                      à aucun code connu
+//! \param[in]  depth   profondeur max de recherche
+//---------------------------------------------------------
+template <bool divide>
+void test_perft(const std::string& str, const std::string& m_fen, int depth)
+{
+    std::string fen;
+    std::array<U64, 11> nbr;
+    perft_reference(str, m_fen, fen, nbr);
 
     /* https://www.chessprogramming.org/Perft_Results
      * http://www.rocechess.ch/perft.html
@@ -292,6 +309,141 @@ void test_perft(const std::string& str, const std::string& m_fen, int depth)
         std::cout << "resultat        : >>>>>>>>>>>>>>>>>>>>>>>>>>>> KO : bon = " << nbr[depth] << std::endl;
 }
 
+//========================================================
+//! \brief  Perft multi-thread sur une position, avec table optionnelle
+//!
+//! \param[in]  str         code de la position de référence (voir test_perft)
+//! \param[in]  m_fen       FEN utilisé si str ne correspond à aucun code connu
+//! \param[in]  depth       profondeur
+//! \param[in]  nbr_threads nombre de threads (0 : toutes les threads matérielles)
+//! \param[in]  hash_mb     taille de la table en Mo (0 : sans table)
+//---------------------------------------------------------
+void test_perft_parallel(const std::string& str, const std::string& m_fen, int depth,
+                         size_t nbr_threads, size_t hash_mb)
+{
+    std::string fen;
+    std::array<U64, 11> nbr;
+    perft_reference(str, m_fen, fen, nbr);
+
+    if (nbr_threads == 0)
+        nbr_threads = std::max(1U, std::thread::hardware_concurrency());
+
+    Board CB;
+    CB.set_fen(fen, false);
+    std::cout << CB.display() << std::endl;
+    std::cout << std::endl;
+
+    PerftTable table;
+    table.resize(hash_mb);
+    const PerftMode mode = hash_mb > 0 ? PerftMode::HASHED : PerftMode::GENERATION;
+
+    auto start = TimePoint::now();
+    U64  total = perft_parallel(CB, depth, nbr_threads, mode, &table);
+    auto msec  = std::chrono::duration_cast<std::chrono::milliseconds>(TimePoint::now() - start).count();
+
+    std::cout << "Threads         : " << nbr_threads << std::endl;
+    std::cout << "Table           : " << table.get_size() << " Mo" << std::endl;
+    std::cout << "Time            : " << msec << " msec" << std::endl;
+    std::cout << "Total           : " << std::setw(10) << total << std::endl;
+    if (msec > 0)
+        std::cout << "Million Moves/s : " << std::fixed << std::setprecision(1) << static_cast<double>(total)/static_cast<double>(msec)/1000.0 << std::endl;
+    if (depth < static_cast<int>(nbr.size()) && total == nbr[depth])
+        std::cout << "resultat        : OK " << std::endl;
+    else
+        std::cout << "resultat        : >>>>>>>>>>>>>>>>>>>>>>>>>>>> KO : bon = " << (depth < static_cast<int>(nbr.size()) ? nbr[depth] : 0) << std::endl;
+}
+
+//========================================================
+//! \brief  Mesure du générateur de coups, indépendante de la recherche
+//!
+//! Perft sur une suite fixe de positions, dans les 3 modes :
+//!   - génération seule (bulk-counting) : Board::legal_moves
+//!   - make/undo : chaque feuille est jouée puis annulée
+//!   - avec table partagée (vidée avant chaque position)
+//! Les résultats sont vérifiés ; le nombre de feuilles par seconde
+//! sert de référence pour détecter une perte de performance.
+//!
+//! \param[in]  nbr_threads nombre de threads (0 : toutes les threads matérielles)
+//! \param[in]  hash_mb     taille de la table du mode "hash", en Mo
+//---------------------------------------------------------
+void test_perft_bench(size_t nbr_threads, size_t hash_mb)
+{
+    struct BenchPosition {
+        const char* code;
+        int         depth;
+    };
+    constexpr BenchPosition suite[] = {
+        {"r",    5}, {"k",    4}, {"pos3", 6},
+        {"pos4", 5}, {"pos5", 4}, {"pos6", 4}
+    };
+    struct BenchMode {
+        const char* name;
+        PerftMode   mode;
+    };
+    constexpr BenchMode modes[] = {
+        {"generation", PerftMode::GENERATION},
+        {"make/undo ", PerftMode::MAKE_UNDO},
+        {"hash      ", PerftMode::HASHED}
+    };
+
+    if (nbr_threads == 0)
+        nbr_threads = std::max(1U, std::thread::hardware_concurrency());
+    if (hash_mb == 0)
+        hash_mb = 64;
+
+    PerftTable table;
+    table.resize(hash_mb);
+
+    std::cout << "perft bench : " << nbr_threads << " thread(s) ; table " << table.get_size() << " Mo" << std::endl;
+    std::cout << "mode         position   depth        nodes      msec     Mnps" << std::endl;
+
+    int errors = 0;
+    for (const auto& m : modes)
+    {
+        U64       total_nodes = 0;
+        long long total_msec  = 0;
+
+        for (const auto& p : suite)
+        {
+            std::string fen;
+            std::array<U64, 11> nbr;
+            perft_reference(p.code, "", fen, nbr);
+
+            Board CB;
+            CB.set_fen(fen, false);
+            table.clear();
+
+            auto start = TimePoint::now();
+            U64  nodes = perft_parallel(CB, p.depth, nbr_threads, m.mode, &table);
+            auto msec  = std::chrono::duration_cast<std::chrono::milliseconds>(TimePoint::now() - start).count();
+
+            total_nodes += nodes;
+            total_msec  += msec;
+
+            const bool ok = (nodes == nbr[p.depth]);
+            if (!ok)
+                errors++;
+
+            std::cout << m.name << "   " << std::left << std::setw(8) << p.code << std::right
+                      << std::setw(5) << p.depth
+                      << std::setw(13) << nodes
+                      << std::setw(10) << msec
+                      << std::setw(9) << std::fixed << std::setprecision(1)
+                      << (msec > 0 ? static_cast<double>(nodes)/static_cast<double>(msec)/1000.0 : 0.0)
+                      << (ok ? "" : "   KO") << std::endl;
+        }
+
+        std::cout << m.name << "   total         "
+                  << std::setw(13) << total_nodes
+                  << std::setw(10) << total_msec
+                  << std::setw(9) << std::fixed << std::setprecision(1)
+                  << (total_msec > 0 ? static_cast<double>(total_nodes)/static_cast<double>(total_msec)/1000.0 : 0.0)
+                  << std::endl;
+    }
+
+    std::cout << "erreurs : " << errors << std::endl;
+}
+
 //======================================================
 //! \brief  Affiche tous les coups possibles ainsi que leur évaluation NNUE
 //!         L'affichage est trié par évaluation décroissante
@@ -381,6 +533,1165 @@ void test_eval(const std::string& fen)
 }
 
 
+//======================================================
+//! \brief  Compare la couche de sortie int8 (VNNI) au calcul int16
+//!         Pour chaque position du bench, et chaque position obtenue
+//!         après un coup légal : les 2 perspectives, tous les buckets.
+//!         Les résultats doivent être identiques au bit près.
+//------------------------------------------------------
+#include "bench.h"
+
+void test_vnni()
+{
+#if defined USE_VNNI
+    auto search = std::make_unique<Search>();
+    NNUE& nnue  = search->nnue;
+
+    if (!nnue.has_output_i8())
+    {
+        std::cout << "[test_vnni] poids de sortie hors de [-128, 127] : calcul int16 utilisé" << std::endl;
+        return;
+    }
+
+    const auto& weights = nnue.get_network()->output_weights;
+    U64 nbr_tests = 0;
+    U64 nbr_errors = 0;
+
+    auto compare = [&](const Board& board)
+    {
+        Accumulator& acc = nnue.get_accumulator();
+        nnue.lazy_updates(board, acc);
+
+        for (int bucket = 0; bucket < static_cast<int>(OUTPUT_BUCKETS); bucket++)
+        {
+            const I32 w16 = nnue.activation(acc.white, acc.black, weights, bucket);
+            const I32 w8  = nnue.activation_i8(acc.white, acc.black, bucket);
+            const I32 b16 = nnue.activation(acc.black, acc.white, weights, bucket);
+            const I32 b8  = nnue.activation_i8(acc.black, acc.white, bucket);
+
+            nbr_tests += 2;
+            if (w16 != w8 || b16 != b8)
+            {
+                nbr_errors++;
+                std::cout << "[test_vnni] erreur : " << board.get_fen() << " bucket " << bucket
+                          << " : " << w16 << "/" << w8 << " " << b16 << "/" << b8 << std::endl;
+            }
+        }
+    };
+
+    for (const auto& fen : bench_pos)
+    {
+        Board board(fen);
+        nnue.start_search(board);
+        compare(board);
+
+        MoveList ml;
+        if (board.turn() == WHITE)
+            board.legal_moves<WHITE, MoveGenType::ALL>(ml);
+        else
+            board.legal_moves<BLACK, MoveGenType::ALL>(ml);
+
+        for (size_t index = 0; index < ml.count; index++)
+        {
+            const MOVE move = ml.mlmoves[index].move;
+
+            if (board.turn() == WHITE)
+            {
+                search->make_move<WHITE, true>(board, move);
+                compare(board);
+                search->undo_move<WHITE, true>(board);
+            }
+            else
+            {
+                search->make_move<BLACK, true>(board, move);
+                compare(board);
+                search->undo_move<BLACK, true>(board);
+            }
+        }
+    }
+
+    std::cout << "[test_vnni] " << bench_pos.size() << " positions, "
+              << nbr_tests << " evaluations, " << nbr_errors << " erreurs" << std::endl;
+#else
+    std::cout << "[test_vnni] non disponible : compiler avec ARCH=vnni512 ou ARCH=avxvnni" << std::endl;
+#endif
+}
+
+//======================================================
+//! \brief  Test de Board::is_pseudo_legal / Board::is_legal
+//!         contre le générateur de coups légaux.
+//!         Parties aléatoires à partir des positions du bench ;
+//!         dans chaque position, on teste :
+//!             - tous les coups légaux (doivent être acceptés),
+//!             - des coups vus dans les positions précédentes
+//!               (comme les killers, counters),
+//!             - des coups compressés aléatoires (comme la table de transposition),
+//!             - des coups légaux aux champs modifiés (pièce prise, promotion, flags).
+//!         Un coup doit être accepté si, et seulement si,
+//!         il appartient à la liste des coups légaux.
+//!
+//! \param[in]  nbr_positions   nombre de positions à tester
+//------------------------------------------------------
+#include <random>
+
+void test_legal(U64 nbr_positions)
+{
+    constexpr int    MAX_GAME   = 200;     // longueur maximale d'une partie aléatoire
+    constexpr size_t POOL_SIZE  = 256;     // coups mémorisés des positions précédentes
+    constexpr int    NBR_RANDOM = 32;      // coups aléatoires par position
+
+    auto search = std::make_unique<Search>();
+    std::mt19937_64 rng(20240601);
+
+    std::vector<MOVE> pool(POOL_SIZE, Move::MOVE_NONE);
+    size_t pool_index = 0;
+
+    U64 nbr_tests    = 0;
+    U64 nbr_accepted = 0;
+    U64 nbr_errors   = 0;
+    U64 nbr_done     = 0;
+    size_t fen_index = 0;
+
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    auto     board_ptr = std::make_unique<Board>();
+    MoveList ml;
+    int      game_length = MAX_GAME;
+
+    auto check = [&](const MOVE move)
+    {
+        bool expected = false;
+        for (size_t n = 0; n < ml.count; n++)
+        {
+            if (ml.mlmoves[n].move == move)
+            {
+                expected = true;
+                break;
+            }
+        }
+
+        const bool result = board_ptr->is_pseudo_legal(move) && board_ptr->is_legal(move);
+
+        nbr_tests++;
+        nbr_accepted += result;
+        if (result != expected)
+        {
+            nbr_errors++;
+            if (nbr_errors <= 10)
+                std::cout << "[test_legal] erreur : " << board_ptr->get_fen() << " coup " << Move::name(move)
+                          << " (" << move << ") attendu " << expected << " obtenu " << result << std::endl;
+        }
+    };
+
+    while (nbr_done < nbr_positions)
+    {
+        // nouvelle partie
+        if (game_length >= MAX_GAME)
+        {
+            board_ptr = std::make_unique<Board>(bench_pos[fen_index++ % bench_pos.size()]);
+            game_length = 0;
+        }
+        Board& board = *board_ptr;
+
+        board.legal_moves<MoveGenType::ALL>(ml);
+        nbr_done++;
+
+        for (size_t n = 0; n < ml.count; n++)
+            check(ml.mlmoves[n].move);
+
+        for (const MOVE move : pool)
+            check(move);
+
+        for (int n = 0; n < NBR_RANDOM; n++)
+            check(board.unpack_move(static_cast<U16>(rng())));
+
+        for (size_t n = 0; n < ml.count; n++)
+        {
+            const MOVE move = ml.mlmoves[n].move;
+            check(move ^ (static_cast<U32>(1) << (Move::SHIFT_CAPT  + rng() % 4)));
+            check(move ^ (static_cast<U32>(1) << (Move::SHIFT_PROMO + rng() % 4)));
+            check(move ^ (static_cast<U32>(1) << (Move::SHIFT_FLAGS + rng() % 3)));
+        }
+
+        // fin de partie
+        if (ml.count == 0 || board.get_status().fiftymove_counter >= 100)
+        {
+            game_length = MAX_GAME;
+            continue;
+        }
+
+        const MOVE move = ml.mlmoves[rng() % ml.count].move;
+        pool[pool_index++ % POOL_SIZE] = move;
+
+        if (board.turn() == WHITE)
+            search->make_move<WHITE, false>(board, move);
+        else
+            search->make_move<BLACK, false>(board, move);
+        game_length++;
+    }
+
+    const auto end = std::chrono::high_resolution_clock::now();
+    const auto ms  = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+    std::cout << "[test_legal] " << nbr_done << " positions, " << nbr_tests << " coups testés, "
+              << nbr_accepted << " acceptés, " << nbr_errors << " erreurs (" << ms << " ms)" << std::endl;
+}
+
+//======================================================
+//! \brief  Micro-benchmark du rafraîchissement des accumulateurs
+//!         (Finny tables, NNUE::refresh_accumulator).
+//!         À partir de chaque position du bench, les rois se promènent
+//!         au hasard (WALK_LENGTH coups de roi) ; après chaque coup,
+//!         la perspective du camp qui a bougé son roi est rafraîchie,
+//!         comme dans la recherche lors d'un changement de king bucket.
+//!         Le résultat est comparé à un calcul complet de l'accumulateur.
+//------------------------------------------------------
+#if defined(__x86_64__) || defined(_M_X64)
+#include <x86intrin.h>
+#endif
+
+void test_refresh()
+{
+    constexpr int WALK_LENGTH = 32;
+    constexpr int PASSES      = 5;
+    constexpr int REPEAT      = 20;
+
+    auto search = std::make_unique<Search>();
+    auto check  = std::make_unique<Search>();
+    NNUE& nnue  = search->nnue;
+    std::mt19937_64 rng(20240601);
+
+    // Construction des promenades
+    std::vector<Board> walks;       // position après chaque coup de roi
+    std::vector<Color> sides;       // camp qui a joué le coup de roi
+    std::vector<size_t> starts;     // début de chaque promenade
+
+    for (const auto& fen : bench_pos)
+    {
+        Board board(fen);
+        starts.push_back(walks.size());
+
+        for (int n = 0; n < WALK_LENGTH; n++)
+        {
+            MoveList ml;
+            board.legal_moves<MoveGenType::ALL>(ml);
+
+            MOVE king_moves[8];
+            size_t nbr_king = 0;
+            for (size_t i = 0; i < ml.count; i++)
+                if (Move::piece_type(ml.mlmoves[i].move) == PieceType::KING && !Move::is_castling(ml.mlmoves[i].move))
+                    king_moves[nbr_king++] = ml.mlmoves[i].move;
+            if (nbr_king == 0)
+                break;
+
+            const Color  side = board.turn();
+            const MOVE   move = king_moves[rng() % nbr_king];
+            if (side == WHITE)
+                search->make_move<WHITE, false>(board, move);
+            else
+                search->make_move<BLACK, false>(board, move);
+
+            walks.push_back(board);
+            sides.push_back(side);
+        }
+    }
+    starts.push_back(walks.size());
+
+    auto refresh = [&](size_t i)
+    {
+        Accumulator& acc = nnue.get_accumulator();
+        if (sides[i] == WHITE)
+            nnue.refresh_accumulator<WHITE>(walks[i], acc);
+        else
+            nnue.refresh_accumulator<BLACK>(walks[i], acc);
+    };
+
+    // Vérification contre un calcul complet
+    size_t errors = 0;
+    for (size_t w = 0; w + 1 < starts.size(); w++)
+    {
+        nnue.start_search(walks[starts[w]]);
+        for (size_t i = starts[w]; i < starts[w+1]; i++)
+        {
+            refresh(i);
+            check->nnue.start_search(walks[i]);
+            const Accumulator& acc = nnue.get_accumulator();
+            const Accumulator& ref = check->nnue.get_accumulator();
+            errors += (sides[i] == WHITE) ? (acc.white != ref.white) : (acc.black != ref.black);
+        }
+    }
+
+    // Mesure : on garde la meilleure de PASSES mesures
+    double best_ns     = 0;
+    double best_cycles = 0;
+
+    for (int pass = 0; pass < PASSES; pass++)
+    {
+        I64 ns     = 0;
+        U64 cycles = 0;
+
+        for (int r = 0; r < REPEAT; r++)
+        {
+            for (size_t w = 0; w + 1 < starts.size(); w++)
+            {
+                // tables Finny vides au début de chaque promenade (hors mesure)
+                nnue.start_search(walks[starts[w]]);
+
+                const auto start = std::chrono::steady_clock::now();
+#if defined(__x86_64__) || defined(_M_X64)
+                const U64 tsc = __rdtsc();
+#endif
+                for (size_t i = starts[w]; i < starts[w+1]; i++)
+                    refresh(i);
+#if defined(__x86_64__) || defined(_M_X64)
+                cycles += __rdtsc() - tsc;
+#endif
+                const auto stop = std::chrono::steady_clock::now();
+                ns += std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+            }
+        }
+
+        if (pass == 0 || ns < best_ns)
+        {
+            best_ns     = static_cast<double>(ns);
+            best_cycles = static_cast<double>(cycles);
+        }
+    }
+
+    const double total = static_cast<double>(walks.size()) * REPEAT;
+
+    std::cout << "[test_refresh] " << starts.size() - 1 << " promenades, " << walks.size() << " rafraîchissements ; "
+              << std::fixed << std::setprecision(1) << best_ns / total << " ns/refresh";
+#if defined(__x86_64__) || defined(_M_X64)
+    std::cout << " ; " << std::setprecision(0) << best_cycles / total << " cycles (TSC)/refresh";
+#endif
+    std::cout << " ; " << errors << " erreurs" << std::endl;
+}
+
+//======================================================
+//! \brief  Micro-benchmark de l'inférence : coût d'une évaluation
+//!         pour chaque noyau (sortie directe int16 / int8, couches denses
+//!         avec L1 dense ou creux).
+//!         Les accumulateurs sont ceux des positions du bench et des
+//!         positions obtenues après chacun de leurs coups légaux.
+//!         Les couches denses sont celles du réseau chargé (nnload),
+//!         sinon des couches aux poids aléatoires de taille l1 et l2.
+//!
+//! \param[in]  l1  taille de la couche L1 (couches aléatoires)
+//! \param[in]  l2  taille de la couche L2 (couches aléatoires)
+//------------------------------------------------------
+#include "Layers.h"
+
+void test_nnbench(U32 l1, U32 l2)
+{
+    struct Sample {
+        alignas(ALIGN) std::array<I16, HIDDEN_LAYER_SIZE> us;
+        alignas(ALIGN) std::array<I16, HIDDEN_LAYER_SIZE> them;
+        int bucket;
+    };
+
+    auto search = std::make_unique<Search>();
+    NNUE& nnue  = search->nnue;
+    std::vector<Sample> samples;
+
+    auto collect = [&](const Board& board)
+    {
+        Accumulator& acc = nnue.get_accumulator();
+        nnue.lazy_updates(board, acc);
+
+        Sample sample;
+        sample.us     = board.turn() == WHITE ? acc.white : acc.black;
+        sample.them   = board.turn() == WHITE ? acc.black : acc.white;
+        sample.bucket = static_cast<int>((BB::count_bit(board.occupancy_all()) - 2) / BUCKET_DIVISOR);
+        samples.push_back(sample);
+    };
+
+    for (const auto& fen : bench_pos)
+    {
+        Board board(fen);
+        nnue.start_search(board);
+        collect(board);
+
+        MoveList ml;
+        if (board.turn() == WHITE)
+            board.legal_moves<WHITE, MoveGenType::ALL>(ml);
+        else
+            board.legal_moves<BLACK, MoveGenType::ALL>(ml);
+
+        for (size_t index = 0; index < ml.count; index++)
+        {
+            const MOVE move = ml.mlmoves[index].move;
+
+            if (board.turn() == WHITE)
+            {
+                search->make_move<WHITE, true>(board, move);
+                collect(board);
+                search->undo_move<WHITE, true>(board);
+            }
+            else
+            {
+                search->make_move<BLACK, true>(board, move);
+                collect(board);
+                search->undo_move<BLACK, true>(board);
+            }
+        }
+    }
+
+    std::unique_ptr<LayerStack> random_layers;
+    const LayerStack* layers = nnue.get_layers();
+    if (layers == nullptr)
+    {
+        random_layers = LayerStack::random(std::clamp(l1, 1U, MAX_LAYER_SIZE), std::clamp(l2, 1U, MAX_LAYER_SIZE), 42);
+        layers        = random_layers.get();
+    }
+
+    // Proportion d'entrées de L1 non nulles après SCReLU (valeur et bloc de 4)
+    U64 nonzero = 0;
+    U64 nonzero_blocks = 0;
+    for (const auto& sample : samples)
+    {
+        for (const auto* acc : { &sample.us, &sample.them })
+        {
+            for (size_t i = 0; i < HIDDEN_LAYER_SIZE; i += 4)
+            {
+                int n = 0;
+                for (size_t k = 0; k < 4; k++)
+                {
+                    const I32 c = std::clamp(static_cast<I32>((*acc)[i + k]), 0, QA);
+                    n += ((c * c) >> 9) != 0;
+                }
+                nonzero += n;
+                nonzero_blocks += (n != 0);
+            }
+        }
+    }
+
+    // On garde la meilleure de PASSES mesures : les autres sont perturbées
+    // par le reste de la machine
+    constexpr int PASSES = 5;
+    constexpr int REPEAT = 4;
+    const double total = static_cast<double>(samples.size()) * REPEAT;
+
+    auto measure = [&](const char* name, auto&& kernel)
+    {
+        I64    checksum = 0;
+        double best     = 0;
+
+        for (int pass = 0; pass < PASSES; pass++)
+        {
+            checksum = 0;
+            const auto start = std::chrono::steady_clock::now();
+            for (int r = 0; r < REPEAT; r++)
+                for (const auto& sample : samples)
+                    checksum += kernel(sample);
+            const auto stop = std::chrono::steady_clock::now();
+
+            const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+            if (pass == 0 || ns < best)
+                best = ns;
+        }
+
+        std::cout << std::left << std::setw(32) << name << std::right << std::setw(10) << std::fixed << std::setprecision(1)
+                  << best / total << " ns/eval   (somme " << checksum << ")" << std::endl;
+    };
+
+    std::cout << "[test_nnbench] " << samples.size() << " positions ; couches denses "
+              << HIDDEN_LAYER_SIZE << "x2 -> " << layers->get_l1_size() << " -> " << layers->get_l2_size() << " -> 1"
+              << (random_layers ? " (poids aléatoires)" : "") << std::endl;
+    std::cout << "entrées L1 non nulles          : " << std::setprecision(1) << std::fixed
+              << 100.0 * nonzero / (samples.size() * 2.0 * HIDDEN_LAYER_SIZE) << " % ; blocs de 4 non nuls : "
+              << 100.0 * nonzero_blocks / (samples.size() * 2.0 * HIDDEN_LAYER_SIZE / 4) << " %" << std::endl;
+
+    const auto& weights = nnue.get_network()->output_weights;
+    measure("sortie directe int16 (Lizard)", [&](const Sample& x) { return nnue.activation(x.us, x.them, weights, x.bucket); });
+#if defined USE_VNNI
+    if (nnue.has_output_i8())
+        measure("sortie directe int8 (dpbusd)", [&](const Sample& x) { return nnue.activation_i8(x.us, x.them, x.bucket); });
+#endif
+    const NnueKernels& kern = *nnue.get_kernels();
+    measure("couches denses, L1 dense", [&](const Sample& x) { return layers->propagate<false>(x.us, x.them, x.bucket, kern); });
+    measure("couches denses, L1 creux", [&](const Sample& x) { return layers->propagate<true>(x.us, x.them, x.bucket, kern); });
+
+    // Les 2 versions de L1 doivent donner le même résultat
+    size_t errors = 0;
+    for (const auto& sample : samples)
+        errors += layers->propagate<false>(sample.us, sample.them, sample.bucket, kern)
+               != layers->propagate<true>(sample.us, sample.them, sample.bucket, kern);
+    std::cout << "L1 creux / dense : " << errors << " différences" << std::endl;
+}
+
+//======================================================
+//! \brief  Compare et mesure les noyaux NNUE que ce CPU peut exécuter
+//!         (un seul, sauf avec ARCH=multi).
+//!         La référence est le dernier de la liste, le plus simple.
+//!         Accumulateurs : positions du bench, puis valeurs aléatoires
+//!         (pour passer par les écrêtages de SCReLU).
+//------------------------------------------------------
+#include "Cpu.h"
+#include "Kernels.h"
+
+void test_kernels()
+{
+    struct Sample {
+        alignas(ALIGN) std::array<I16, HIDDEN_LAYER_SIZE> us;
+        alignas(ALIGN) std::array<I16, HIDDEN_LAYER_SIZE> them;
+        int bucket;
+    };
+
+    constexpr U32 MAX_FEATURE = KING_BUCKETS_COUNT * INPUT_LAYER_SIZE;
+    constexpr int PASSES = 5;
+    constexpr int REPEAT = 20;
+
+    const auto         list    = Cpu::available_kernels();
+    const NnueKernels& ref     = *list.back();
+    const Network*     net     = NNUE::main_network();
+    const I16*         weights = net->feature_weights.data();
+
+    std::mt19937 rng(12345);
+    std::vector<Sample> samples;
+
+    auto search = std::make_unique<Search>();
+    for (const auto& fen : bench_pos)
+    {
+        Board board(fen);
+        search->nnue.start_search(board);
+        const Accumulator& acc = search->nnue.get_accumulator();
+
+        Sample sample;
+        sample.us     = board.turn() == WHITE ? acc.white : acc.black;
+        sample.them   = board.turn() == WHITE ? acc.black : acc.white;
+        sample.bucket = static_cast<int>((BB::count_bit(board.occupancy_all()) - 2) / BUCKET_DIVISOR);
+        samples.push_back(sample);
+    }
+    for (int n = 0; n < 200; n++)
+    {
+        Sample sample;
+        std::uniform_int_distribution<int> value(-600, 900);
+        for (size_t i = 0; i < HIDDEN_LAYER_SIZE; i++)
+        {
+            sample.us[i]   = static_cast<I16>(value(rng));
+            sample.them[i] = static_cast<I16>(value(rng));
+        }
+        sample.bucket = static_cast<int>(rng() % OUTPUT_BUCKETS);
+        samples.push_back(sample);
+    }
+
+    // features des updates et des rafraîchissements
+    struct Features {
+        U32 adds[16];
+        U32 subs[16];
+        size_t nbr_adds;
+        size_t nbr_subs;
+    };
+    std::vector<Features> features(samples.size());
+    for (auto& f : features)
+    {
+        f.nbr_adds = rng() % 17;
+        f.nbr_subs = rng() % 17;
+        for (size_t n = 0; n < 16; n++)
+        {
+            f.adds[n] = static_cast<U32>(rng() % MAX_FEATURE);
+            f.subs[n] = static_cast<U32>(rng() % MAX_FEATURE);
+        }
+    }
+
+    auto layers = LayerStack::random(128, 32, 42);
+    auto row    = [&](U32 idx) { return &weights[idx * HIDDEN_LAYER_SIZE]; };
+
+    alignas(ALIGN) std::array<I16, HIDDEN_LAYER_SIZE> out_k;
+    alignas(ALIGN) std::array<I16, HIDDEN_LAYER_SIZE> out_r;
+    alignas(ALIGN) std::array<I16, HIDDEN_LAYER_SIZE> copy_k;
+
+    // meilleure de PASSES mesures, en ns par appel
+    auto measure = [&](auto&& kernel)
+    {
+        double best = 0;
+        for (int pass = 0; pass < PASSES; pass++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (int r = 0; r < REPEAT; r++)
+                for (size_t i = 0; i < samples.size(); i++)
+                    kernel(i);
+            const auto stop = std::chrono::steady_clock::now();
+
+            const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+            if (pass == 0 || ns < best)
+                best = ns;
+        }
+        return best / (static_cast<double>(samples.size()) * REPEAT);
+    };
+
+    std::cout << "[test_kernels] " << samples.size() << " accumulateurs ; référence : " << ref.name << std::endl;
+    std::cout << std::left << std::setw(16) << "noyau" << std::right
+              << std::setw(12) << "update"
+              << std::setw(12) << "refresh"
+              << std::setw(12) << "sortie"
+              << std::setw(12) << "sortie i8"
+              << std::setw(12) << "L1 creux"
+              << std::setw(10) << "erreurs" << "   (ns/appel)" << std::endl;
+
+    I64 checksum = 0;
+
+    for (const NnueKernels* kern_ptr : list)
+    {
+        const NnueKernels& kern = *kern_ptr;
+        size_t errors = 0;
+
+#if defined USE_VNNI
+        const OutputWeightsI8* output_i8 = NNUE::quantized_output(net, kern);
+#else
+        const OutputWeightsI8* output_i8 = nullptr;
+#endif
+
+        // Vérification : mêmes résultats que la référence
+        for (size_t i = 0; i < samples.size(); i++)
+        {
+            const Sample&   x = samples[i];
+            const Features& f = features[i];
+            const I16*      w = &net->output_weights[x.bucket * N_COLORS * HIDDEN_LAYER_SIZE];
+
+            kern.sub_add(x.us.data(), out_k.data(), row(f.adds[0]), row(f.subs[0]));
+            ref.sub_add(x.us.data(), out_r.data(), row(f.adds[0]), row(f.subs[0]));
+            errors += out_k != out_r;
+
+            kern.sub_sub_add(x.us.data(), out_k.data(), row(f.adds[0]), row(f.subs[0]), row(f.subs[1]));
+            ref.sub_sub_add(x.us.data(), out_r.data(), row(f.adds[0]), row(f.subs[0]), row(f.subs[1]));
+            errors += out_k != out_r;
+
+            kern.sub_sub_add_add(x.us.data(), out_k.data(), row(f.adds[0]), row(f.adds[1]), row(f.subs[0]), row(f.subs[1]));
+            ref.sub_sub_add_add(x.us.data(), out_r.data(), row(f.adds[0]), row(f.adds[1]), row(f.subs[0]), row(f.subs[1]));
+            errors += out_k != out_r;
+
+            kern.apply_features(weights, x.us.data(), out_k.data(), copy_k.data(), f.adds, f.nbr_adds, f.subs, f.nbr_subs);
+            ref.apply_features(weights, x.us.data(), out_r.data(), nullptr, f.adds, f.nbr_adds, f.subs, f.nbr_subs);
+            errors += (out_k != out_r) || (copy_k != out_r);
+
+            const I32 sum = ref.activation(x.us.data(), x.them.data(), w);
+            errors += kern.activation(x.us.data(), x.them.data(), w) != sum;
+            if (output_i8 != nullptr)
+                errors += kern.activation_i8(x.us.data(), x.them.data(), &output_i8->weights[x.bucket * N_COLORS * HIDDEN_LAYER_SIZE]) != sum;
+
+            errors += layers->propagate<true>(x.us, x.them, x.bucket, kern) != layers->propagate<false>(x.us, x.them, x.bucket, ref);
+        }
+
+        // Mesures
+        const double update = measure([&](size_t i) {
+            const Features& f = features[i];
+            kern.sub_add(samples[i].us.data(), out_k.data(), row(f.adds[0]), row(f.subs[0]));
+            checksum += out_k[i % HIDDEN_LAYER_SIZE];
+        });
+        const double refresh = measure([&](size_t i) {
+            const Features& f = features[i];
+            kern.apply_features(weights, samples[i].us.data(), out_k.data(), nullptr, f.adds, f.nbr_adds, f.subs, f.nbr_subs);
+            checksum += out_k[i % HIDDEN_LAYER_SIZE];
+        });
+        const double output = measure([&](size_t i) {
+            const Sample& x = samples[i];
+            checksum += kern.activation(x.us.data(), x.them.data(), &net->output_weights[x.bucket * N_COLORS * HIDDEN_LAYER_SIZE]);
+        });
+        const double output_int8 = (output_i8 == nullptr) ? 0 : measure([&](size_t i) {
+            const Sample& x = samples[i];
+            checksum += kern.activation_i8(x.us.data(), x.them.data(), &output_i8->weights[x.bucket * N_COLORS * HIDDEN_LAYER_SIZE]);
+        });
+        const double sparse = measure([&](size_t i) {
+            const Sample& x = samples[i];
+            checksum += layers->propagate<true>(x.us, x.them, x.bucket, kern);
+        });
+
+        auto column = [](double ns) {
+            std::ostringstream text;
+            if (ns > 0)
+                text << std::fixed << std::setprecision(1) << ns;
+            else
+                text << "-";
+            return text.str();
+        };
+
+        std::cout << std::left << std::setw(16) << (std::string(kern.name) + (&kern == &Cpu::kernels() ? " *" : "")) << std::right
+                  << std::setw(12) << column(update)
+                  << std::setw(12) << column(refresh)
+                  << std::setw(12) << column(output)
+                  << std::setw(12) << column(output_int8)
+                  << std::setw(12) << column(sparse)
+                  << std::setw(10) << errors << std::endl;
+    }
+
+    std::cout << "* : noyau choisi pour ce CPU (somme " << checksum << ")" << std::endl;
+}
+
+//======================================================
+//! \brief  Micro-benchmark des attaques des pièces glissantes
+//!
+//! Vérifie la table SLIDER_ATTACKS contre le calcul à la volée, puis
+//! mesure le coût d'une consultation (fou, tour) sur des occupations
+//! aléatoires. Avec ARCH=multi, les magics et PEXT (si le CPU a BMI2)
+//! sont mesurés tous les deux : la table est remplie pour chacun.
+//------------------------------------------------------
+#include "Attacks.h"
+
+void test_sliders()
+{
+    struct Sample {
+        SQUARE   sq;
+        Bitboard occupied;
+    };
+
+    constexpr int SAMPLES = 4096;
+    constexpr int PASSES  = 5;
+    constexpr int REPEAT  = 256;
+
+    std::mt19937_64 rng(20240601);
+    std::vector<Sample> samples(SAMPLES);
+    for (auto& x : samples)
+    {
+        x.sq       = static_cast<SQUARE>(rng() % 64);
+        x.occupied = rng() & rng() & rng();        // ~12 % des cases occupées
+        x.occupied |= SQ::square_BB(x.sq);
+    }
+
+    // meilleure de PASSES mesures, en ns par consultation
+    U64  checksum = 0;
+    auto measure  = [&](auto&& lookup)
+    {
+        double best = 0;
+        for (int pass = 0; pass < PASSES; pass++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            U64 acc = 0;
+            for (int r = 0; r < REPEAT; r++)
+                for (const auto& x : samples)
+                    acc += lookup(x.sq, x.occupied);
+            const auto stop = std::chrono::steady_clock::now();
+            checksum += acc;
+
+            const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count())
+                              / (static_cast<double>(REPEAT) * SAMPLES);
+            if (pass == 0 || ns < best)
+                best = ns;
+        }
+        return best;
+    };
+
+    struct Method {
+        const char* name;
+        bool        pext;
+    };
+#if defined USE_DISPATCH
+    std::vector<Method> methods = {{"magic", false}};
+    if (Cpu::features().bmi2)
+        methods.push_back({"pext", true});
+#elif defined USE_PEXT
+    std::vector<Method> methods = {{"pext", true}};
+#else
+    std::vector<Method> methods = {{"magic", false}};
+#endif
+
+    std::cout << "table des glisseurs : " << (Attacks::BISHOP_TABLE_SIZE + Attacks::ROOK_TABLE_SIZE) * sizeof(Bitboard) / 1024
+              << " Ko (fous " << Attacks::BISHOP_TABLE_SIZE << " , tours " << Attacks::ROOK_TABLE_SIZE << " entrées)" << std::endl;
+    std::cout << "méthode      fou (ns)   tour (ns)   dame (ns)   erreurs" << std::endl;
+
+    for (const auto& m : methods)
+    {
+#if defined USE_DISPATCH
+        Attacks::use_pext = m.pext;
+        Attacks::init_bishop_attacks();
+        Attacks::init_rook_attacks();
+#endif
+
+        int errors = 0;
+        for (const auto& x : samples)
+        {
+            if (Attacks::bishop_moves(x.sq, x.occupied) != Attacks::bishop_attacks_on_the_fly(x.sq, x.occupied))
+                errors++;
+            if (Attacks::rook_moves(x.sq, x.occupied) != Attacks::rook_attacks_on_the_fly(x.sq, x.occupied))
+                errors++;
+        }
+
+        const double bishop = measure([](SQUARE sq, Bitboard occ) { return Attacks::bishop_moves(sq, occ); });
+        const double rook   = measure([](SQUARE sq, Bitboard occ) { return Attacks::rook_moves(sq, occ); });
+        const double queen  = measure([](SQUARE sq, Bitboard occ) { return Attacks::queen_moves(sq, occ); });
+
+        std::cout << std::left << std::setw(10) << m.name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(11) << bishop
+                  << std::setw(12) << rook
+                  << std::setw(12) << queen
+                  << std::setw(10) << errors << std::endl;
+    }
+
+#if defined USE_DISPATCH
+    // retour à la méthode choisie pour ce CPU
+    Attacks::init_masks();
+#endif
+
+    std::cout << "(somme " << checksum << ")" << std::endl;
+}
+
+//======================================================
+//! \brief  Test du "ponder" : simule les séquences d'une GUI
+//!
+//!   - go ponder, puis stop           : bestmove seulement après "stop"
+//!   - go ponder depth, puis ponderhit : recherche finie, bestmove retenu
+//!                                       jusqu'au "ponderhit"
+//!   - go ponder movetime, ponderhit   : le temps compte à partir du "ponderhit"
+//!   - go ponder wtime/btime, ponderhit: la recherche continue sans redémarrer
+//!
+//! L'envoi du "bestmove" est repéré par la mesure de latence
+//! "stop" -> "bestmove" de la ThreadPool (nulle tant qu'il n'est pas envoyé).
+//------------------------------------------------------
+#include "ThreadPool.h"
+
+void test_ponder()
+{
+    const Board board(START_FEN);
+    const bool  log = threadPool.get_logUci();
+    threadPool.set_logUci(false);
+
+    int errors = 0;
+
+    auto go_ponder = [&](int wtime, int depth, int movetime) {
+        Timer timer(false, wtime, wtime, 0, 0, 0, depth, 0, movetime);
+        timer.set_ponder(&threadPool.pondering);
+        timer.start();
+        timer.setup(board.side_to_move);
+        threadPool.start_thinking(board, timer);
+    };
+    auto sent = [&]() { return threadPool.get_stop_latency() != 0; };
+    auto ms_since = [](TimePoint::time_point t) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(TimePoint::now() - t).count();
+    };
+    // attend le bestmove au plus "limit" ms ; retourne le délai, ou -1
+    auto wait_sent = [&](I64 limit) -> I64 {
+        const auto start = TimePoint::now();
+        while (!sent() && ms_since(start) < limit)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return sent() ? ms_since(start) : -1;
+    };
+    auto report = [&](const char* name, bool ok, I64 ms) {
+        if (!ok)
+            errors++;
+        std::cout << std::left << std::setw(36) << name << std::right
+                  << std::setw(6) << ms << " ms   " << (ok ? "OK" : "KO") << std::endl;
+    };
+
+    // 1- go ponder wtime 10000 btime 10000 ; stop après 800 ms (> temps alloué)
+    {
+        go_ponder(10000, 0, 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(800));
+        const bool early = sent();
+        threadPool.stop();
+        report("ponder + stop", !early && sent(), threadPool.get_stop_latency() / 1000);
+    }
+
+    // 2- go ponder depth 3 ; ponderhit
+    {
+        go_ponder(0, 3, 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        const bool early = sent();
+        threadPool.ponderhit();
+        const I64 delay = wait_sent(1000);
+        report("ponder depth 3 + ponderhit", !early && delay >= 0 && delay < 100, delay);
+        threadPool.stop();
+    }
+
+    // 3- go ponder movetime 200 ; ponderhit après 400 ms
+    {
+        go_ponder(0, 0, 200);
+        std::this_thread::sleep_for(std::chrono::milliseconds(400));
+        const bool early = sent();
+        threadPool.ponderhit();
+        const I64 delay = wait_sent(2000);
+        report("ponder movetime 200 + ponderhit", !early && delay >= 190 && delay < 600, delay);
+        threadPool.stop();
+    }
+
+    // 4- go ponder wtime 3000 btime 3000 ; ponderhit après 300 ms
+    {
+        go_ponder(3000, 0, 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        const bool early = sent();
+        const U64  nodes = threadPool.search[0]->nodes;
+        threadPool.ponderhit();
+        const I64 delay = wait_sent(5000);
+        // la recherche n'a pas redémarré : les nœuds du "ponder" sont toujours comptés
+        const bool kept = threadPool.search[0]->nodes >= nodes && nodes > 0;
+        report("ponder clock + ponderhit", !early && kept && delay >= 0 && delay < 1000, delay);
+        threadPool.stop();
+    }
+
+    threadPool.set_logUci(log);
+    std::cout << "erreurs : " << errors << std::endl;
+}
+
+//======================================================
+//! \brief  Test de la limite "go nodes"
+//!
+//! Pour chaque position du bench, recherche limitée à "nodes" :
+//! deux fois avec une thread (le nombre de nodes doit être
+//! identique), puis avec "nbr_threads" threads. Le dépassement
+//! de la limite, toutes threads confondues, doit rester inférieur
+//! à un lot de publication (Search::NODES_BATCH) par thread.
+//!
+//! \param[in]  nodes       limite en nodes
+//! \param[in]  nbr_threads nombre de threads de la seconde série
+//------------------------------------------------------
+void test_nodes(U64 nodes, U32 nbr_threads)
+{
+    const bool log     = threadPool.get_logUci();
+    const U32  threads = threadPool.get_nbrThreads();
+    threadPool.set_logUci(false);
+
+    auto run = [&](const Board& board) {
+        transpositionTable.clear();
+        threadPool.reset();
+
+        Timer timer(false, 0, 0, 0, 0, 0, 0, nodes, 0);
+        timer.start();
+        timer.setup(board.side_to_move);
+
+        threadPool.start_thinking(board, timer);
+        threadPool.wait(0);
+        return threadPool.get_all_nodes();
+    };
+
+    int errors = 0;
+    U64 max_over_1 = 0;
+    U64 max_over_n = 0;
+
+    threadPool.set_threads(1);
+    for (const auto& fen : bench_pos)
+    {
+        Board board(fen);
+        const U64 first  = run(board);
+        const U64 second = run(board);
+        if (first != second)
+            errors++;
+        max_over_1 = std::max(max_over_1, first > nodes ? first - nodes : 0);
+    }
+
+    // le nombre de threads est limité au nombre de processeurs
+    threadPool.set_threads(nbr_threads);
+    nbr_threads = threadPool.get_nbrThreads();
+    for (const auto& fen : bench_pos)
+    {
+        Board board(fen);
+        const U64 total = run(board);
+        const U64 over  = total > nodes ? total - nodes : 0;
+        if (over > static_cast<U64>(Search::NODES_BATCH) * nbr_threads)
+            errors++;
+        max_over_n = std::max(max_over_n, over);
+    }
+
+    threadPool.set_threads(threads);
+    threadPool.set_logUci(log);
+
+    std::cout << "positions        : " << bench_pos.size() << " ; limite " << nodes << " nodes" << std::endl;
+    std::cout << "1 thread         : dépassement max " << max_over_1 << " nodes" << std::endl;
+    std::cout << std::left << std::setw(17) << (std::to_string(nbr_threads) + " threads") << std::right
+              << ": dépassement max " << max_over_n << " nodes" << std::endl;
+    std::cout << "erreurs          : " << errors << std::endl;
+}
+
+//======================================================
+//! \brief  Test du Watchdog : latence échéance -> "bestmove"
+//!
+//! Sur les premières positions du bench, recherches limitées en
+//! temps, avec MoveOverhead = 1 ms :
+//!   - go movetime <movetime>
+//!   - go wtime/btime <20 * movetime>   (échéance "hard" de setup)
+//!
+//! Quand le Watchdog a coupé la recherche, la latence est la somme
+//! de son retard sur l'échéance et de la latence arrêt -> "bestmove"
+//! de la ThreadPool.
+//!
+//! \param[in]  movetime    temps par recherche, en millisecondes
+//------------------------------------------------------
+void test_watchdog(int movetime)
+{
+    constexpr size_t NBR_POSITIONS = 10;
+    const bool log = threadPool.get_logUci();
+    threadPool.set_logUci(false);
+
+    auto run = [&](const char* name, int wtime, int mtime) {
+        int fired = 0;
+        I64 sum_latency = 0, max_latency = 0;
+        U64 nodes = 0;
+        I64 elapsed = 0;
+
+        for (size_t i = 0; i < NBR_POSITIONS && i < bench_pos.size(); i++)
+        {
+            const Board board(bench_pos[i]);
+            transpositionTable.clear();
+            threadPool.reset();
+
+            Timer timer(false, wtime, wtime, 0, 0, 0, 0, 0, mtime, 1);
+            timer.start();
+            timer.setup(board.side_to_move);
+
+            threadPool.start_thinking(board, timer);
+            threadPool.wait(0);
+            elapsed += timer.elapsedTime();
+            nodes   += threadPool.get_all_nodes();
+
+            const I64 lateness = threadPool.get_watchdog_lateness();
+            if (lateness >= 0)
+            {
+                const I64 latency = lateness + threadPool.get_stop_latency();
+                fired++;
+                sum_latency += latency;
+                max_latency  = std::max(max_latency, latency);
+            }
+        }
+
+        std::cout << std::left << std::setw(24) << name << std::right
+                  << " : échéances " << std::setw(2) << fired << "/" << NBR_POSITIONS
+                  << " ; latence moy " << std::setw(6) << (fired ? sum_latency / fired : 0) << " us"
+                  << " max " << std::setw(6) << max_latency << " us"
+                  << " ; nps " << (elapsed > 0 ? nodes * 1000 / static_cast<U64>(elapsed) : 0) << std::endl;
+    };
+
+    const std::string mt = "movetime " + std::to_string(movetime);
+    const std::string wt = "wtime " + std::to_string(20 * movetime);
+    run(mt.c_str(), 0, movetime);
+    run(wt.c_str(), 20 * movetime, 0);
+
+    threadPool.set_logUci(log);
+}
+
+//======================================================
+//! \brief  Test du MultiPV : coût de n lignes par rapport à une seule
+//!
+//! Pour chaque position du bench, recherche à profondeur fixe avec
+//! MultiPV 1, puis MultiPV n (TT vidée avant chaque recherche).
+//! Vérifie que les lignes commencent par des coups différents et
+//! sont rangées par score décroissant.
+//!
+//! \param[in]  nbr_lines   nombre de lignes (MultiPV)
+//! \param[in]  depth       profondeur de recherche
+//------------------------------------------------------
+void test_multipv(int nbr_lines, int depth)
+{
+    const bool log = threadPool.get_logUci();
+    const int  old = threadPool.get_multiPV();
+    threadPool.set_logUci(false);
+
+    auto run = [&](const Board& board, int lines) {
+        transpositionTable.clear();
+        threadPool.reset();
+        threadPool.set_multiPV(lines);
+
+        Timer timer(false, 0, 0, 0, 0, 0, depth, 0, 0);
+        timer.start();
+        timer.setup(board.side_to_move);
+
+        const auto start = TimePoint::now();
+        threadPool.start_thinking(board, timer);
+        threadPool.wait(0);
+        return std::chrono::duration_cast<std::chrono::microseconds>(TimePoint::now() - start).count();
+    };
+
+    U64 nodes_1 = 0, nodes_n = 0;
+    I64 time_1  = 0, time_n  = 0;
+    int errors  = 0;
+
+    for (const auto& fen : bench_pos)
+    {
+        Board board(fen);
+
+        time_1  += run(board, 1);
+        nodes_1 += threadPool.get_all_nodes();
+
+        time_n  += run(board, nbr_lines);
+        nodes_n += threadPool.get_all_nodes();
+
+        const Search& s = *threadPool.search[0];
+        for (int k = 1; k < s.multipv_count; k++)
+        {
+            if (s.multipv_scores[k] > s.multipv_scores[k-1])
+                errors++;
+            for (int j = 0; j < k; j++)
+                if (s.multipv_lines[k].line[0] == s.multipv_lines[j].line[0])
+                    errors++;
+        }
+    }
+
+    threadPool.set_multiPV(old);
+    threadPool.set_logUci(log);
+
+    std::cout << "positions        : " << bench_pos.size() << " ; profondeur " << depth << std::endl;
+    std::cout << "MultiPV 1        : " << std::setw(10) << nodes_1 << " nodes " << std::setw(8) << time_1 / 1000 << " ms" << std::endl;
+    std::cout << "MultiPV " << std::left << std::setw(9) << nbr_lines << std::right << ": "
+              << std::setw(10) << nodes_n << " nodes " << std::setw(8) << time_n / 1000 << " ms" << std::endl;
+    if (nodes_1 > 0 && time_1 > 0)
+        std::cout << "rapport          : " << std::fixed << std::setprecision(2)
+                  << static_cast<double>(nodes_n) / static_cast<double>(nodes_1) << " (nodes) "
+                  << static_cast<double>(time_n) / static_cast<double>(time_1) << " (temps)" << std::endl;
+    std::cout << "erreurs          : " << errors << std::endl;
+}
+
+//======================================================
+//! \brief  Score de chaque coup légal de la position
+//!
+//! Un coup à la fois, par "go searchmoves <coup> nodes <n>" ;
+//! la table de transposition n'est pas vidée entre deux coups :
+//! les sous-arbres communs ne sont cherchés qu'une fois.
+//!
+//! \param[in]  fen     position à analyser
+//! \param[in]  nodes   nombre de nodes par coup
+//------------------------------------------------------
+void test_root_scores(const std::string& fen, U64 nodes)
+{
+    Board board(fen);
+
+    MoveList ml;
+    board.legal_moves<MoveGenType::ALL>(ml);
+
+    const bool log = threadPool.get_logUci();
+    const int  old = threadPool.get_multiPV();
+    threadPool.set_logUci(false);
+    threadPool.set_multiPV(1);
+
+    struct RootScore { MOVE move; int score; int depth; U64 nodes; };
+    std::vector<RootScore> results;
+    int errors = 0;
+
+    const auto start = TimePoint::now();
+    for (size_t k = 0; k < ml.count; k++)
+    {
+        MoveList search_moves;
+        search_moves.mlmoves[search_moves.count++].move = ml.mlmoves[k].move;
+
+        Timer timer(false, 0, 0, 0, 0, 0, 0, nodes, 0);
+        timer.start();
+        timer.setup(board.side_to_move);
+
+        threadPool.start_thinking(board, timer, search_moves);
+        threadPool.wait(0);
+
+        const Search& s = *threadPool.search[threadPool.get_best_thread()];
+        if (s.pv_moves[s.best_depth] != ml.mlmoves[k].move)
+            errors++;
+        results.push_back({ml.mlmoves[k].move, s.pv_scores[s.best_depth], s.best_depth, threadPool.get_all_nodes()});
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(TimePoint::now() - start).count();
+
+    threadPool.set_multiPV(old);
+    threadPool.set_logUci(log);
+
+    std::stable_sort(results.begin(), results.end(),
+                     [](const RootScore& a, const RootScore& b) { return a.score > b.score; });
+
+    std::cout << board.display() << std::endl;
+    for (const auto& r : results)
+    {
+        std::cout << std::left  << std::setw(7)  << Move::name(r.move)
+                  << std::right << std::setw(7)  << r.score << " cp"
+                  << "  depth " << std::setw(3)  << r.depth
+                  << "  nodes " << std::setw(10) << r.nodes << std::endl;
+    }
+    std::cout << "coups            : " << results.size() << " ; " << nodes << " nodes par coup" << std::endl;
+    std::cout << "temps            : " << elapsed << " ms" << std::endl;
+    std::cout << "erreurs          : " << errors << std::endl;
+}
 
 //====================================================
 //! \brief Test Syzygy : sonde les tables pour la position
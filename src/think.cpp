@@ -28,6 +28,22 @@ void Search::think(Board board, Timer timer, size_t m_index)
     board.reserve_capacity();
 
     nnue.start_search(board);
+    eval_cache.reset_stats();
+
+    // MultiPV : pas plus de lignes que de coups cherchés ; les helpers cherchent une seule ligne
+    multipv_count = 1;
+    multipv_index = 0;
+    if (m_index == 0 && threadPool.get_multiPV() > 1)
+    {
+        size_t nbr_moves = search_moves.count;
+        if (nbr_moves == 0)
+        {
+            MoveList ml;
+            board.legal_moves<C, MoveGenType::ALL>(ml);
+            nbr_moves = ml.count;
+        }
+        multipv_count = std::clamp(static_cast<int>(nbr_moves), 1, threadPool.get_multiPV());
+    }
 
     // Réinitialise la table LMR (nécessaire car les TunableParam
     // peuvent ne pas être initialisés lors de la construction globale,
@@ -59,15 +75,22 @@ void Search::think(Board board, Timer timer, size_t m_index)
     // Arrêt des threads, affichage du résultat
     if (m_index == 0)
     {
+        // En "ponder", le "bestmove" n'est envoyé qu'après "ponderhit" ou "stop",
+        // même si la recherche est finie (profondeur maximale, mat trouvé) ;
+        // les autres threads continuent pendant ce temps.
+        while (timer.is_pondering() && !is_stopped())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
         // Toujours arrêter et attendre les autres threads
         threadPool.main_thread_stopped();
         threadPool.wait(1);
+        threadPool.mark_bestmove();
 
         // Sélection et affichage du meilleur résultat parmi toutes les threads
         if (threadPool.get_logUci())
         {
             const int     bt  = threadPool.get_best_thread();
-            const Search& bts = threadPool.search[bt];
+            const Search& bts = *threadPool.search[bt];
 
             // Si le meilleur résultat vient d'une thread helper, la dernière
             // ligne "info" affichée est celle de la thread 0 et son premier
@@ -76,13 +99,57 @@ void Search::think(Board board, Timer timer, size_t m_index)
             if (bt != 0 && bts.last_pv.length > 0)
                 bts.show_uci_result(timer.elapsedTime(), bts.last_pv);
 
-            show_uci_best(bts.pv_moves[bts.best_depth]);
+            const MOVE best   = bts.pv_moves[bts.best_depth];
+            MOVE       ponder = (bts.last_pv.length >= 2 && bts.last_pv.line[0] == best)
+                                ? bts.last_pv.line[1] : Move::MOVE_NONE;
+            if (ponder == Move::MOVE_NONE && best != Move::MOVE_NONE && threadPool.get_usePonder())
+                ponder = tt_ponder_move<C>(board, best);
+
+            show_uci_best(best, ponder);
         }
 
         table->update_age();
     }
 }
 
+//======================================================
+//! \brief  Coup attendu de l'adversaire, lu dans la TT
+//!
+//! Utilisé quand la PV s'arrête au meilleur coup (coupure
+//! par la TT à la racine, recherche arrêtée très tôt) :
+//! la GUI a besoin d'un coup "ponder" pour réfléchir
+//! pendant le temps de l'adversaire.
+//!
+//! \param[in,out]  board   position racine (rendue inchangée)
+//! \param[in]      best    meilleur coup trouvé
+//!
+//! \return Coup trouvé, ou Move::MOVE_NONE
+//------------------------------------------------------
+template<Color C>
+MOVE Search::tt_ponder_move(Board& board, MOVE best)
+{
+    make_move<C, false>(board, best);
+
+    MOVE move  = Move::MOVE_NONE;
+    int  score, eval, bound, depth;
+    bool pv;
+    if (table->probe(board.get_key(), 0, move, score, eval, bound, depth, pv))
+    {
+#if defined USE_TT_KEY16
+        move = board.unpack_move(static_cast<U16>(move));
+#endif
+        if (move != Move::MOVE_NONE && !(board.is_pseudo_legal(move) && board.is_legal(move)))
+            move = Move::MOVE_NONE;
+    }
+    else
+    {
+        move = Move::MOVE_NONE;
+    }
+
+    undo_move<C, false>(board);
+    return move;
+}
+
 //======================================================
 //! \brief  iterative deepening
 //!
@@ -97,26 +164,66 @@ void Search::think(Board board, Timer timer, size_t m_index)
 template<Color C>
 void Search::iterative_deepening(Board& board, Timer& timer, SearchInfo* si)
 {
-    int prev_score = -INFINITE;
+    // score de chaque ligne à l'itération précédente (fenêtre d'aspiration)
+    std::array<int, MAX_MULTIPV> prev_scores;
+    prev_scores.fill(-INFINITE);
 
     for (iter_depth = 1; iter_depth <= timer.getSearchDepth(); iter_depth++)
     {
-        // Recherche la position, avec des aspiration windows pour les profondeurs élevées
-        const int score = aspiration_window<C>(board, timer, si, prev_score);
+        // À partir de cette profondeur, la limite en temps peut couper la recherche
+        if (index == 0 && iter_depth == Watchdog::MIN_DEPTH)
+            threadPool.arm_watchdog();
+
+        // Recherche la position, avec des aspiration windows pour les profondeurs élevées.
+        // En MultiPV, chaque ligne exclut à la racine les premiers coups des lignes
+        // précédentes ; la TT et l'History sont partagées entre les lignes.
+        // Chaque ligne est une recherche complète à la même profondeur : 5 lignes
+        // coûtent environ 4.2 à 4.5 fois une seule (commande "multipv"). Le partage
+        // ne fait gagner que la fraction restante ; réduire la profondeur des
+        // lignes suivantes fausserait leurs scores, qu'on compare entre eux.
+        std::array<PVariation, MAX_MULTIPV> lines;
+        std::array<int, MAX_MULTIPV>        scores;
+
+        for (multipv_index = 0; multipv_index < multipv_count; multipv_index++)
+        {
+            scores[multipv_index] = aspiration_window<C>(board, timer, si, prev_scores[multipv_index]);
+            if (is_stopped())
+                break;
+
+            lines[multipv_index]         = si->pv;
+            multipv_moves[multipv_index] = si->pv.line[0];
+        }
+        multipv_index = 0;
 
         if (is_stopped())
             break;
 
+        // Les lignes sont rangées par score décroissant (tri stable)
+        for (int k = 1; k < multipv_count; k++)
+        {
+            for (int j = k; j > 0 && scores[j] > scores[j-1]; j--)
+            {
+                std::swap(scores[j], scores[j-1]);
+                std::swap(lines[j],  lines[j-1]);
+            }
+        }
+        const int score = scores[0];
+
         // L'itération s'est terminée sans problème
         // Toutes les threads sauvegardent leur meilleur résultat
         best_depth = iter_depth;
 
         // Historique par profondeur
         pv_scores[iter_depth] = score;
-        pv_moves [iter_depth] = si->pv.line[0];
-        last_pv               = si->pv;
+        pv_moves [iter_depth] = lines[0].line[0];
+        last_pv               = lines[0];
 
-        prev_score = score;
+        for (int k = 0; k < multipv_count; k++)
+        {
+            multipv_lines [k] = lines[k];
+            multipv_scores[k] = scores[k];
+            prev_scores   [k] = scores[k];
+        }
 
         // Seule la thread principale gère l'affichage UCI et le time management
         if (index == 0)
@@ -124,13 +231,22 @@ void Search::iterative_deepening(Board& board, Timer& timer, SearchInfo* si)
             auto elapsed = timer.elapsedTime();
 
             if (threadPool.get_logUci())
-                show_uci_result(elapsed, si->pv);
+            {
+                if (multipv_count == 1)
+                    show_uci_result(elapsed, last_pv);
+                else
+                    for (int k = 0; k < multipv_count; k++)
+                        show_uci_result(elapsed, lines[k], scores[k], k + 1);
+            }
+            threadPool.mark_first_info();
 
             // Mise à jour de la stabilité de la PV
             timer.update(iter_depth, pv_moves[iter_depth-1], pv_moves[iter_depth]);
 
             // Si une itération se termine après le temps optimal, on arrête la recherche
-            if (timer.finishOnThisDepth(elapsed, iter_depth, nodes, pv_scores, pv_moves))
+            // (limite en nodes : sur le total de toutes les threads)
+            const U64 depth_nodes = timer.is_node_limited() ? global_nodes() : static_cast<U64>(nodes);
+            if (timer.finishOnThisDepth(elapsed, iter_depth, depth_nodes, pv_scores, pv_moves))
                 break;
 
             seldepth = 0;
@@ -229,7 +345,7 @@ int Search::alpha_beta(Board& board, Timer& timer, int alpha, int beta, int dept
     const bool isRoot     = (si->ply == 0);
 
     //  Time-out
-    if (is_stopped() || timer.check_limits(iter_depth, index, nodes))
+    if (is_stopped() || timer.check_limits(iter_depth, index, global_nodes()))
     {
         signal_stop();
         return 0;
@@ -290,7 +406,7 @@ int Search::alpha_beta(Board& board, Timer& timer, int alpha, int beta, int dept
     const bool isPV = ((beta - alpha) != 1);
 
      // Met à jour le compteur de nodes et la profondeur sélective
-    nodes++;
+    count_node();
     seldepth = isRoot ? 0 : std::max(seldepth, si->ply);
 
     int  score      = -INFINITE;
@@ -311,6 +427,17 @@ int Search::alpha_beta(Board& board, Timer& timer, int alpha, int beta, int dept
     int   tt_depth = 0;
     bool  tt_pv    = false;
     bool  tt_hit   = isExcluded ? false : table->probe(board.get_key(), si->ply, tt_move, tt_score, tt_eval, tt_bound, tt_depth, tt_pv);
+#if defined USE_TT_KEY16
+    tt_move = board.unpack_move(static_cast<U16>(tt_move));
+#endif
+
+    // MultiPV : le coup de la TT racine est celui de la première ligne, déjà exclu.
+    // On commence par le meilleur coup restant de l'itération précédente.
+    // "go searchmoves" : le coup de la TT racine peut être hors de la liste.
+    if (isRoot && multipv_index > 0)
+        tt_move = multipv_hint();
+    else if (isRoot && is_searchmoves_excluded(tt_move))
+        tt_move = best_depth > 0 ? pv_moves[best_depth] : search_moves.mlmoves[0].move;
 
     // On fait confiance à la TT si ce n'est pas un pvnode et que la profondeur
     // de l'entrée est suffisamment élevée.
@@ -334,7 +461,9 @@ int Search::alpha_beta(Board& board, Timer& timer, int alpha, int beta, int dept
     int max_score = MATE;
     const bool ttPV = isPV || tt_pv;
 
-    if (!isExcluded && threadPool.get_useSyzygy() && board.probe_wdl(tb_score, tb_bound, si->ply) == true)
+    // (pas à la racine restreinte : le résultat WDL est celui de la position, pas des coups cherchés)
+    if (   !isExcluded && !(isRoot && is_root_restricted())
+        && threadPool.get_useSyzygy() && board.probe_wdl(tb_score, tb_bound, si->ply) == true)
     {
         tbhits++;
 
@@ -463,7 +592,7 @@ int Search::alpha_beta(Board& board, Timer& timer, int alpha, int beta, int dept
             score = quiescence<C>(board, timer, alpha, beta, si);
             if (score <= alpha)
             {
-                nodes--;
+                uncount_node();
                 return score;
             }
         }
@@ -539,7 +668,7 @@ int Search::alpha_beta(Board& board, Timer& timer, int alpha, int beta, int dept
         {
             // Seuil SEE : la capture doit pouvoir combler l'écart entre l'éval
             // statique et betaCut (idée Ethereal / Berserk)
-            MovePicker movePicker(board, history, si, Move::MOVE_NONE, Move::MOVE_NONE, Move::MOVE_NONE, Move::MOVE_NONE,
+            MovePicker movePicker(board, history, si, get_move_list(si), Move::MOVE_NONE, Move::MOVE_NONE, Move::MOVE_NONE, Move::MOVE_NONE,
                                   std::max(1, betaCut - static_eval));
             MOVE pbMove;
 
@@ -595,7 +724,7 @@ int Search::alpha_beta(Board& board, Timer& timer, int alpha, int beta, int dept
     //------------------------------------------------------------------------------------
     bool skipQuiets = false;
 
-    MovePicker movePicker(board, history, si, tt_move,
+    MovePicker movePicker(board, history, si, get_move_list(si), tt_move,
                           si->killer1, si->killer2, history.get_counter_move(si), 0);
 
     int  bound = BOUND_UPPER;
@@ -622,6 +751,11 @@ int Search::alpha_beta(Board& board, Timer& timer, int alpha, int beta, int dept
         if (move == si->excluded)
             continue;
 
+        // MultiPV : coup déjà en tête d'une ligne précédente ;
+        // "go searchmoves" : coup hors de la liste demandée
+        if (isRoot && is_root_excluded(move))
+            continue;
+
         const U64  starting_nodes = nodes;
         const bool isQuiet   = !Move::is_tactical(move);    // capture, promotion (avec capture ou non), prise en-passant
 
@@ -823,7 +957,8 @@ int Search::alpha_beta(Board& board, Timer& timer, int alpha, int beta, int dept
         undo_move<C, true>(board);
 
         // Suit où les nodes ont été dépensés dans la thread principale, à la racine
-        if (isRoot && index==0)
+        // (pour la première ligne seulement en MultiPV)
+        if (isRoot && index==0 && multipv_index == 0)
             timer.updateMoveNodes(move, nodes - starting_nodes);
 
         //  Time-out
@@ -873,7 +1008,12 @@ int Search::alpha_beta(Board& board, Timer& timer, int alpha, int beta, int dept
 
     best_score = std::min(best_score, max_score);
 
+    // En MultiPV (lignes suivantes) ou avec "go searchmoves", le résultat racine
+    // n'est pas celui de la position : ni correction, ni TT
+    const bool rootRestricted = isRoot && is_root_restricted();
+
     if(   !isInCheck
+          && !rootRestricted
           && (best_move == Move::MOVE_NONE || !Move::is_capturing(best_move))
           && !(bound == BOUND_LOWER && best_score <= si->static_eval)
           && !(bound == BOUND_UPPER && best_score >= si->static_eval))
@@ -881,7 +1021,7 @@ int Search::alpha_beta(Board& board, Timer& timer, int alpha, int beta, int dept
         history.update_correction_history(board, depth, best_score, si->static_eval );
     }
 
-    if (!is_stopped() && !isExcluded)
+    if (!is_stopped() && !isExcluded && !rootRestricted)
     {
         //  si on est ici, c'est que l'on a trouvé au moins 1 coup
         //  et de plus : score < beta